@@ -82,11 +82,12 @@ int Engine::InitDisplay(const int32_t cmd) {
   }
 
   // Enable culling OpenGL state
-  glEnable(GL_CULL_FACE);
+  ndk_helper::GLState *state = gl_context_->GetState();
+  state->Enable(GL_CULL_FACE);
 
   // Enabled depth test OpenGL state
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
+  state->Enable(GL_DEPTH_TEST);
+  state->DepthFunc(GL_LEQUAL);
 
   // Note that screen size might have been changed
   glViewport(0, 0, gl_context_->GetScreenWidth(),
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// benchmark.cpp
+// Machine readable result output
+//--------------------------------------------------------------------------------
+#include <stdarg.h>
+
+#include "benchmark.h"
+#include "vecmath_simd.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+#if defined(NDK_HELPER_SIMD_NEON)
+const char *SIMD_BACKEND = "neon";
+#elif defined(NDK_HELPER_SIMD_SSE)
+const char *SIMD_BACKEND = "sse";
+#else
+const char *SIMD_BACKEND = "scalar";
+#endif
+
+//Benchmark names are plain ASCII, only quotes and backslashes need escaping
+std::string EscapeJson(const std::string &str) {
+  std::string ret;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == '"' || str[i] == '\\')
+      ret += '\\';
+    ret += str[i];
+  }
+  return ret;
+}
+
+//Names contain commas, always quote them
+std::string EscapeCsv(const std::string &str) {
+  std::string ret = "\"";
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == '"')
+      ret += '"';
+    ret += str[i];
+  }
+  return ret + "\"";
+}
+
+} //namespace
+
+bool Runner::Check(const bool ok, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  printf("%s ", ok ? "check passed:" : "check FAILED:");
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+  if (!ok)
+    ++failures_;
+  return ok;
+}
+
+bool Runner::WriteJson(const char *file_name) const {
+  FILE *file = fopen(file_name, "w");
+  if (file == NULL) {
+    printf("Can not open a file:%s\n", file_name);
+    return false;
+  }
+
+  fprintf(file, "{\n  \"context\": {\n");
+  fprintf(file, "    \"simd\": \"%s\",\n", SIMD_BACKEND);
+  fprintf(file, "    \"compiler\": \"%s\",\n", EscapeJson(__VERSION__).c_str());
+  fprintf(file, "    \"min_time_ns\": %lld\n", (long long)MIN_TIME_NS);
+  fprintf(file, "  },\n  \"benchmarks\": [");
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const Result &result = results_[i];
+    fprintf(file, "%s\n    {\"name\": \"%s\", \"iterations\": %lld, "
+                  "\"ns_per_op\": %.3f, \"items_per_second\": %.1f",
+            i ? "," : "", EscapeJson(result.name).c_str(),
+            (long long)result.iterations, result.ns_per_op,
+            result.items_per_sec);
+    if (!result.counters.empty()) {
+      fprintf(file, ", \"counters\": {");
+      for (size_t j = 0; j < result.counters.size(); ++j) {
+        fprintf(file, "%s\"%s\": %.1f", j ? ", " : "",
+                EscapeJson(result.counters[j].name).c_str(),
+                result.counters[j].value);
+      }
+      fprintf(file, "}");
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+bool Runner::WriteCsv(const char *file_name) const {
+  FILE *file = fopen(file_name, "w");
+  if (file == NULL) {
+    printf("Can not open a file:%s\n", file_name);
+    return false;
+  }
+
+  //Counters go to one column as name=value pairs
+  fprintf(file, "name,iterations,ns_per_op,items_per_second,counters\n");
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const Result &result = results_[i];
+    std::string counters;
+    for (size_t j = 0; j < result.counters.size(); ++j) {
+      char value[32];
+      snprintf(value, sizeof(value), "=%.1f", result.counters[j].value);
+      counters += (j ? " " : "") + result.counters[j].name + value;
+    }
+    fprintf(file, "%s,%lld,%.3f,%.1f,%s\n", EscapeCsv(result.name).c_str(),
+            (long long)result.iterations, result.ns_per_op,
+            result.items_per_sec, EscapeCsv(counters).c_str());
+  }
+  return fclose(file) == 0;
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
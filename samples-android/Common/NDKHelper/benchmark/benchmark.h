@@ -0,0 +1,154 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+/******************************************************************
+ * Minimal micro benchmark harness for host builds
+ *
+ * Run() calls func(iterations) with a growing iteration count until one call
+ * takes at least MIN_TIME_NS, then reports the time per iteration.
+ * items_per_iteration is used to report a throughput for batch operations.
+ * Results are printed as a table and kept for WriteJson()/WriteCsv(), only
+ * benchmarks whose name contains the filter are run. SetCounter() attaches
+ * other per iteration measurements (e.g. GL calls per frame) to the last
+ * result.
+ * Check() records the correctness checks the benchmark groups make of the
+ * code they time. Checks run whatever the filter, a failed check makes the
+ * run exit with a non-zero code.
+ */
+
+//Keep value (and everything reachable from it) alive and opaque to the
+//optimizer
+template <class T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+//Force loop invariant inputs to be reloaded every iteration
+inline void ClobberMemory() { asm volatile("" : : : "memory"); }
+
+struct Counter {
+  std::string name;
+  double value;
+};
+
+struct Result {
+  std::string name;
+  int64_t iterations;
+  double ns_per_op;
+  double items_per_sec;
+  std::vector<Counter> counters;
+};
+
+class Runner {
+private:
+  static const int64_t MIN_TIME_NS = 100000000;
+
+  std::string filter_;
+  std::vector<Result> results_;
+  int32_t failures_;
+
+public:
+  explicit Runner(const char *filter = "") : filter_(filter), failures_(0) {
+    printf("%-48s %14s %12s %16s\n", "benchmark", "iterations", "ns/op",
+           "items/s");
+  }
+
+  //Returns false if the filter skipped the benchmark
+  template <class F>
+  bool Run(const char *name, const int64_t items_per_iteration, F func) {
+    if (std::string(name).find(filter_) == std::string::npos)
+      return false;
+
+    int64_t iterations = 1;
+    int64_t elapsed_ns = 0;
+    for (;;) {
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      func(iterations);
+      elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start).count();
+      if (elapsed_ns >= MIN_TIME_NS)
+        break;
+      iterations *= elapsed_ns < MIN_TIME_NS / 16 ? 8 : 2;
+    }
+
+    double ns_per_op = (double)elapsed_ns / iterations;
+    double items_per_sec = items_per_iteration * 1e9 / ns_per_op;
+    printf("%-48s %14lld %12.2f %16.0f\n", name, (long long)iterations,
+           ns_per_op, items_per_sec);
+
+    Result result = { name, iterations, ns_per_op, items_per_sec,
+                      std::vector<Counter>() };
+    results_.push_back(result);
+    return true;
+  }
+
+  template <class F>
+  bool Run(const char *name, F func) {
+    return Run(name, 1, func);
+  }
+
+  //Attaches a counter to the result of the last Run()
+  void SetCounter(const char *name, const double value) {
+    if (results_.empty())
+      return;
+    printf("    %-44s %14.0f\n", name, value);
+    Counter counter = { name, value };
+    results_.back().counters.push_back(counter);
+  }
+
+  //Prints the printf style message as passed or FAILED, returns ok
+  bool Check(const bool ok, const char *format, ...)
+      __attribute__((format(printf, 3, 4)));
+  int32_t GetNumFailures() const { return failures_; }
+
+  const std::vector<Result> &GetResults() const { return results_; }
+
+  //Both return false if the file can't be written
+  bool WriteJson(const char *file_name) const;
+  bool WriteCsv(const char *file_name) const;
+};
+
+/******************************************************************
+ * Benchmark groups, one per source file
+ */
+void RunVecmathBenchmarks(Runner &runner);
+void RunCullingBenchmarks(Runner &runner);
+void RunPackingBenchmarks(Runner &runner);
+void RunInterpolatorBenchmarks(Runner &runner);
+void RunTapCameraBenchmarks(Runner &runner);
+void RunTeapotBenchmarks(Runner &runner);
+void RunRenderQueueBenchmarks(Runner &runner);
+void RunShaderBenchmarks(Runner &runner);
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
+#endif /* BENCHMARK_H_ */
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// culling_benchmark.cpp
+//--------------------------------------------------------------------------------
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "culling.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+const int32_t NUM_BOXES = 100000;
+//Objects are scattered in a cube of this half size around the origin
+const float SCENE_HALF_SIZE = 1000.f;
+
+//Boxes and spheres touching a plane or with NaN centers, every path culls
+//them like IsVisible(): only a distance below 0 culls, -NaN doesn't
+void CheckEdgeCases(Runner &runner) {
+  //Identity clip space, planes x + 1 >= 0, -x + 1 >= 0, ...
+  Frustum frustum(Mat4::Identity());
+  const int32_t NUM_EDGE_BOXES = 8;
+  const float CENTER_X[] = { -1.f, -1.5f, -NAN, 0.f, NAN, -2.f, 1.f, 0.f };
+  const float CENTER_Y[] = { 0.f, 0.f, 0.f, -NAN, 0.f, 0.f, 0.f, 3.f };
+  const float CENTER_Z[] = { 0.f, 0.f, 0.f, 0.f, -NAN, 0.f, 0.f, 0.f };
+  const float EXTENT_X[] = { 0.f, 0.5f, 1.f, 1.f, 1.f, 0.5f, 0.f, 1.f };
+  const float EXTENT_Y[] = { 0.f, 0.f, 1.f, 1.f, 1.f, 0.5f, 0.f, 1.f };
+  const float EXTENT_Z[] = { 0.f, 0.f, 1.f, 1.f, 1.f, 0.5f, 0.f, 1.f };
+  const float RADIUS[] = { 0.f, 0.5f, 1.f, 1.f, 1.f, 0.5f, 0.f, 1.f };
+
+  std::vector<BoundingBox> boxes;
+  std::vector<BoundingSphere> spheres;
+  std::vector<int32_t> box_indices, sphere_indices;
+  for (int32_t i = 0; i < NUM_EDGE_BOXES; ++i) {
+    Vec3 center(CENTER_X[i], CENTER_Y[i], CENTER_Z[i]);
+    boxes.push_back(
+        BoundingBox(center, Vec3(EXTENT_X[i], EXTENT_Y[i], EXTENT_Z[i])));
+    spheres.push_back(BoundingSphere(center, RADIUS[i]));
+    if (frustum.IsVisible(boxes[i]))
+      box_indices.push_back(i);
+    if (frustum.IsVisible(spheres[i]))
+      sphere_indices.push_back(i);
+  }
+
+  std::vector<int32_t> visible(NUM_EDGE_BOXES);
+  auto same = [&](const std::vector<int32_t> &expected, const int32_t count) {
+    return count == (int32_t)expected.size() &&
+           std::equal(expected.begin(), expected.end(), visible.begin());
+  };
+  bool ok = same(box_indices, frustum.Cull(boxes.data(), NUM_EDGE_BOXES,
+                                           visible.data()));
+  ok = same(box_indices,
+            frustum.CullBoxes(CENTER_X, CENTER_Y, CENTER_Z, EXTENT_X,
+                              EXTENT_Y, EXTENT_Z, NUM_EDGE_BOXES,
+                              visible.data())) &&
+       ok;
+  ok = same(sphere_indices, frustum.Cull(spheres.data(), NUM_EDGE_BOXES,
+                                         visible.data())) &&
+       ok;
+  ok = same(sphere_indices,
+            frustum.CullSpheres(CENTER_X, CENTER_Y, CENTER_Z, RADIUS,
+                                NUM_EDGE_BOXES, visible.data())) &&
+       ok;
+  runner.Check(ok, "culling: %d boxes and %d spheres of %d on a plane or "
+                   "NaN visible, AoS and SoA agree with IsVisible()",
+               (int32_t)box_indices.size(), (int32_t)sphere_indices.size(),
+               NUM_EDGE_BOXES);
+}
+
+void RunFrustumBenchmarks(Runner &runner) {
+  //Camera at the scene center looking out, a few percent of the objects end
+  //up inside the frustum
+  Mat4 mat_projection = Mat4::Perspective(1.f, 1.f, 1.f, 2000.f);
+  Mat4 mat_view = Mat4::LookAt(Vec3(0.f, 0.f, 0.f), Vec3(0.3f, 0.2f, -1.f),
+                               Vec3(0.f, 1.f, 0.f));
+  Frustum frustum(mat_projection * mat_view);
+
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> position(-SCENE_HALF_SIZE,
+                                                 SCENE_HALF_SIZE);
+  std::uniform_real_distribution<float> size(1.f, 20.f);
+
+  std::vector<BoundingBox> boxes(NUM_BOXES);
+  std::vector<BoundingSphere> spheres(NUM_BOXES);
+  std::vector<float> center_x(NUM_BOXES), center_y(NUM_BOXES),
+      center_z(NUM_BOXES);
+  std::vector<float> extent_x(NUM_BOXES), extent_y(NUM_BOXES),
+      extent_z(NUM_BOXES), radius(NUM_BOXES);
+  for (int32_t i = 0; i < NUM_BOXES; ++i) {
+    center_x[i] = position(rng);
+    center_y[i] = position(rng);
+    center_z[i] = position(rng);
+    extent_x[i] = size(rng);
+    extent_y[i] = size(rng);
+    extent_z[i] = size(rng);
+    radius[i] = size(rng);
+    Vec3 center(center_x[i], center_y[i], center_z[i]);
+    boxes[i] = BoundingBox(center, Vec3(extent_x[i], extent_y[i], extent_z[i]));
+    spheres[i] = BoundingSphere(center, radius[i]);
+  }
+  std::vector<int32_t> visible(NUM_BOXES);
+
+  //All box paths must agree before their timings mean anything
+  int32_t num_scalar = 0;
+  for (int32_t i = 0; i < NUM_BOXES; ++i)
+    num_scalar += frustum.IsVisible(boxes[i]);
+  int32_t num_aos = frustum.Cull(boxes.data(), NUM_BOXES, visible.data());
+  int32_t num_soa = frustum.CullBoxes(
+      center_x.data(), center_y.data(), center_z.data(), extent_x.data(),
+      extent_y.data(), extent_z.data(), NUM_BOXES, visible.data());
+  runner.Check(num_scalar == num_aos && num_scalar == num_soa,
+               "culling: %d/%d/%d of %d boxes visible (scalar/AoS/SoA)",
+               num_scalar, num_aos, num_soa, NUM_BOXES);
+
+  runner.Run("Frustum::Set", [&](int64_t n) {
+    Mat4 clip = mat_projection * mat_view;
+    for (int64_t i = 0; i < n; ++i) {
+      DoNotOptimize(clip);
+      frustum.Set(clip);
+      DoNotOptimize(frustum);
+    }
+  });
+  runner.Run("Frustum::IsVisible(BoundingBox) 100k", NUM_BOXES,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      int32_t num_visible = 0;
+      for (int32_t j = 0; j < NUM_BOXES; ++j) {
+        visible[num_visible] = j;
+        num_visible += frustum.IsVisible(boxes[j]);
+      }
+      DoNotOptimize(num_visible);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Frustum::Cull(BoundingBox) 100k", NUM_BOXES, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      int32_t num_visible =
+          frustum.Cull(boxes.data(), NUM_BOXES, visible.data());
+      DoNotOptimize(num_visible);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Frustum::CullBoxes SoA 100k", NUM_BOXES, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      int32_t num_visible = frustum.CullBoxes(
+          center_x.data(), center_y.data(), center_z.data(), extent_x.data(),
+          extent_y.data(), extent_z.data(), NUM_BOXES, visible.data());
+      DoNotOptimize(num_visible);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Frustum::Cull(BoundingSphere) 100k", NUM_BOXES,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      int32_t num_visible =
+          frustum.Cull(spheres.data(), NUM_BOXES, visible.data());
+      DoNotOptimize(num_visible);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Frustum::CullSpheres SoA 100k", NUM_BOXES, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      int32_t num_visible =
+          frustum.CullSpheres(center_x.data(), center_y.data(),
+                              center_z.data(), radius.data(), NUM_BOXES,
+                              visible.data());
+      DoNotOptimize(num_visible);
+      ClobberMemory();
+    }
+  });
+}
+
+} //namespace
+
+void RunCullingBenchmarks(Runner &runner) {
+  CheckEdgeCases(runner);
+  RunFrustumBenchmarks(runner);
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
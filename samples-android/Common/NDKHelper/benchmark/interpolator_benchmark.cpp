@@ -0,0 +1,91 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// interpolator_benchmark.cpp
+//--------------------------------------------------------------------------------
+#include "benchmark.h"
+#include "interpolator.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+const INTERPOLATOR_TYPE INTERPOLATOR_TYPES[] = {
+  INTERPOLATOR_TYPE_LINEAR,        INTERPOLATOR_TYPE_EASEINQUAD,
+  INTERPOLATOR_TYPE_EASEOUTQUAD,   INTERPOLATOR_TYPE_EASEINOUTQUAD,
+  INTERPOLATOR_TYPE_EASEINCUBIC,   INTERPOLATOR_TYPE_EASEOUTCUBIC,
+  INTERPOLATOR_TYPE_EASEINOUTCUBIC, INTERPOLATOR_TYPE_EASEINQUART,
+  INTERPOLATOR_TYPE_EASEINEXPO,    INTERPOLATOR_TYPE_EASEOUTEXPO,
+};
+const int32_t NUM_TYPES =
+    sizeof(INTERPOLATOR_TYPES) / sizeof(INTERPOLATOR_TYPES[0]);
+
+//Updates per simulated animation
+const int32_t NUM_STEPS = 64;
+
+} //namespace
+
+void RunInterpolatorBenchmarks(Runner &runner) {
+  //Durations long enough that Update() never reaches the end, every call
+  //evaluates the easing formula
+  const double DURATION = 1e6;
+  Interpolator interpolators[NUM_TYPES];
+  for (int32_t i = 0; i < NUM_TYPES; ++i)
+    interpolators[i].Set(0.f, 1.f, INTERPOLATOR_TYPES[i], DURATION);
+  double start_time = PerfMonitor::GetCurrentTime();
+
+  runner.Run("Interpolator::Update all types", NUM_TYPES * NUM_STEPS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t step = 0; step < NUM_STEPS; ++step) {
+        double time = start_time + step * (DURATION / NUM_STEPS);
+        for (int32_t j = 0; j < NUM_TYPES; ++j) {
+          float value;
+          interpolators[j].Update(time, value);
+          DoNotOptimize(value);
+        }
+      }
+    }
+  });
+
+  //A queued animation as the samples use them: Set() plus Add() segments,
+  //run to the end
+  runner.Run("Interpolator::Set + Add(3) run to end", NUM_STEPS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Interpolator interpolator;
+      interpolator.Set(0.f, 1.f, INTERPOLATOR_TYPE_EASEOUTQUAD, 0.0)
+          .Add(2.f, INTERPOLATOR_TYPE_LINEAR, 0.0)
+          .Add(3.f, INTERPOLATOR_TYPE_EASEINOUTCUBIC, 0.0)
+          .Add(4.f, INTERPOLATOR_TYPE_EASEOUTEXPO, 0.0);
+      //Zero durations, every Update() past the start moves to the next
+      //segment until the queue is empty
+      double time = PerfMonitor::GetCurrentTime();
+      for (int32_t step = 0; step < NUM_STEPS; ++step) {
+        float value;
+        interpolator.Update(time, value);
+        DoNotOptimize(value);
+      }
+    }
+  });
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// main.cpp
+// Host side benchmark entry point
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include "benchmark.h"
+
+namespace {
+
+void PrintUsage(const char *name) {
+  printf("usage: %s [--filter=SUBSTRING] [--json=FILE] [--csv=FILE]\n", name);
+}
+
+} //namespace
+
+int main(int argc, char *argv[]) {
+  const char *filter = "";
+  const char *json_file = NULL;
+  const char *csv_file = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else if (strncmp(argv[i], "--json=", 7) == 0) {
+      json_file = argv[i] + 7;
+    } else if (strncmp(argv[i], "--csv=", 6) == 0) {
+      csv_file = argv[i] + 6;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  ndk_helper::benchmark::Runner runner(filter);
+  ndk_helper::benchmark::RunVecmathBenchmarks(runner);
+  ndk_helper::benchmark::RunCullingBenchmarks(runner);
+  ndk_helper::benchmark::RunPackingBenchmarks(runner);
+  ndk_helper::benchmark::RunInterpolatorBenchmarks(runner);
+  ndk_helper::benchmark::RunTapCameraBenchmarks(runner);
+  ndk_helper::benchmark::RunTeapotBenchmarks(runner);
+  ndk_helper::benchmark::RunRenderQueueBenchmarks(runner);
+  ndk_helper::benchmark::RunShaderBenchmarks(runner);
+
+  if (json_file && !runner.WriteJson(json_file))
+    return 1;
+  if (csv_file && !runner.WriteCsv(csv_file))
+    return 1;
+  if (runner.GetNumFailures()) {
+    printf("%d checks FAILED\n", runner.GetNumFailures());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// packing_benchmark.cpp
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "vecmath_packing.h"
+#include "vecmath_simd.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+//Roughly the vertex count of a detailed mesh
+const int32_t NUM_VERTICES = 65536;
+
+//Angular error bounds of the octahedral encodings, see vecmath_packing.h
+const float OCTAHEDRAL_SNORM16_DEGREES = 0.004f;
+const float OCTAHEDRAL_SNORM8_DEGREES = 1.f;
+//The ARMv7 NEON projection may round to the neighbouring snorm value
+#if defined(NDK_HELPER_SIMD_NEON) && !defined(__aarch64__)
+const int32_t MAX_OCTAHEDRAL_DIFFERENCE = 1;
+#else
+const int32_t MAX_OCTAHEDRAL_DIFFERENCE = 0;
+#endif
+
+//Every finite half must survive a round trip through float
+void CheckHalfRoundTrip(Runner &runner) {
+  int32_t num_errors = 0;
+  for (int32_t h = 0; h < 0x10000; ++h) {
+    if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff))
+      continue; //NaN
+    if (packing::FloatToHalf(packing::HalfToFloat((uint16_t)h)) != h)
+      ++num_errors;
+  }
+  runner.Check(num_errors == 0, "packing: half round trip, %d errors",
+               num_errors);
+}
+
+template <class T>
+int32_t CountDifferences(const std::vector<T> &a, const std::vector<T> &b) {
+  int32_t num_differences = 0;
+  for (size_t i = 0; i < a.size(); ++i)
+    num_differences += a[i] != b[i];
+  return num_differences;
+}
+
+template <class T>
+int32_t MaxDifference(const std::vector<T> &a, const std::vector<T> &b) {
+  int32_t max_difference = 0;
+  for (size_t i = 0; i < a.size(); ++i)
+    max_difference = std::max(max_difference, abs((int32_t)a[i] - b[i]));
+  return max_difference;
+}
+
+float MaxAngleError(const std::vector<float> &normals,
+                    const std::vector<float> &decoded) {
+  //asin(|a x b|) in double, float acos(a . b) can't resolve angles this small
+  double max_error = 0.0;
+  for (size_t i = 0; i < normals.size(); i += 3) {
+    double x = (double)normals[i + 1] * decoded[i + 2] -
+               (double)normals[i + 2] * decoded[i + 1];
+    double y = (double)normals[i + 2] * decoded[i] -
+               (double)normals[i] * decoded[i + 2];
+    double z = (double)normals[i] * decoded[i + 1] -
+               (double)normals[i + 1] * decoded[i];
+    max_error = fmax(max_error, asin(fmin(sqrt(x * x + y * y + z * z), 1.0)));
+  }
+  return (float)(max_error * 180.0 / M_PI);
+}
+
+void RunPackingBenchmarks(Runner &runner, const int32_t count) {
+  std::mt19937 rng(1234);
+  //A bit outside the snorm range to exercise the clamping
+  std::uniform_real_distribution<float> value(-1.1f, 1.1f);
+  std::normal_distribution<float> direction;
+
+  std::vector<float> values(count * 3);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = value(rng) * (i % 7 == 0 ? 1e5f : 1.f);
+  std::vector<float> normals(count * 3);
+  for (int32_t i = 0; i < count; ++i) {
+    float x = direction(rng), y = direction(rng), z = direction(rng);
+    float inv_len = 1.f / sqrtf(x * x + y * y + z * z);
+    normals[i * 3] = x * inv_len;
+    normals[i * 3 + 1] = y * inv_len;
+    normals[i * 3 + 2] = z * inv_len;
+  }
+
+  //Batch and single value versions must agree before their timings mean
+  //anything. Only the backend of this build is compared, a host build on
+  //x86 checks the SSE2 and scalar code but never the NEON paths
+  std::vector<uint16_t> halves(values.size()), halves_ref(values.size());
+  std::vector<int16_t> snorm16(values.size()), snorm16_ref(values.size());
+  std::vector<int8_t> snorm8(values.size()), snorm8_ref(values.size());
+  packing::FloatToHalf(values.data(), halves.data(), (int32_t)values.size());
+  packing::FloatToSnorm16(values.data(), snorm16.data(),
+                          (int32_t)values.size());
+  packing::FloatToSnorm8(values.data(), snorm8.data(), (int32_t)values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    halves_ref[i] = packing::FloatToHalf(values[i]);
+    snorm16_ref[i] = packing::FloatToSnorm16(values[i]);
+    snorm8_ref[i] = packing::FloatToSnorm8(values[i]);
+  }
+  int32_t half_differences = CountDifferences(halves, halves_ref);
+  int32_t snorm16_differences = CountDifferences(snorm16, snorm16_ref);
+  int32_t snorm8_differences = CountDifferences(snorm8, snorm8_ref);
+  runner.Check(half_differences == 0 && snorm16_differences == 0 &&
+                   snorm8_differences == 0,
+               "packing: batch vs single differences half %d snorm16 %d "
+               "snorm8 %d", half_differences, snorm16_differences,
+               snorm8_differences);
+
+  std::vector<int16_t> oct16(count * 2), oct16_ref(count * 2);
+  std::vector<int8_t> oct8(count * 2), oct8_ref(count * 2);
+  std::vector<float> decoded16(count * 3), decoded8(count * 3);
+  packing::EncodeOctahedralSnorm16(normals.data(), oct16.data(), count);
+  packing::EncodeOctahedralSnorm8(normals.data(), oct8.data(), count);
+  for (int32_t i = 0; i < count; ++i) {
+    float encoded[2];
+    packing::EncodeOctahedral(&normals[i * 3], encoded);
+    oct16_ref[i * 2] = packing::FloatToSnorm16(encoded[0]);
+    oct16_ref[i * 2 + 1] = packing::FloatToSnorm16(encoded[1]);
+    oct8_ref[i * 2] = packing::FloatToSnorm8(encoded[0]);
+    oct8_ref[i * 2 + 1] = packing::FloatToSnorm8(encoded[1]);
+
+    float e16[2] = { packing::Snorm16ToFloat(oct16[i * 2]),
+                     packing::Snorm16ToFloat(oct16[i * 2 + 1]) };
+    float e8[2] = { packing::Snorm8ToFloat(oct8[i * 2]),
+                    packing::Snorm8ToFloat(oct8[i * 2 + 1]) };
+    packing::DecodeOctahedral(e16, &decoded16[i * 3]);
+    packing::DecodeOctahedral(e8, &decoded8[i * 3]);
+  }
+  int32_t oct16_difference = MaxDifference(oct16, oct16_ref);
+  int32_t oct8_difference = MaxDifference(oct8, oct8_ref);
+  runner.Check(oct16_difference <= MAX_OCTAHEDRAL_DIFFERENCE &&
+                   oct8_difference <= MAX_OCTAHEDRAL_DIFFERENCE,
+               "packing: octahedral batch vs single max difference snorm16 "
+               "%d snorm8 %d", oct16_difference, oct8_difference);
+  float oct16_error = MaxAngleError(normals, decoded16);
+  float oct8_error = MaxAngleError(normals, decoded8);
+  runner.Check(oct16_error <= OCTAHEDRAL_SNORM16_DEGREES &&
+                   oct8_error <= OCTAHEDRAL_SNORM8_DEGREES,
+               "packing: octahedral max error %.5f/%.3f degrees (bounds "
+               "%.3f/%.0f)", oct16_error, oct8_error,
+               OCTAHEDRAL_SNORM16_DEGREES, OCTAHEDRAL_SNORM8_DEGREES);
+
+  //Timings, count xyz triplets per call
+  runner.Run("packing::FloatToHalf single 64k vec3", count, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < values.size(); ++j)
+        halves[j] = packing::FloatToHalf(values[j]);
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::FloatToHalf batch 64k vec3", count, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      packing::FloatToHalf(values.data(), halves.data(),
+                           (int32_t)values.size());
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::FloatToSnorm16 single 64k vec3", count,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < values.size(); ++j)
+        snorm16[j] = packing::FloatToSnorm16(values[j]);
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::FloatToSnorm16 batch 64k vec3", count, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      packing::FloatToSnorm16(values.data(), snorm16.data(),
+                              (int32_t)values.size());
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::FloatToSnorm8 batch 64k vec3", count, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      packing::FloatToSnorm8(values.data(), snorm8.data(),
+                             (int32_t)values.size());
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::EncodeOctahedral single 64k", count, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < count; ++j) {
+        float encoded[2];
+        packing::EncodeOctahedral(&normals[j * 3], encoded);
+        oct16[j * 2] = packing::FloatToSnorm16(encoded[0]);
+        oct16[j * 2 + 1] = packing::FloatToSnorm16(encoded[1]);
+      }
+      ClobberMemory();
+    }
+  });
+  runner.Run("packing::EncodeOctahedralSnorm16 batch 64k", count,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      packing::EncodeOctahedralSnorm16(normals.data(), oct16.data(), count);
+      ClobberMemory();
+    }
+  });
+}
+
+} //namespace
+
+void RunPackingBenchmarks(Runner &runner) {
+  CheckHalfRoundTrip(runner);
+  RunPackingBenchmarks(runner, NUM_VERTICES);
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// renderqueue_benchmark.cpp
+// A scene of objects with mixed programs, materials and meshes on the
+// recording GL backend, drawn in submission order and sorted by RenderQueue.
+// The counters show the state changes sorting saves, the GL calls are
+// recorded, not rendered.
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "glRecorder.h"
+#include "RenderQueue.h"
+#include "vecmath.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+const int32_t NUM_PROGRAMS = 4;
+const int32_t NUM_MATERIALS = 32;
+//The last materials of the scene blend
+const int32_t NUM_TRANSPARENT_MATERIALS = 4;
+const int32_t NUM_MESHES = 8;
+const int32_t NUM_OBJECTS = 2000;
+const int32_t NUM_SORT_KEYS = 20000;
+
+//Same locations in all programs, the recorder hands out any
+const GLint DIFFUSE_LOCATION = 0;
+const GLint MODEL_LOCATION = 1;
+
+struct SceneMaterial {
+  RenderMaterial material;
+  int32_t id;
+  float diffuse[4];
+};
+
+struct SceneObject {
+  uint64_t key;
+  RenderPacket packet;
+  Mat4 model;
+};
+
+//Order Execute() reaches the objects in, when tracing
+std::vector<const void *> *g_trace = NULL;
+
+void ApplyMaterial(GLState *state, const void *data) {
+  const float *diffuse = (const float *)data;
+  state->Uniform4f(DIFFUSE_LOCATION, diffuse[0], diffuse[1], diffuse[2],
+                   diffuse[3]);
+}
+
+void ApplyObject(GLState *state, const void *data) {
+  if (g_trace)
+    g_trace->push_back(data);
+  SceneObject *object = (SceneObject *)data;
+  state->UniformMatrix4fv(MODEL_LOCATION, object->model.Ptr());
+}
+
+struct Scene {
+  std::vector<GLuint> programs;
+  std::vector<SceneMaterial> materials;
+  std::vector<GLuint> meshes;
+  std::vector<SceneObject> objects;
+
+  void Init(GLState *state) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    for (int32_t i = 0; i < NUM_PROGRAMS; ++i)
+      programs.push_back(glCreateProgram());
+
+    materials.resize(NUM_MATERIALS);
+    for (int32_t i = 0; i < NUM_MATERIALS; ++i) {
+      SceneMaterial &material = materials[i];
+      bool transparent = i >= NUM_MATERIALS - NUM_TRANSPARENT_MATERIALS;
+      material.id = i;
+      for (int32_t j = 0; j < 4; ++j)
+        material.diffuse[j] = unit(rng);
+      RenderMaterial render_material = { programs[i % NUM_PROGRAMS],
+                                         transparent,
+                                         GL_SRC_ALPHA,
+                                         GL_ONE_MINUS_SRC_ALPHA,
+                                         !transparent,
+                                         !transparent,
+                                         ApplyMaterial,
+                                         material.diffuse };
+      material.material = render_material;
+    }
+
+    for (int32_t i = 0; i < NUM_MESHES; ++i)
+      meshes.push_back(state->GenVertexArray());
+
+    //Objects come in the order a scene graph would walk them, unrelated to
+    //their materials
+    std::uniform_int_distribution<int32_t> material_index(0,
+                                                          NUM_MATERIALS - 1);
+    std::uniform_int_distribution<int32_t> mesh_index(0, NUM_MESHES - 1);
+    objects.resize(NUM_OBJECTS);
+    for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+      SceneObject &object = objects[i];
+      const SceneMaterial &material = materials[material_index(rng)];
+      float depth = 1.f + unit(rng) * 100.f;
+      object.model = Mat4::Translation(unit(rng), unit(rng), -depth);
+
+      RenderPacket packet = { &material.material,
+                              meshes[mesh_index(rng)],
+                              GL_TRIANGLES,
+                              3072,
+                              GL_UNSIGNED_SHORT,
+                              0,
+                              1,
+                              ApplyObject,
+                              &object };
+      object.packet = packet;
+      object.key = RenderQueue::MakeKey(
+          material.material.blend ? RENDER_PASS_TRANSPARENT
+                                  : RENDER_PASS_OPAQUE,
+          material.material.program, material.id, depth);
+    }
+  }
+
+  void Submit(RenderQueue *queue) const {
+    queue->Clear();
+    for (size_t i = 0; i < objects.size(); ++i)
+      queue->Submit(objects[i].key, objects[i].packet);
+  }
+};
+
+//Sorted execution must reach the objects in std::stable_sort order
+bool CheckOrder(const Scene &scene, RenderQueue *queue, GLState *state) {
+  std::vector<std::pair<uint64_t, int32_t> > expected;
+  for (int32_t i = 0; i < NUM_OBJECTS; ++i)
+    expected.push_back(std::make_pair(scene.objects[i].key, i));
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const std::pair<uint64_t, int32_t> &a,
+                      const std::pair<uint64_t, int32_t> &b) {
+    return a.first < b.first;
+  });
+
+  std::vector<const void *> trace;
+  g_trace = &trace;
+  scene.Submit(queue);
+  queue->Sort();
+  queue->Execute(state);
+  g_trace = NULL;
+
+  if (trace.size() != expected.size())
+    return false;
+  for (size_t i = 0; i < trace.size(); ++i)
+    if (trace[i] != &scene.objects[expected[i].second])
+      return false;
+  return true;
+}
+
+void SetCounters(Runner &runner, GLRecorder &recorder, GLState &state,
+                 const RenderQueue &queue) {
+  GLStatistics statistics = recorder.GetStatistics();
+  const RenderQueueCounters &counters = queue.GetCounters();
+  runner.SetCounter("gl_calls", statistics.calls);
+  runner.SetCounter("state_calls", statistics.calls_by_category[GL_CALL_STATE]);
+  runner.SetCounter("draw_calls", statistics.calls_by_category[GL_CALL_DRAW]);
+  runner.SetCounter("program_changes", counters.program_changes);
+  runner.SetCounter("material_changes", counters.material_changes);
+  runner.SetCounter("vertex_array_changes", counters.vertex_array_changes);
+  runner.SetCounter("state_cache_skipped", state.GetCounters().skipped);
+}
+
+void RunSceneBenchmarks(Runner &runner) {
+  GLRecorder recorder;
+  recorder.Install();
+  GLState state;
+  state.SetVertexArraySupport(true);
+
+  Scene scene;
+  scene.Init(&state);
+  RenderQueue queue;
+
+  runner.Check(CheckOrder(scene, &queue, &state),
+               "render queue: draw order matches std::stable_sort");
+
+  bool ran = runner.Run("RenderQueue scene 2000 draws submission order",
+                        NUM_OBJECTS, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      recorder.Clear();
+      scene.Submit(&queue);
+      queue.Execute(&state);
+    }
+  });
+  if (ran) {
+    recorder.Clear();
+    state.ResetCounters();
+    scene.Submit(&queue);
+    queue.Execute(&state);
+    SetCounters(runner, recorder, state, queue);
+  }
+
+  ran = runner.Run("RenderQueue scene 2000 draws sorted", NUM_OBJECTS,
+                   [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      recorder.Clear();
+      scene.Submit(&queue);
+      queue.Sort();
+      queue.Execute(&state);
+    }
+  });
+  if (ran) {
+    recorder.Clear();
+    state.ResetCounters();
+    scene.Submit(&queue);
+    queue.Sort();
+    queue.Execute(&state);
+    SetCounters(runner, recorder, state, queue);
+  }
+}
+
+void RunSortBenchmarks(Runner &runner) {
+  std::mt19937_64 rng(1234);
+  std::vector<uint64_t> keys(NUM_SORT_KEYS);
+  for (int32_t i = 0; i < NUM_SORT_KEYS; ++i)
+    keys[i] = rng();
+  RenderPacket packet;
+  memset(&packet, 0, sizeof(packet));
+
+  RenderQueue queue;
+  runner.Run("RenderQueue Submit+Sort 20k keys", NUM_SORT_KEYS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      queue.Clear();
+      for (int32_t j = 0; j < NUM_SORT_KEYS; ++j)
+        queue.Submit(keys[j], packet);
+      queue.Sort();
+      ClobberMemory();
+    }
+  });
+
+  //Same keys and packets through std::stable_sort
+  std::vector<std::pair<uint64_t, uint32_t> > entries;
+  std::vector<RenderPacket> packets;
+  runner.Run("std::stable_sort 20k keys", NUM_SORT_KEYS, [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      entries.clear();
+      packets.clear();
+      for (int32_t j = 0; j < NUM_SORT_KEYS; ++j) {
+        entries.push_back(std::make_pair(keys[j], (uint32_t)j));
+        packets.push_back(packet);
+      }
+      std::stable_sort(entries.begin(), entries.end(),
+                       [](const std::pair<uint64_t, uint32_t> &a,
+                          const std::pair<uint64_t, uint32_t> &b) {
+        return a.first < b.first;
+      });
+      ClobberMemory();
+    }
+  });
+}
+
+} //namespace
+
+void RunRenderQueueBenchmarks(Runner &runner) {
+  RunSceneBenchmarks(runner);
+  RunSortBenchmarks(runner);
+}
+
+} //namespace benchmark
+
+} //namespace ndk_helper
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// shader_benchmark.cpp
+// ShaderPreprocessor on the Teapot sample's ES3 vertex shader: reading and
+// preprocessing a variant, and the memoized variant of a later load
+//--------------------------------------------------------------------------------
+#include <unistd.h>
+
+#include <string>
+
+#include "benchmark.h"
+#include "shaderPreprocessor.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+const char *const VERTEX_SHADER = "Shaders/VS_ShaderPlainES3.vsh";
+
+//The instanced, octahedral normal variant, plus a define the shader doesn't
+//have
+ShaderDefines MakeDefines() {
+  ShaderDefines defines;
+  defines["OCTAHEDRAL_NORMAL"] = "(1)";
+  defines["INSTANCING"] = "(1)";
+  defines["MAX_LIGHTS"] = "(4)";
+  return defines;
+}
+
+bool Contains(const std::string &source, const char *str) {
+  return source.find(str) != std::string::npos;
+}
+
+//Defines replaced in place or added after #version, the include expanded
+bool CheckVariant(const std::string &source) {
+  const std::string header = "#version 300 es\n#define MAX_LIGHTS (4)\n";
+  return source.compare(0, header.size(), header) == 0 &&
+         Contains(source, "\n#define OCTAHEDRAL_NORMAL (1)\n") &&
+         Contains(source, "\n#define INSTANCING (1)\n") &&
+         !Contains(source, "INSTANCING (0)") &&
+         !Contains(source, "#include") &&
+         Contains(source, "uniform FrameConstants");
+}
+
+} //namespace
+
+void RunShaderBenchmarks(Runner &runner) {
+  //Shaders are loaded relative to the working directory
+  char cwd[4096];
+  if (getcwd(cwd, sizeof(cwd)) == NULL || chdir(TEAPOT_ASSETS_DIR) != 0) {
+    printf("Can not open a directory:%s\n", TEAPOT_ASSETS_DIR);
+    return;
+  }
+
+  ShaderPreprocessor *preprocessor = ShaderPreprocessor::GetInstance();
+  ShaderDefines defines = MakeDefines();
+  std::string source;
+
+  preprocessor->Clear();
+  runner.Check(preprocessor->Preprocess(VERTEX_SHADER, defines, &source) &&
+                   CheckVariant(source),
+               "shader preprocessor: %s variant", VERTEX_SHADER);
+
+  runner.Run("ShaderPreprocessor VS_ShaderPlainES3 3 defines", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      preprocessor->Clear();
+      preprocessor->Preprocess(VERTEX_SHADER, defines, &source);
+      DoNotOptimize(source);
+    }
+  });
+
+  preprocessor->ResetCounters();
+  bool ran = runner.Run("ShaderPreprocessor VS_ShaderPlainES3 memoized",
+                        [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      preprocessor->Preprocess(VERTEX_SHADER, defines, &source);
+      DoNotOptimize(source);
+    }
+  });
+  if (ran) {
+    ShaderPreprocessorCounters counters = preprocessor->GetCounters();
+    runner.SetCounter("preprocessed", counters.preprocessed);
+    runner.SetCounter("source_bytes", (double)source.size());
+  }
+  preprocessor->Clear();
+
+  if (chdir(cwd) != 0)
+    printf("Can not open a directory:%s\n", cwd);
+}
+
+} //namespace benchmark
+
+} //namespace ndk_helper
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// tapcamera_benchmark.cpp
+//--------------------------------------------------------------------------------
+#include "benchmark.h"
+#include "tapCamera.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+//60Hz frames, same step as the momentum update in TapCamera::Update()
+const double FRAME_TIME = 1.0 / 60.0;
+//Frames per simulated gesture
+const int32_t NUM_FRAMES = 64;
+
+} //namespace
+
+void RunTapCameraBenchmarks(Runner &runner) {
+  TapCamera camera;
+  camera.SetFlip(1.f, -1.f, -1.f);
+
+  runner.Run("TapCamera::Update idle", [&](int64_t n) {
+    double time = 0.0;
+    for (int64_t i = 0; i < n; ++i) {
+      camera.Update(time);
+      DoNotOptimize(camera.GetRotationMatrix());
+      time += FRAME_TIME;
+    }
+  });
+
+  //Drag across the screen, then let the momentum play out
+  runner.Run("TapCamera drag + momentum", NUM_FRAMES * 2, [&](int64_t n) {
+    double time = 0.0;
+    for (int64_t i = 0; i < n; ++i) {
+      camera.Reset(false);
+      camera.BeginDrag(Vec2(-0.5f, 0.f));
+      for (int32_t frame = 0; frame < NUM_FRAMES; ++frame) {
+        camera.Drag(Vec2(-0.5f + frame * (1.f / NUM_FRAMES), frame * 0.005f));
+        camera.Update(time);
+        time += FRAME_TIME;
+      }
+      camera.EndDrag();
+      for (int32_t frame = 0; frame < NUM_FRAMES; ++frame) {
+        camera.Update(time);
+        time += FRAME_TIME;
+      }
+      DoNotOptimize(camera.GetRotationMatrix());
+    }
+  });
+
+  runner.Run("TapCamera pinch", NUM_FRAMES, [&](int64_t n) {
+    double time = 0.0;
+    for (int64_t i = 0; i < n; ++i) {
+      camera.Reset(false);
+      camera.BeginPinch(Vec2(-0.2f, 0.f), Vec2(0.2f, 0.f));
+      for (int32_t frame = 0; frame < NUM_FRAMES; ++frame) {
+        float spread = 0.2f + frame * 0.005f;
+        camera.Pinch(Vec2(-spread, frame * 0.002f),
+                     Vec2(spread, -frame * 0.002f));
+        camera.Update(time);
+        time += FRAME_TIME;
+      }
+      camera.EndPinch();
+      DoNotOptimize(camera.GetTransformMatrix());
+    }
+  });
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
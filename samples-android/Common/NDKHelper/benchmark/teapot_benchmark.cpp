@@ -0,0 +1,460 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// teapot_benchmark.cpp
+// Teapot sample frames, Engine::DrawFrame() without the UI:
+// - on the recording GL backend: CPU time per frame, including recording, and
+//   the GL command stream of one frame
+// - on the system GL driver (e.g. Mesa llvmpipe) in a headless context: time
+//   per rendered frame, skipped when no driver can be loaded
+// "pipelined" cases simulate the next frame on a worker thread while the
+// current one is submitted, as the Teapot sample does on multi core devices
+// "Init" cases load the ES3 teapot as InitDisplay() does, compiling its
+// shaders or loading them from the program binary cache, until the program is
+// ready. "ShaderLibrary" and "Uniform lookup" cases build the teapot variants
+// and compare location lookups by name and by enum
+//--------------------------------------------------------------------------------
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "benchmark.h"
+#include "fixedTimestep.h"
+#include "framePipeline.h"
+#include "glDriver.h"
+#include "glRecorder.h"
+#include "perfMonitor.h"
+#include "ProgramCache.h"
+#include "ShaderLibrary.h"
+#include "tapCamera.h"
+#include "TeapotRenderer.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+//60Hz frames
+const double FRAME_TIME = 1.0 / 60.0;
+
+const int32_t SURFACE_WIDTH = 1280;
+const int32_t SURFACE_HEIGHT = 720;
+
+//TeapotRenderer::IsReady() polls of 1 ms before giving up on the shaders
+const int32_t MAX_READY_POLLS = 10000;
+
+//The ES2 teapot program, as TeapotRenderer declares it
+const char *const SHADER_OPTIONS[] = { "OCTAHEDRAL_NORMAL", "INSTANCING" };
+const int32_t NUM_SHADER_VARIANTS = 1 << 2;
+const ProgramAttribute SHADER_ATTRIBUTES[] = { { 0, "myVertex" },
+                                               { 1, "myNormal" } };
+const char *const SHADER_UNIFORMS[] = { "uPMatrix", "uMVMatrix", "vLight0",
+                                        "vMaterialDiffuse", "vMaterialAmbient",
+                                        "vMaterialSpecular" };
+const int32_t NUM_SHADER_UNIFORMS =
+    sizeof(SHADER_UNIFORMS) / sizeof(SHADER_UNIFORMS[0]);
+const ShaderProgramDesc SHADER_PROGRAM = {
+  "Shaders/VS_ShaderPlain.vsh", "Shaders/ShaderPlain.fsh",
+  SHADER_OPTIONS, 2,
+  SHADER_ATTRIBUTES, 2,
+  SHADER_UNIFORMS, NUM_SHADER_UNIFORMS,
+  NULL, 0
+};
+
+struct TeapotCase {
+  const char *name;
+  const char *gl_version; //Recorder only, drivers report their own
+  TEAPOT_VERTEX_LAYOUT layout;
+  int32_t num_instances;
+  bool instancing; //ES3 stress mode, otherwise a draw per teapot
+  bool pipelined;
+};
+
+//Frames of state in the pipelined cases, the sample's NUM_FRAME_SLOTS
+const int32_t NUM_FRAME_SLOTS = 2;
+
+const TeapotCase RECORDER_CASES[] = {
+  { "TeapotRenderer frame ES3 1 teapot", "OpenGL ES 3.0 GLRecorder",
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1, true, false },
+  { "TeapotRenderer frame ES3 1000 teapots", "OpenGL ES 3.0 GLRecorder",
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1000, true, false },
+  { "TeapotRenderer frame ES3 1000 teapots per draw",
+    "OpenGL ES 3.0 GLRecorder", TEAPOT_VERTEX_LAYOUT_PACKED, 1000, false,
+    false },
+  { "TeapotRenderer frame ES2 1 teapot", "OpenGL ES 2.0 GLRecorder",
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1, true, false },
+  { "TeapotRenderer frame ES2 1000 teapots", "OpenGL ES 2.0 GLRecorder",
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1000, true, false },
+  { "TeapotRenderer frame ES2 1000 teapots pipelined",
+    "OpenGL ES 2.0 GLRecorder", TEAPOT_VERTEX_LAYOUT_PACKED, 1000, true,
+    true },
+};
+
+const TeapotCase DRIVER_CASES[] = {
+  { "Teapot DrawFrame driver 1 teapot", NULL, TEAPOT_VERTEX_LAYOUT_PACKED, 1,
+    true, false },
+  { "Teapot DrawFrame driver 1000 teapots", NULL, TEAPOT_VERTEX_LAYOUT_PACKED,
+    1000, true, false },
+  { "Teapot DrawFrame driver 1000 teapots per draw", NULL,
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1000, false, false },
+  { "Teapot DrawFrame driver 1000 teapots pipelined", NULL,
+    TEAPOT_VERTEX_LAYOUT_PACKED, 1000, true, true },
+};
+
+//Polls like a loading screen would, false if the shaders don't build
+bool WaitReady(TeapotRenderer *renderer) {
+  for (int32_t i = 0; i < MAX_READY_POLLS; ++i) {
+    if (renderer->IsReady())
+      return true;
+    usleep(1000);
+  }
+  return false;
+}
+
+/******************************************************************
+ * The Teapot sample's Engine on a headless GLContext, same steps as
+ * Engine::LoadResources(), InitDisplay() and DrawFrame()
+ */
+struct TeapotEngine {
+  GLContext *context;
+  TeapotRenderer renderer;
+  TapCamera camera;
+  PerfMonitor monitor;
+  double time;
+  bool finish; //Wait for the GPU at the end of each frame
+  FixedTimestep timestep; //60Hz, one step per frame
+  FramePipeline pipeline;
+  TEAPOT_FRAME frames[NUM_FRAME_SLOTS];
+
+  TeapotEngine(GLContext *gl_context, const bool finish_frames)
+      : context(gl_context), time(0.0), finish(finish_frames) {}
+
+  void InitDisplay(const TeapotCase &teapot_case) {
+    renderer.Init(teapot_case.layout, teapot_case.num_instances,
+                  teapot_case.instancing);
+    renderer.Bind(&camera);
+    //Frames are timed with the teapots drawn, not the loading screen
+    if (!WaitReady(&renderer))
+      printf("%s: shaders failed\n", teapot_case.name);
+
+    GLState *state = context->GetState();
+    state->Enable(GL_CULL_FACE);
+    state->Enable(GL_DEPTH_TEST);
+    state->DepthFunc(GL_LEQUAL);
+
+    glViewport(0, 0, context->GetScreenWidth(), context->GetScreenHeight());
+    renderer.UpdateViewport();
+
+    camera.SetFlip(1.f, -1.f, -1.f);
+    camera.SetPinchTransformFactor(2.f, 2.f, 8.f);
+
+    if (teapot_case.pipelined)
+      pipeline.Start(NUM_FRAME_SLOTS,
+                     [this](int32_t slot) { Simulate(&frames[slot]); });
+  }
+
+  //Frames advance a fixed time so runs are repeatable
+  void StepSimulation() {
+    time += FRAME_TIME;
+    int32_t steps = timestep.Advance(time);
+    for (int32_t i = 0; i < steps; ++i)
+      renderer.Update(timestep.GetStepTime(i));
+    renderer.Interpolate(timestep.GetAlpha());
+  }
+
+  void Simulate(TEAPOT_FRAME *frame) {
+    StepSimulation();
+    renderer.Prepare(frame);
+  }
+
+  void DrawFrame() {
+    float fps;
+    monitor.Update(fps);
+
+    glClearColor(0.5f, 0.5f, 0.5f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (pipeline.IsRunning()) {
+      int32_t slot = pipeline.AcquireFrame();
+      renderer.Submit(frames[slot]);
+      pipeline.ReleaseFrame(slot);
+    } else {
+      StepSimulation();
+      renderer.Render();
+    }
+
+    context->Swap();
+    if (finish)
+      glFinish();
+  }
+
+  void TermDisplay() {
+    pipeline.Stop();
+    renderer.Unload();
+    context->Invalidate();
+  }
+};
+
+//ShaderLibrary on the driver: building every variant of the teapot program,
+//and the uniform lookups of a frame through glGetUniformLocation() against
+//the library's location table
+void RunShaderLibraryCases(Runner &runner, GLContext *context) {
+  if (!context->InitHeadless(SURFACE_WIDTH, SURFACE_HEIGHT)) {
+    context->Invalidate();
+    return;
+  }
+
+  //Builds every variant, false if one of them failed
+  ShaderLibrary library;
+  ShaderHandle handles[NUM_SHADER_VARIANTS];
+  auto build = [&]() {
+    library.Init(context->GetState(), NULL,
+                 context->IsParallelShaderCompileSupported());
+    int32_t program = library.AddProgram(SHADER_PROGRAM);
+    for (int32_t j = 0; j < NUM_SHADER_VARIANTS; ++j)
+      handles[j] = library.Request(program, j);
+    while (library.GetNumReady() < NUM_SHADER_VARIANTS) {
+    }
+    bool ready = true;
+    for (int32_t j = 0; j < NUM_SHADER_VARIANTS; ++j)
+      ready = library.GetStatus(handles[j]) == PROGRAM_READY && ready;
+    return ready;
+  };
+
+  runner.Check(build(), "ShaderLibrary teapot: all variants built");
+  runner.Run("ShaderLibrary teapot 4 variants driver", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      bool ready = build();
+      DoNotOptimize(ready);
+    }
+  });
+
+  //The library of the last build stays loaded
+  GLuint program = library.GetProgram(handles[0]);
+  bool same = true;
+  for (int32_t i = 0; i < NUM_SHADER_UNIFORMS; ++i)
+    same = glGetUniformLocation(program, SHADER_UNIFORMS[i]) ==
+               library.GetUniform(handles[0], i) &&
+           same;
+  runner.Check(same, "ShaderLibrary teapot: uniform locations match "
+                     "glGetUniformLocation");
+
+  runner.Run("Uniform lookup glGetUniformLocation 6 names", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_SHADER_UNIFORMS; ++j) {
+        GLint location = glGetUniformLocation(program, SHADER_UNIFORMS[j]);
+        DoNotOptimize(location);
+      }
+    }
+  });
+  runner.Run("Uniform lookup ShaderLibrary 6 enums", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_SHADER_UNIFORMS; ++j) {
+        GLint location = library.GetUniform(handles[0], j);
+        DoNotOptimize(location);
+      }
+    }
+  });
+
+  library.Unload();
+  context->Invalidate();
+}
+
+//TeapotRenderer::Init() with the shaders compiled, then with the program
+//cache in a temporary directory. The context dispatches to backend
+void RunInitCases(Runner &runner, GLContext *context, const char *backend,
+                  const bool finish) {
+  char directory[] = "/tmp/ndkhelper_program_cache_XXXXXX";
+  if (mkdtemp(directory) == NULL) {
+    printf("Can not create a directory:%s\n", directory);
+    return;
+  }
+
+  ProgramCache *cache = context->GetProgramCache();
+  for (int32_t cached = 0; cached < 2; ++cached) {
+    //The cache is disabled on host without a directory
+    cache->SetDirectory(cached ? directory : NULL);
+    if (!context->InitHeadless(SURFACE_WIDTH, SURFACE_HEIGHT)) {
+      context->Invalidate();
+      break;
+    }
+    if (cached && !cache->IsEnabled()) {
+      printf("TeapotRenderer Init %s: no program binary support, skipped\n",
+             backend);
+      context->Invalidate();
+      break;
+    }
+
+    //The first Init() fills the cache. Shaders build asynchronously, a case
+    //lasts until the program is ready
+    TeapotRenderer renderer;
+    renderer.Init(TEAPOT_VERTEX_LAYOUT_PACKED, 1);
+    bool ready = WaitReady(&renderer);
+    renderer.Unload();
+    if (!ready) {
+      printf("TeapotRenderer Init %s: shaders failed, skipped\n", backend);
+      context->Invalidate();
+      break;
+    }
+    cache->ResetCounters();
+
+    std::string name = std::string("TeapotRenderer Init ") + backend +
+                       (cached ? " program cache" : " compile");
+    bool ran = runner.Run(name.c_str(), [&](int64_t n) {
+      for (int64_t i = 0; i < n; ++i) {
+        renderer.Init(TEAPOT_VERTEX_LAYOUT_PACKED, 1);
+        while (!renderer.IsReady()) {
+        }
+        renderer.Unload();
+        if (finish)
+          glFinish();
+      }
+    });
+    if (ran) {
+      const ProgramCacheCounters &counters = cache->GetCounters();
+      uint32_t loads = counters.hits + counters.misses + counters.rejected;
+      runner.SetCounter("cache_hit_rate",
+                        loads ? (double)counters.hits / loads : 0.0);
+      runner.SetCounter("parallel_compile",
+                        context->IsParallelShaderCompileSupported());
+    }
+    context->Invalidate();
+  }
+
+  cache->Clear();
+  cache->SetDirectory(NULL);
+  unlink((std::string(directory) + "/driver").c_str());
+  rmdir(directory);
+}
+
+void RunRecorderCases(Runner &runner) {
+  GLRecorder recorder;
+  recorder.SetSurfaceSize(SURFACE_WIDTH, SURFACE_HEIGHT);
+  recorder.Install();
+  GLContext *context = GLContext::GetInstance();
+
+  for (size_t i = 0; i < sizeof(RECORDER_CASES) / sizeof(RECORDER_CASES[0]);
+       ++i) {
+    const TeapotCase &teapot_case = RECORDER_CASES[i];
+    recorder.SetVersion(teapot_case.gl_version);
+    context->InitHeadless(SURFACE_WIDTH, SURFACE_HEIGHT);
+
+    TeapotEngine engine(context, false);
+    engine.InitDisplay(teapot_case);
+
+    //The first frame fills the GL state cache
+    engine.DrawFrame();
+
+    bool ran = runner.Run(teapot_case.name, [&](int64_t n) {
+      for (int64_t j = 0; j < n; ++j) {
+        recorder.Clear();
+        engine.DrawFrame();
+      }
+    });
+
+    if (ran) {
+      recorder.Clear();
+      context->GetState()->ResetCounters();
+      engine.DrawFrame();
+
+      GLStatistics statistics = recorder.GetStatistics();
+      const GLStateCounters &counters = context->GetState()->GetCounters();
+      runner.SetCounter("gl_calls", statistics.calls);
+      runner.SetCounter("state_calls",
+                        statistics.calls_by_category[GL_CALL_STATE]);
+      runner.SetCounter("draw_calls",
+                        statistics.calls_by_category[GL_CALL_DRAW]);
+      runner.SetCounter("query_calls",
+                        statistics.calls_by_category[GL_CALL_QUERY]);
+      runner.SetCounter("upload_bytes", (double)statistics.upload_bytes);
+      runner.SetCounter("uniform_bytes", (double)statistics.uniform_bytes);
+      runner.SetCounter("ubo_uploads", statistics.uniform_buffer_uploads);
+      runner.SetCounter("ubo_binds", statistics.uniform_buffer_binds);
+      runner.SetCounter("triangles", engine.renderer.GetNumTriangles());
+      runner.SetCounter("state_cache_skipped", counters.skipped);
+    }
+
+    engine.TermDisplay();
+  }
+
+  recorder.SetVersion("OpenGL ES 3.0 GLRecorder");
+  RunInitCases(runner, context, "ES3 recorder", false);
+}
+
+void RunDriverCases(Runner &runner) {
+  GLDriver driver;
+  if (!driver.Load()) {
+    printf("Teapot DrawFrame: no GL driver, skipped\n");
+    return;
+  }
+  driver.Install();
+  GLContext *context = GLContext::GetInstance();
+
+  for (size_t i = 0; i < sizeof(DRIVER_CASES) / sizeof(DRIVER_CASES[0]); ++i) {
+    const TeapotCase &teapot_case = DRIVER_CASES[i];
+    if (!context->InitHeadless(SURFACE_WIDTH, SURFACE_HEIGHT)) {
+      printf("Teapot DrawFrame: no headless EGL context, skipped\n");
+      context->Invalidate();
+      return;
+    }
+    if (i == 0)
+      printf("Teapot DrawFrame: %s, %s\n", glGetString(GL_RENDERER),
+             glGetString(GL_VERSION));
+
+    TeapotEngine engine(context, true);
+    engine.InitDisplay(teapot_case);
+    engine.DrawFrame();
+
+    bool ran = runner.Run(teapot_case.name, [&](int64_t n) {
+      for (int64_t j = 0; j < n; ++j)
+        engine.DrawFrame();
+    });
+
+    if (ran) {
+      runner.SetCounter("triangles", engine.renderer.GetNumTriangles());
+      runner.SetCounter("gl_version", context->GetGLVersion());
+    }
+
+    engine.TermDisplay();
+  }
+
+  RunShaderLibraryCases(runner, context);
+  RunInitCases(runner, context, "driver", true);
+}
+
+} //namespace
+
+void RunTeapotBenchmarks(Runner &runner) {
+  //Meshes and shaders are loaded relative to the working directory
+  char cwd[4096];
+  if (getcwd(cwd, sizeof(cwd)) == NULL || chdir(TEAPOT_ASSETS_DIR) != 0) {
+    printf("Can not open a directory:%s\n", TEAPOT_ASSETS_DIR);
+    return;
+  }
+
+  //One backend at a time, each removes itself when it goes out of scope
+  RunRecorderCases(runner);
+  RunDriverCases(runner);
+
+  if (chdir(cwd) != 0)
+    printf("Can not open a directory:%s\n", cwd);
+}
+
+} //namespace benchmark
+
+} //namespace ndk_helper
@@ -0,0 +1,788 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmath_benchmark.cpp
+//--------------------------------------------------------------------------------
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "vecmath.h"
+#include "vecmath_simd.h"
+
+namespace ndk_helper {
+
+namespace benchmark {
+
+namespace {
+
+//Rigid transforms similar to the ones TapCamera produces
+const Quaternion ROTATION_A(0.2f, 0.4f, 0.1f, 0.8888194f);
+const Quaternion ROTATION_B(-0.3f, 0.1f, 0.5f, 0.8062258f);
+const Vec3 TRANSLATION_A(1.f, -2.f, -15.f);
+const Vec3 TRANSLATION_B(0.f, 0.f, -700.f);
+
+//SIMD products accumulate in the order of the reference kernels and neither
+//side contracts to a multiply-add, so they must match bit for bit
+const int64_t MAX_PRODUCT_ULP = 0;
+const int32_t NUM_PRODUCT_CHECKS = 10000;
+
+//Operands one in four elements of which is an edge case. ARMv7 NEON flushes
+//denormals to zero while its scalar VFP code doesn't, no denormals there
+const float EDGE_VALUES[] = {
+  0.f, -0.f, 1.f, -1.f, INFINITY, -INFINITY, 1e30f, -3e37f, FLT_MAX,
+#if !defined(NDK_HELPER_SIMD_NEON) || defined(__aarch64__)
+  1e-40f, -3e-39f, FLT_MIN * 0.5f,
+#endif
+};
+const int32_t NUM_EDGE_VALUES = sizeof(EDGE_VALUES) / sizeof(EDGE_VALUES[0]);
+
+//Random sign, mantissa and exponent in [2^-30, 2^31)
+float RandomOperand(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> mantissa(1.f, 2.f);
+  std::uniform_int_distribution<int32_t> exponent(-30, 30);
+  std::uniform_int_distribution<int32_t> pick(0, 4 * NUM_EDGE_VALUES - 1);
+  int32_t edge = pick(rng);
+  if (edge < NUM_EDGE_VALUES)
+    return EDGE_VALUES[edge];
+  float f = ldexpf(mantissa(rng), exponent(rng));
+  return rng() & 1 ? -f : f;
+}
+
+//Distance of a and b in representable floats, NaNs only match NaNs
+int64_t UlpDistance(const float a, const float b) {
+  if (isnan(a) || isnan(b))
+    return isnan(a) && isnan(b) ? 0 : INT64_MAX;
+  int32_t bits[2];
+  memcpy(&bits[0], &a, sizeof(float));
+  memcpy(&bits[1], &b, sizeof(float));
+  int64_t ordered[2];
+  for (int32_t i = 0; i < 2; ++i)
+    ordered[i] = bits[i] < 0 ? -(int64_t)(bits[i] & 0x7fffffff) : bits[i];
+  return ordered[0] > ordered[1] ? ordered[0] - ordered[1]
+                                 : ordered[1] - ordered[0];
+}
+
+int64_t MaxUlpDistance(const float *a, const float *b, const int32_t count) {
+  int64_t ret = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    int64_t distance = UlpDistance(a[i], b[i]);
+    if (distance > ret)
+      ret = distance;
+  }
+  return ret;
+}
+
+//Mat4/Vec4 products against the scalar reference kernels
+void CheckProducts(Runner &runner) {
+  std::mt19937 rng(4321);
+  int64_t mat_mat = 0, mat_chain = 0, mat_vec = 0, vec_mat = 0;
+  for (int32_t i = 0; i < NUM_PRODUCT_CHECKS; ++i) {
+    float a[16], b[16], c[16], v[4];
+    for (int32_t j = 0; j < 16; ++j) {
+      a[j] = RandomOperand(rng);
+      b[j] = RandomOperand(rng);
+      c[j] = RandomOperand(rng);
+    }
+    for (int32_t j = 0; j < 4; ++j)
+      v[j] = RandomOperand(rng);
+    Mat4 mat_a(a), mat_b(b), mat_c(c);
+    Vec4 vec(v[0], v[1], v[2], v[3]);
+
+    float ab[16], abc[16], out[4];
+    reference::MultiplyMat4(a, b, ab);
+    reference::MultiplyMat4(ab, c, abc);
+    Mat4 r = mat_a * mat_b;
+    mat_mat = std::max(mat_mat, MaxUlpDistance(r.Ptr(), ab, 16));
+    Mat4::Multiply(r, mat_a, mat_b, mat_c);
+    mat_chain = std::max(mat_chain, MaxUlpDistance(r.Ptr(), abc, 16));
+
+    float vec_out[4];
+    reference::MultiplyMat4Vec4(a, v, out);
+    (mat_a * vec).Value(vec_out[0], vec_out[1], vec_out[2], vec_out[3]);
+    mat_vec = std::max(mat_vec, MaxUlpDistance(vec_out, out, 4));
+    reference::MultiplyVec4Mat4(v, a, out);
+    (vec * mat_a).Value(vec_out[0], vec_out[1], vec_out[2], vec_out[3]);
+    vec_mat = std::max(vec_mat, MaxUlpDistance(vec_out, out, 4));
+  }
+  runner.Check(mat_mat <= MAX_PRODUCT_ULP,
+               "Mat4 * Mat4 vs reference, max %lld ulp", (long long)mat_mat);
+  runner.Check(mat_chain <= MAX_PRODUCT_ULP,
+               "Mat4::Multiply(out, a, b, c) vs reference, max %lld ulp",
+               (long long)mat_chain);
+  runner.Check(mat_vec <= MAX_PRODUCT_ULP,
+               "Mat4 * Vec4 vs reference, max %lld ulp", (long long)mat_vec);
+  runner.Check(vec_mat <= MAX_PRODUCT_ULP,
+               "Vec4 * Mat4 vs reference, max %lld ulp", (long long)vec_mat);
+}
+
+enum TRANSFORM_MODE {
+  TRANSFORM_POINT,
+  TRANSFORM_DIRECTION,
+  TRANSFORM_PROJECT,
+  TRANSFORM_MODE_COUNT,
+};
+
+const char *const TRANSFORM_NAMES[] = { "TransformPoints",
+                                        "TransformDirections",
+                                        "TransformAndProject" };
+
+void TransformAoS(const Mat4 &mat, const TRANSFORM_MODE mode, const Vec3 *in,
+                  Vec3 *out, const int32_t count) {
+  if (mode == TRANSFORM_POINT)
+    mat.TransformPoints(in, out, count);
+  else if (mode == TRANSFORM_DIRECTION)
+    mat.TransformDirections(in, out, count);
+  else
+    mat.TransformAndProject(in, out, count);
+}
+
+void TransformSoA(const Mat4 &mat, const TRANSFORM_MODE mode, const float *in,
+                  float *out, const int32_t count) {
+  const float *in_y = in + count, *in_z = in + 2 * count;
+  float *out_y = out + count, *out_z = out + 2 * count;
+  if (mode == TRANSFORM_POINT)
+    mat.TransformPoints(in, in_y, in_z, out, out_y, out_z, count);
+  else if (mode == TRANSFORM_DIRECTION)
+    mat.TransformDirections(in, in_y, in_z, out, out_y, out_z, count);
+  else
+    mat.TransformAndProject(in, in_y, in_z, out, out_y, out_z, count);
+}
+
+//Batch transforms against Mat4 * Vec4 per element, the projection divided
+//with the same simd::Div. Odd counts take the scalar tail of the SoA loop,
+//in place runs pass the same array as in and out
+void CheckTransforms(Runner &runner) {
+  const int32_t COUNTS[] = { 1, 3, 4, 5, 7, 1001 };
+  std::mt19937 rng(5678);
+  int64_t aos[TRANSFORM_MODE_COUNT] = {}, soa[TRANSFORM_MODE_COUNT] = {};
+  int64_t aos4 = 0;
+  for (size_t c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); ++c) {
+    const int32_t count = COUNTS[c];
+    float m[16];
+    for (int32_t j = 0; j < 16; ++j)
+      m[j] = RandomOperand(rng);
+    //Mat4 * Vec4 multiplies the translation of a direction by 0, which is
+    //NaN for an infinite one
+    for (int32_t j = 12; j < 15; ++j)
+      while (!isfinite(m[j]))
+        m[j] = RandomOperand(rng);
+    const Mat4 mat(m);
+
+    //xyz triples, and the x, y and z streams
+    std::vector<float> in(count * 3), in_soa(count * 3);
+    for (int32_t i = 0; i < count; ++i) {
+      for (int32_t j = 0; j < 3; ++j) {
+        in[i * 3 + j] = RandomOperand(rng);
+        in_soa[j * count + i] = in[i * 3 + j];
+      }
+    }
+
+    for (int32_t mode = 0; mode < TRANSFORM_MODE_COUNT; ++mode) {
+      std::vector<float> expected(count * 3), expected_soa(count * 3);
+      for (int32_t i = 0; i < count; ++i) {
+        const float *p = &in[i * 3];
+        float r[4];
+        (mat * Vec4(p[0], p[1], p[2], mode == TRANSFORM_DIRECTION ? 0.f : 1.f))
+            .Value(r[0], r[1], r[2], r[3]);
+        if (mode == TRANSFORM_PROJECT)
+          simd::Store(r, simd::Div(simd::Load(r), simd::Splat(r[3])));
+        for (int32_t j = 0; j < 3; ++j) {
+          expected[i * 3 + j] = r[j];
+          expected_soa[j * count + i] = r[j];
+        }
+      }
+
+      for (int32_t in_place = 0; in_place < 2; ++in_place) {
+        std::vector<Vec3> vec_in(count), vec_out(count);
+        for (int32_t i = 0; i < count; ++i)
+          vec_in[i] = Vec3(&in[i * 3]);
+        if (in_place) {
+          vec_out = vec_in;
+          TransformAoS(mat, (TRANSFORM_MODE)mode, vec_out.data(),
+                       vec_out.data(), count);
+        } else {
+          TransformAoS(mat, (TRANSFORM_MODE)mode, vec_in.data(),
+                       vec_out.data(), count);
+        }
+        std::vector<float> out(count * 3);
+        for (int32_t i = 0; i < count; ++i)
+          vec_out[i].Value(out[i * 3], out[i * 3 + 1], out[i * 3 + 2]);
+        aos[mode] = std::max(aos[mode], MaxUlpDistance(out.data(),
+                                                       expected.data(),
+                                                       count * 3));
+
+        std::vector<float> out_soa(count * 3);
+        if (in_place) {
+          out_soa = in_soa;
+          TransformSoA(mat, (TRANSFORM_MODE)mode, out_soa.data(),
+                       out_soa.data(), count);
+        } else {
+          TransformSoA(mat, (TRANSFORM_MODE)mode, in_soa.data(),
+                       out_soa.data(), count);
+        }
+        soa[mode] = std::max(soa[mode], MaxUlpDistance(out_soa.data(),
+                                                       expected_soa.data(),
+                                                       count * 3));
+      }
+    }
+
+    //Vec4 points keep their w
+    std::vector<Vec4> vec4_in(count), vec4_out(count);
+    std::vector<float> expected4(count * 4), out4(count * 4);
+    for (int32_t i = 0; i < count; ++i) {
+      vec4_in[i] = Vec4(in[i * 3], in[i * 3 + 1], in[i * 3 + 2],
+                        RandomOperand(rng));
+      float *e = &expected4[i * 4];
+      (mat * vec4_in[i]).Value(e[0], e[1], e[2], e[3]);
+    }
+    for (int32_t in_place = 0; in_place < 2; ++in_place) {
+      if (in_place) {
+        vec4_out = vec4_in;
+        mat.TransformPoints(vec4_out.data(), vec4_out.data(), count);
+      } else {
+        mat.TransformPoints(vec4_in.data(), vec4_out.data(), count);
+      }
+      for (int32_t i = 0; i < count; ++i)
+        vec4_out[i].Value(out4[i * 4], out4[i * 4 + 1], out4[i * 4 + 2],
+                          out4[i * 4 + 3]);
+      aos4 = std::max(aos4, MaxUlpDistance(out4.data(), expected4.data(),
+                                           count * 4));
+    }
+  }
+
+  for (int32_t mode = 0; mode < TRANSFORM_MODE_COUNT; ++mode)
+    runner.Check(aos[mode] <= MAX_PRODUCT_ULP && soa[mode] <= MAX_PRODUCT_ULP,
+                 "Mat4::%s Vec3/SoA vs Mat4 * Vec4, max %lld/%lld ulp",
+                 TRANSFORM_NAMES[mode], (long long)aos[mode],
+                 (long long)soa[mode]);
+  runner.Check(aos4 <= MAX_PRODUCT_ULP,
+               "Mat4::TransformPoints Vec4 vs Mat4 * Vec4, max %lld ulp",
+               (long long)aos4);
+}
+
+void RunVectorBenchmarks(Runner &runner) {
+  Vec3 vec_a(1.f, 2.f, 3.f);
+  Vec3 vec_b(-0.5f, 0.25f, 4.f);
+  Quaternion quat_a = ROTATION_A;
+  Quaternion quat_b = ROTATION_B;
+  Mat4 mat = Mat4::Perspective(1.f, 1.f, 5.f, 10000.f);
+  DoNotOptimize(vec_a);
+  DoNotOptimize(vec_b);
+  DoNotOptimize(quat_a);
+  DoNotOptimize(quat_b);
+  DoNotOptimize(mat);
+
+  runner.Run("Vec3::Normalize", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Vec3 r = vec_a;
+      r.Normalize();
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Vec3::Cross + Vec3::Dot", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      float r = vec_a.Cross(vec_b).Dot(vec_a);
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Quaternion::operator*(Quaternion)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Quaternion r = quat_a * quat_b;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Quaternion::ToMatrix", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r;
+      quat_a.ToMatrix(r);
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Mat4::LookAt", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r = Mat4::LookAt(vec_a, vec_b, Vec3(0.f, 1.f, 0.f));
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Mat4::Transpose", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r = mat.Transpose();
+      DoNotOptimize(r);
+    }
+  });
+}
+
+void RunAffineBenchmarks(Runner &runner) {
+  AffineTransform affine_a(ROTATION_A, TRANSLATION_A);
+  AffineTransform affine_b(ROTATION_B, TRANSLATION_B);
+  Mat4 mat_a = affine_a.ToMat4();
+  Mat4 mat_b = affine_b.ToMat4();
+  Vec3 point(1.f, 2.f, 3.f);
+  Vec4 point4(point, 1.f);
+  DoNotOptimize(affine_a);
+  DoNotOptimize(affine_b);
+  DoNotOptimize(mat_a);
+  DoNotOptimize(mat_b);
+  DoNotOptimize(point);
+  DoNotOptimize(point4);
+
+  runner.Run("Mat4::operator*(Mat4)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r = mat_a * mat_b;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("AffineTransform::operator*(AffineTransform)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      AffineTransform r = affine_a * affine_b;
+      DoNotOptimize(r);
+    }
+  });
+
+  runner.Run("Mat4::Inverse", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r = mat_a;
+      r.Inverse();
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("AffineTransform::Inverse", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      AffineTransform r = affine_a;
+      r.Inverse();
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("AffineTransform::InverseOrthonormal", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      AffineTransform r = affine_a;
+      r.InverseOrthonormal();
+      DoNotOptimize(r);
+    }
+  });
+
+  runner.Run("Mat4::operator*(Vec4)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Vec4 r = mat_a * point4;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("AffineTransform::operator*(Vec3)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Vec3 r = affine_a * point;
+      DoNotOptimize(r);
+    }
+  });
+
+  runner.Run("Quaternion::ToMatrix + Mat4::Translation", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Quaternion q = ROTATION_A;
+      Mat4 r;
+      q.ToMatrix(r);
+      r = Mat4::Translation(TRANSLATION_A) * r;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("AffineTransform(Quaternion, Vec3)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      AffineTransform r(ROTATION_A, TRANSLATION_A);
+      DoNotOptimize(r);
+    }
+  });
+}
+
+//The per frame chains of TeapotRenderer::Update() and Render()
+void RunProductChainBenchmarks(Runner &runner) {
+  Mat4 mat_transform = Mat4::Translation(0.5f, -0.25f, 0.f);
+  Mat4 mat_view = Mat4::Translation(0.f, 0.f, -700.f);
+  Mat4 mat_rotation = AffineTransform(ROTATION_A, Vec3()).ToMat4();
+  Mat4 mat_model = Mat4::RotationX(1.0471976f) * Mat4::Translation(0, 0, -15.f);
+  Mat4 mat_projection = Mat4::Perspective(1.5f, 1.f, 5.f, 10000.f);
+  DoNotOptimize(mat_transform);
+  DoNotOptimize(mat_view);
+  DoNotOptimize(mat_rotation);
+  DoNotOptimize(mat_model);
+  DoNotOptimize(mat_projection);
+
+  runner.Run("Mat4 chain a * b * c * d (operator*)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r = mat_transform * mat_view * mat_rotation * mat_model;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Mat4::Multiply(out, a, b, c, d)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 r(MAT4_UNINITIALIZED);
+      Mat4::Multiply(r, mat_transform, mat_view, mat_rotation, mat_model);
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("Mat4 update + projection (operator*)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 mv = mat_transform * mat_view * mat_rotation * mat_model;
+      Mat4 vp = mat_projection * mv;
+      DoNotOptimize(mv);
+      DoNotOptimize(vp);
+    }
+  });
+  runner.Run("Mat4 update + projection (Multiply)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Mat4 mv(MAT4_UNINITIALIZED);
+      Mat4 vp(MAT4_UNINITIALIZED);
+      Mat4::Multiply(mv, mat_transform, mat_view, mat_rotation, mat_model);
+      Mat4::Multiply(vp, mat_projection, mv);
+      DoNotOptimize(mv);
+      DoNotOptimize(vp);
+    }
+  });
+}
+
+//Points of a 1000 vertex mesh through a model-view-projection matrix, per
+//element with operator* against the batch transforms
+const int32_t NUM_POINTS = 1000;
+
+void RunTransformBenchmarks(Runner &runner) {
+  std::mt19937 rng(2468);
+  std::uniform_real_distribution<float> coordinate(-1.f, 1.f);
+  std::vector<Vec3> points(NUM_POINTS), out(NUM_POINTS);
+  std::vector<Vec4> points4(NUM_POINTS), out4(NUM_POINTS);
+  std::vector<float> x(NUM_POINTS), y(NUM_POINTS), z(NUM_POINTS);
+  std::vector<float> out_x(NUM_POINTS), out_y(NUM_POINTS), out_z(NUM_POINTS);
+  for (int32_t i = 0; i < NUM_POINTS; ++i) {
+    x[i] = coordinate(rng);
+    y[i] = coordinate(rng);
+    z[i] = coordinate(rng);
+    points[i] = Vec3(x[i], y[i], z[i]);
+    points4[i] = Vec4(points[i], 1.f);
+  }
+  Quaternion rotation = ROTATION_A;
+  Mat4 model;
+  rotation.ToMatrix(model);
+  Mat4 mvp = Mat4::Perspective(1.f, 1.5f, 1.f, 1000.f) *
+             Mat4::Translation(TRANSLATION_A) * model;
+  DoNotOptimize(mvp);
+
+  runner.Run("Mat4::TransformPoints x1000 (operator*)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_POINTS; ++j)
+        out4[j] = mvp * points4[j];
+      ClobberMemory();
+    }
+  });
+  runner.Run("Mat4::TransformPoints x1000 (Vec3)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      mvp.TransformPoints(points.data(), out.data(), NUM_POINTS);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Mat4::TransformPoints x1000 (Vec4)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      mvp.TransformPoints(points4.data(), out4.data(), NUM_POINTS);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Mat4::TransformPoints x1000 (SoA)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      mvp.TransformPoints(x.data(), y.data(), z.data(), out_x.data(),
+                          out_y.data(), out_z.data(), NUM_POINTS);
+      ClobberMemory();
+    }
+  });
+
+  runner.Run("Mat4::TransformAndProject x1000 (operator*)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_POINTS; ++j) {
+        float rx, ry, rz, rw;
+        (mvp * points4[j]).Value(rx, ry, rz, rw);
+        out[j] = Vec3(rx / rw, ry / rw, rz / rw);
+      }
+      ClobberMemory();
+    }
+  });
+  runner.Run("Mat4::TransformAndProject x1000 (Vec3)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      mvp.TransformAndProject(points.data(), out.data(), NUM_POINTS);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Mat4::TransformAndProject x1000 (SoA)", NUM_POINTS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      mvp.TransformAndProject(x.data(), y.data(), z.data(), out_x.data(),
+                              out_y.data(), out_z.data(), NUM_POINTS);
+      ClobberMemory();
+    }
+  });
+}
+
+const int32_t NUM_QUATERNIONS = 1000;
+
+Quaternion RandomRotation(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+  std::uniform_real_distribution<float> axis(-1.f, 1.f);
+  Vec3 vec_axis(axis(rng), axis(rng), axis(rng));
+  return Quaternion::RotationAxis(vec_axis.Normalize(), angle(rng));
+}
+
+//Batch against single interpolation, the batch Slerp() approximates acos and
+//sin (see vecmath.h)
+const float QUATERNION_EPSILON = 1e-6f;
+//Slerp() nlerps above this cosine (see vecmath.cpp), both sides are checked
+//against a double precision slerp
+const float SLERP_NLERP_THRESHOLD = 0.9995f;
+const float SLERP_EPSILON = 2e-6f;
+//Transformed points, relative to the size of the translation
+const float DUAL_QUATERNION_EPSILON = 1e-5f;
+
+float MaxDifference(Quaternion a, Quaternion b) {
+  float a_v[4], b_v[4];
+  a.Value(a_v[0], a_v[1], a_v[2], a_v[3]);
+  b.Value(b_v[0], b_v[1], b_v[2], b_v[3]);
+  float ret = 0.f;
+  for (int32_t i = 0; i < 4; ++i)
+    ret = fmaxf(ret, fabsf(a_v[i] - b_v[i]));
+  return ret;
+}
+
+float MaxDifference(const Vec3 &a, const Vec3 &b) {
+  Vec3 d = a - b;
+  float d_v[3];
+  d.Value(d_v[0], d_v[1], d_v[2]);
+  return fmaxf(fabsf(d_v[0]), fmaxf(fabsf(d_v[1]), fabsf(d_v[2])));
+}
+
+//Slerp of unit quaternions in double precision
+Quaternion SlerpDouble(Quaternion from, Quaternion to, const float t) {
+  float a[4], b[4];
+  from.Value(a[0], a[1], a[2], a[3]);
+  to.Value(b[0], b[1], b[2], b[3]);
+  double dot = 0.0;
+  for (int32_t i = 0; i < 4; ++i)
+    dot += (double)a[i] * b[i];
+  double sign = dot < 0.0 ? -1.0 : 1.0;
+  double theta = acos(fmin(dot * sign, 1.0));
+  double s0 = 1.0 - t, s1 = t * sign;
+  if (theta > 0.0) {
+    s0 = sin((1.0 - t) * theta) / sin(theta);
+    s1 = sin(t * theta) / sin(theta) * sign;
+  }
+  float r[4];
+  for (int32_t i = 0; i < 4; ++i)
+    r[i] = (float)(a[i] * s0 + b[i] * s1);
+  return Quaternion(r);
+}
+
+//Batch Slerp()/Nlerp() against the single value versions, random pairs and
+//pairs on both sides of the nlerp threshold
+void CheckInterpolation(Runner &runner, const std::vector<Quaternion> &from,
+                        const std::vector<Quaternion> &to,
+                        const std::vector<float> &t) {
+  std::vector<Quaternion> out(from.size());
+  const int32_t count = (int32_t)from.size();
+  Quaternion::Slerp(from.data(), to.data(), t.data(), out.data(), count);
+  float slerp_error = 0.f;
+  for (int32_t i = 0; i < count; ++i) {
+    Quaternion single = Quaternion::Slerp(from[i], to[i], t[i]);
+    slerp_error = fmaxf(slerp_error, MaxDifference(out[i], single));
+  }
+  Quaternion::Nlerp(from.data(), to.data(), t.data(), out.data(), count);
+  float nlerp_error = 0.f;
+  for (int32_t i = 0; i < count; ++i) {
+    Quaternion single = Quaternion::Nlerp(from[i], to[i], t[i]);
+    nlerp_error = fmaxf(nlerp_error, MaxDifference(out[i], single));
+  }
+  runner.Check(slerp_error <= QUATERNION_EPSILON,
+               "Quaternion::Slerp batch vs single, max error %g",
+               slerp_error);
+  runner.Check(nlerp_error <= QUATERNION_EPSILON,
+               "Quaternion::Nlerp batch vs single, max error %g",
+               nlerp_error);
+
+  //Pairs whose cosine is just below and just above the threshold, from
+  //and from * r are apart by the angle of r
+  const float cosines[2] = { SLERP_NLERP_THRESHOLD - 1e-4f,
+                             SLERP_NLERP_THRESHOLD + 1e-4f };
+  for (int32_t side = 0; side < 2; ++side) {
+    std::vector<Quaternion> near_to(count);
+    for (int32_t i = 0; i < count; ++i) {
+      Vec3 axis(1.f, (float)(i % 7) - 3.f, (float)(i % 5) - 2.f);
+      near_to[i] = from[i] *
+                   Quaternion::RotationAxis(axis.Normalize(),
+                                            2.f * acosf(cosines[side]));
+    }
+    Quaternion::Slerp(from.data(), near_to.data(), t.data(), out.data(),
+                      count);
+    float batch_error = 0.f, single_error = 0.f;
+    for (int32_t i = 0; i < count; ++i) {
+      Quaternion single = Quaternion::Slerp(from[i], near_to[i], t[i]);
+      batch_error = fmaxf(batch_error, MaxDifference(out[i], single));
+      single_error = fmaxf(
+          single_error,
+          MaxDifference(single, SlerpDouble(from[i], near_to[i], t[i])));
+    }
+    const char *name = side ? "above" : "below";
+    runner.Check(batch_error <= QUATERNION_EPSILON,
+                 "Quaternion::Slerp batch vs single %s the nlerp threshold, "
+                 "max error %g", name, batch_error);
+    runner.Check(single_error <= SLERP_EPSILON,
+                 "Quaternion::Slerp vs double precision %s the nlerp "
+                 "threshold, max error %g", name, single_error);
+  }
+}
+
+//Rigid transform as a Mat4, rotation then translation
+Mat4 ToMat4(Quaternion rotation, const Vec3 &translation) {
+  Mat4 ret;
+  rotation.ToMatrix(ret);
+  return Mat4::Translation(translation) * ret;
+}
+
+Vec3 TransformPoint(const Mat4 &mat, const Vec3 &point) {
+  return Vec3(mat * Vec4(point, 1.f));
+}
+
+//Composed dual quaternions against Quaternion::ToMatrix() and a translation
+//through Mat4, Blend() at its ends against its inputs
+void CheckDualQuaternions(Runner &runner, const std::vector<Quaternion> &from,
+                          const std::vector<Quaternion> &to) {
+  std::mt19937 rng(5678);
+  std::uniform_real_distribution<float> coordinate(-100.f, 100.f);
+  float compose_error = 0.f, blend_error = 0.f;
+  for (size_t i = 0; i < from.size(); ++i) {
+    Vec3 translation_a(coordinate(rng), coordinate(rng), coordinate(rng));
+    Vec3 translation_b(coordinate(rng), coordinate(rng), coordinate(rng));
+    Vec3 point(coordinate(rng), coordinate(rng), coordinate(rng));
+    DualQuaternion dq_a(from[i], translation_a);
+    DualQuaternion dq_b(to[i], translation_b);
+    //Points and translations are up to ~350 from the origin
+    float scale = 350.f;
+
+    Mat4 mat = ToMat4(from[i], translation_a) * ToMat4(to[i], translation_b);
+    compose_error =
+        fmaxf(compose_error, MaxDifference((dq_a * dq_b) * point,
+                                           TransformPoint(mat, point)) /
+                                 scale);
+
+    blend_error = fmaxf(
+        blend_error,
+        MaxDifference(DualQuaternion::Blend(dq_a, dq_b, 0.f) * point,
+                      dq_a * point) / scale);
+    blend_error = fmaxf(
+        blend_error,
+        MaxDifference(DualQuaternion::Blend(dq_a, dq_b, 1.f) * point,
+                      dq_b * point) / scale);
+  }
+  runner.Check(compose_error <= DUAL_QUATERNION_EPSILON,
+               "DualQuaternion product vs Mat4, max relative error %g",
+               compose_error);
+  runner.Check(blend_error <= DUAL_QUATERNION_EPSILON,
+               "DualQuaternion::Blend at t = 0 and 1 vs its inputs, max "
+               "relative error %g", blend_error);
+}
+
+void RunQuaternionBenchmarks(Runner &runner) {
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> param(0.f, 1.f);
+  std::vector<Quaternion> from(NUM_QUATERNIONS), to(NUM_QUATERNIONS),
+      out(NUM_QUATERNIONS);
+  std::vector<float> t(NUM_QUATERNIONS);
+  for (int32_t i = 0; i < NUM_QUATERNIONS; ++i) {
+    from[i] = RandomRotation(rng);
+    to[i] = RandomRotation(rng);
+    t[i] = param(rng);
+  }
+  CheckInterpolation(runner, from, to, t);
+  CheckDualQuaternions(runner, from, to);
+
+  runner.Run("Quaternion::Slerp x1000 (single)", NUM_QUATERNIONS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_QUATERNIONS; ++j)
+        out[j] = Quaternion::Slerp(from[j], to[j], t[j]);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Quaternion::Slerp x1000 (batch)", NUM_QUATERNIONS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Quaternion::Slerp(from.data(), to.data(), t.data(), out.data(),
+                        NUM_QUATERNIONS);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Quaternion::Nlerp x1000 (single)", NUM_QUATERNIONS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      for (int32_t j = 0; j < NUM_QUATERNIONS; ++j)
+        out[j] = Quaternion::Nlerp(from[j], to[j], t[j]);
+      ClobberMemory();
+    }
+  });
+  runner.Run("Quaternion::Nlerp x1000 (batch)", NUM_QUATERNIONS,
+             [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      Quaternion::Nlerp(from.data(), to.data(), t.data(), out.data(),
+                        NUM_QUATERNIONS);
+      ClobberMemory();
+    }
+  });
+
+  DualQuaternion dq_a(ROTATION_A, TRANSLATION_A);
+  DualQuaternion dq_b(ROTATION_B, TRANSLATION_B);
+  DoNotOptimize(dq_a);
+  DoNotOptimize(dq_b);
+  runner.Run("DualQuaternion::operator*(DualQuaternion)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      DualQuaternion r = dq_a * dq_b;
+      DoNotOptimize(r);
+    }
+  });
+  runner.Run("DualQuaternion::Blend(2)", [&](int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+      DualQuaternion r = DualQuaternion::Blend(dq_a, dq_b, 0.25f);
+      DoNotOptimize(r);
+    }
+  });
+}
+
+} //namespace
+
+void RunVecmathBenchmarks(Runner &runner) {
+  CheckProducts(runner);
+  CheckTransforms(runner);
+  RunVectorBenchmarks(runner);
+  RunAffineBenchmarks(runner);
+  RunProductChainBenchmarks(runner);
+  RunTransformBenchmarks(runner);
+  RunQuaternionBenchmarks(runner);
+}
+
+} //namespace benchmark
+
+}      //namespace ndk_helper
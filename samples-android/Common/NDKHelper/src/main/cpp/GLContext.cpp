@@ -32,15 +32,25 @@ namespace ndk_helper {
 //--------------------------------------------------------------------------------
 const int32_t SWAPINTERVAL_DEFAULT = 1;
 
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+//GL_KHR_parallel_shader_compile, the count lets the driver pick
+const GLuint MAX_SHADER_COMPILER_THREADS_DEFAULT = 0xFFFFFFFF;
+typedef void(GL_APIENTRY *MaxShaderCompilerThreadsFunction)(GLuint count);
+
 //--------------------------------------------------------------------------------
 // Ctor
 //--------------------------------------------------------------------------------
 GLContext::GLContext()
     : window_(nullptr), display_(EGL_NO_DISPLAY), surface_(EGL_NO_SURFACE),
-      context_(EGL_NO_CONTEXT), screen_width_(0), screen_height_(0),
+      context_(EGL_NO_CONTEXT), headless_(false), screen_width_(0),
+      screen_height_(0),
       msaa_size_(1), restoreInterval_(false),
       swapInterval_(SWAPINTERVAL_DEFAULT), gles_initialized_(false),
-      egl_context_initialized_(false), es3_supported_(false), gl_version_(0),
+      egl_context_initialized_(false), es3_supported_(false),
+      parallel_shader_compile_(false), gl_version_(0),
       context_valid_(false) {}
 
 void GLContext::InitGLES() {
@@ -56,6 +66,22 @@ void GLContext::InitGLES() {
   } else {
     gl_version_ = 2.0f;
   }
+  //Vertex array objects are core in ES3, GLState emulates them on ES2
+  state_.SetVertexArraySupport(es3_supported_);
+  program_cache_.Init(es3_supported_,
+                      CheckExtension("GL_OES_get_program_binary"));
+
+  //Drivers may default to fewer threads than they have, or to none
+  parallel_shader_compile_ = false;
+  if (CheckExtension("GL_KHR_parallel_shader_compile")) {
+    MaxShaderCompilerThreadsFunction max_shader_compiler_threads =
+        (MaxShaderCompilerThreadsFunction)eglGetProcAddress(
+            "glMaxShaderCompilerThreadsKHR");
+    if (max_shader_compiler_threads) {
+      max_shader_compiler_threads(MAX_SHADER_COMPILER_THREADS_DEFAULT);
+      parallel_shader_compile_ = true;
+    }
+  }
 
   gles_initialized_ = true;
 }
@@ -73,6 +99,7 @@ bool GLContext::Init(ANativeWindow *window, const int32_t msaa) {
   //Initialize EGL
   //
   window_ = window;
+  headless_ = false;
   msaa_size_ = msaa;
   InitEGLSurface();
   InitEGLContext();
@@ -83,18 +110,49 @@ bool GLContext::Init(ANativeWindow *window, const int32_t msaa) {
   return true;
 }
 
+bool GLContext::InitHeadless(const int32_t width, const int32_t height,
+                             const int32_t msaa) {
+  if (egl_context_initialized_)
+    return true;
+
+  window_ = nullptr;
+  headless_ = true;
+  screen_width_ = width;
+  screen_height_ = height;
+  msaa_size_ = msaa;
+  if (!InitEGLSurface() || !InitEGLContext())
+    return false;
+  InitGLES();
+
+  egl_context_initialized_ = true;
+
+  return true;
+}
+
 bool GLContext::InitEGLSurface() {
-  display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-  eglInitialize(display_, 0, 0);
+  display_ = EGL_NO_DISPLAY;
+#if !defined(__ANDROID__)
+  //Mesa renders without a window system on the surfaceless platform
+  if (headless_)
+    display_ = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                     EGL_DEFAULT_DISPLAY, NULL);
+#endif
+  if (display_ == EGL_NO_DISPLAY)
+    display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (eglInitialize(display_, 0, 0) == EGL_FALSE) {
+    LOGW("Unable to eglInitialize");
+    return false;
+  }
 
   /*
    * Here specify the attributes of the desired configuration.
    * Below, we select an EGLConfig with at least 8 bits per color
-   * component compatible with on-screen windows
+   * component compatible with on-screen windows, or pbuffers when headless
    */
+  const EGLint surface_type = headless_ ? EGL_PBUFFER_BIT : EGL_WINDOW_BIT;
   const EGLint attribs0[] = { EGL_RENDERABLE_TYPE,
                              EGL_OPENGL_ES2_BIT, //Request opengl ES2.0
-                             EGL_SURFACE_TYPE, EGL_WINDOW_BIT, EGL_BLUE_SIZE, 8,
+                             EGL_SURFACE_TYPE, surface_type, EGL_BLUE_SIZE, 8,
                              EGL_GREEN_SIZE, 8, EGL_RED_SIZE, 8, EGL_DEPTH_SIZE,
                              24, EGL_SAMPLES, msaa_size_, EGL_NONE };
   color_size_ = 8;
@@ -108,7 +166,7 @@ bool GLContext::InitEGLSurface() {
     //Fall back to non MSAA
     const EGLint attribs[] = { EGL_RENDERABLE_TYPE,
                                EGL_OPENGL_ES2_BIT, //Request opengl ES2.0
-                               EGL_SURFACE_TYPE, EGL_WINDOW_BIT, EGL_BLUE_SIZE,
+                               EGL_SURFACE_TYPE, surface_type, EGL_BLUE_SIZE,
                                8, EGL_GREEN_SIZE, 8, EGL_RED_SIZE, 8,
                                EGL_DEPTH_SIZE, 24, EGL_NONE };
     msaa_size_ = 1;
@@ -121,7 +179,7 @@ bool GLContext::InitEGLSurface() {
     //Fall back to 16bit depth buffer
     const EGLint attribs[] = { EGL_RENDERABLE_TYPE,
                                EGL_OPENGL_ES2_BIT, //Request opengl ES2.0
-                               EGL_SURFACE_TYPE, EGL_WINDOW_BIT, EGL_BLUE_SIZE,
+                               EGL_SURFACE_TYPE, surface_type, EGL_BLUE_SIZE,
                                8, EGL_GREEN_SIZE, 8, EGL_RED_SIZE, 8,
                                EGL_DEPTH_SIZE, 16, EGL_NONE };
     eglChooseConfig(display_, attribs, &config_, 1, &num_configs);
@@ -133,7 +191,22 @@ bool GLContext::InitEGLSurface() {
     return false;
   }
 
-  surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
+  return CreateSurface();
+}
+
+bool GLContext::CreateSurface() {
+  if (headless_) {
+    //The pbuffer keeps the size given to InitHeadless()
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, screen_width_, EGL_HEIGHT,
+                                       screen_height_, EGL_NONE };
+    surface_ = eglCreatePbufferSurface(display_, config_, pbuffer_attribs);
+  } else {
+    surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
+  }
+  if (surface_ == EGL_NO_SURFACE) {
+    LOGW("Unable to create EGL surface");
+    return false;
+  }
   eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
   eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
 
@@ -145,6 +218,7 @@ bool GLContext::InitEGLContext() {
                                      2, //Request opengl ES2.0
                                      EGL_NONE };
   context_ = eglCreateContext(display_, config_, NULL, context_attribs);
+  state_.Invalidate();
 
   if (eglMakeCurrent(display_, surface_, surface_, context_) == EGL_FALSE) {
     LOGW("Unable to eglMakeCurrent");
@@ -200,18 +274,20 @@ void GLContext::Terminate() {
 
 EGLint GLContext::Resume(ANativeWindow *window) {
   if (egl_context_initialized_ == false) {
-    Init(window, msaa_size_);
+    if (headless_)
+      InitHeadless(screen_width_, screen_height_, msaa_size_);
+    else
+      Init(window, msaa_size_);
     return EGL_SUCCESS;
   }
 
   int32_t original_widhth = screen_width_;
   int32_t original_height = screen_height_;
 
-  //Create surface
-  window_ = window;
-  surface_ = eglCreateWindowSurface(display_, config_, window_, NULL);
-  eglQuerySurface(display_, surface_, EGL_WIDTH, &screen_width_);
-  eglQuerySurface(display_, surface_, EGL_HEIGHT, &screen_height_);
+  //Create surface, a headless context ignores the window
+  if (!headless_)
+    window_ = window;
+  CreateSurface();
 
   if (screen_width_ != original_widhth || screen_height_ != original_height) {
     //Screen resized
@@ -249,7 +325,11 @@ void GLContext::Suspend() {
 bool GLContext::Invalidate() {
   Terminate();
 
+  //The next Init() may get a context of another version
   egl_context_initialized_ = false;
+  gles_initialized_ = false;
+  es3_supported_ = false;
+  parallel_shader_compile_ = false;
   return true;
 }
 
@@ -22,9 +22,20 @@
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+
+#if defined(__ANDROID__)
 #include <android/log.h>
 
 #include "JNIHelper.h"
+#else
+//Host builds run on glDispatch.h backends, with EGL_NO_PLATFORM_SPECIFIC_TYPES
+//so any window pointer converts to EGLNativeWindowType
+#include <string>
+#include "vecmath.h"
+struct ANativeWindow;
+#endif
+#include "GLState.h"
+#include "ProgramCache.h"
 
 namespace ndk_helper {
 
@@ -46,6 +57,14 @@ namespace ndk_helper {
  * in the device.
  * getGLVersion() returns 3.0~ when the device supports OpenGLES3.0
  *
+ * Renderers change GL state through GetState(), which filters out redundant
+ * calls, and load programs through GetProgramCache(), which keeps linked
+ * program binaries between runs.
+ *
+ * InitHeadless() renders to an offscreen pbuffer instead of a window, e.g. on
+ * Mesa llvmpipe in host benchmarks. On host it prefers the surfaceless Mesa
+ * platform so no window system is needed.
+ *
  * Thread safety: OpenGL context is expecting used within dedicated single
  * thread,
  * thus GLContext class is not designed as a thread-safe
@@ -58,6 +77,7 @@ private:
   EGLSurface surface_;
   EGLContext context_;
   EGLConfig config_;
+  bool headless_;
 
   //Screen parameters
   int32_t screen_width_;
@@ -74,12 +94,18 @@ private:
   bool gles_initialized_;
   bool egl_context_initialized_;
   bool es3_supported_;
+  bool parallel_shader_compile_;
   float gl_version_;
   bool context_valid_;
 
+  //State cache of context_, a new context starts from scratch
+  GLState state_;
+  ProgramCache program_cache_;
+
   void InitGLES();
   void Terminate();
   bool InitEGLSurface();
+  bool CreateSurface();
   bool InitEGLContext();
 
   GLContext(GLContext const &);
@@ -96,6 +122,9 @@ public:
   }
 
   bool Init(ANativeWindow *window, const int32_t msaa = 1);
+  //Offscreen pbuffer of width x height, Resume() keeps it
+  bool InitHeadless(const int32_t width, const int32_t height,
+                    const int32_t msaa = 1);
   EGLint Swap();
   bool Invalidate();
 
@@ -110,6 +139,12 @@ public:
   int32_t GetMSAASize() { return msaa_size_; }
 
   float GetGLVersion() { return gl_version_; }
+  bool IsHeadless() { return headless_; }
+  GLState *GetState() { return &state_; }
+  ProgramCache *GetProgramCache() { return &program_cache_; }
+  //GL_KHR_parallel_shader_compile, the driver compiles and links on its own
+  //threads, see ProgramBuilder
+  bool IsParallelShaderCompileSupported() { return parallel_shader_compile_; }
   bool CheckExtension(const char *extension);
 
   /*
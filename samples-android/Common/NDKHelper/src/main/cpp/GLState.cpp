@@ -0,0 +1,518 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// GLState.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include <string.h>
+#include "GLState.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+GLState::GLState()
+    : native_vertex_arrays_(false), vertex_array_(UNKNOWN),
+      next_vertex_array_(1) {
+  ResetCounters();
+  SetVertexArraySupport(false);
+  Invalidate();
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+GLState::~GLState() {}
+
+void GLState::Invalidate() {
+  program_ = UNKNOWN;
+  array_buffer_ = UNKNOWN;
+  uniform_buffer_ = UNKNOWN;
+  for (int32_t i = 0; i < GLSTATE_MAX_UNIFORM_BUFFERS; ++i)
+    uniform_buffers_[i].buffer = UNKNOWN;
+
+  if (native_vertex_arrays_) {
+    for (std::map<GLuint, VertexArray>::iterator it = vertex_arrays_.begin();
+         it != vertex_arrays_.end(); ++it)
+      ResetVertexArray(&it->second, false);
+  } else if (vertex_array_ != UNKNOWN) {
+    //Emulated vertex arrays live here, the bound one keeps what was set
+    std::map<GLuint, VertexArray>::iterator it =
+        vertex_arrays_.find(vertex_array_);
+    if (it != vertex_arrays_.end())
+      it->second = emulated_state_;
+  }
+  vertex_array_ = UNKNOWN;
+  ResetVertexArray(&emulated_state_, false);
+  ResetVertexArray(&unknown_state_, false);
+  vertex_array_state_ =
+      native_vertex_arrays_ ? &unknown_state_ : &emulated_state_;
+
+  uniforms_.clear();
+  program_uniforms_ = NULL;
+
+  blend_ = -1;
+  cull_face_ = -1;
+  depth_test_ = -1;
+  blend_src_ = GL_NONE;
+  blend_dst_ = GL_NONE;
+  cull_face_mode_ = GL_NONE;
+  front_face_ = GL_NONE;
+  depth_func_ = GL_NONE;
+  depth_mask_ = -1;
+}
+
+//--------------------------------------------------------------------------------
+// Program
+//--------------------------------------------------------------------------------
+void GLState::UseProgram(const GLuint program) {
+  if (Skip(program == program_))
+    return;
+  glUseProgram(program);
+  program_ = program;
+  program_uniforms_ = program ? &uniforms_[program] : NULL;
+}
+
+void GLState::DeleteProgram(const GLuint program) {
+  ++counters_.issued;
+  glDeleteProgram(program);
+  uniforms_.erase(program);
+  //A bound program is only flagged for deletion, its name stays in use until
+  //another program is bound, so program_ is kept
+  if (program == program_)
+    program_uniforms_ = &uniforms_[program];
+}
+
+//--------------------------------------------------------------------------------
+// Buffers
+//--------------------------------------------------------------------------------
+void GLState::BindBuffer(const GLenum target, const GLuint buffer) {
+  GLuint *binding = NULL;
+  if (target == GL_ARRAY_BUFFER)
+    binding = &array_buffer_;
+  else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    binding = &vertex_array_state_->element_array_buffer;
+  else if (target == GL_UNIFORM_BUFFER)
+    binding = &uniform_buffer_;
+
+  if (Skip(binding != NULL && *binding == buffer))
+    return;
+  glBindBuffer(target, buffer);
+  if (binding)
+    *binding = buffer;
+}
+
+void GLState::DeleteBuffer(const GLuint buffer) {
+  ++counters_.issued;
+  glDeleteBuffers(1, &buffer);
+  //Deleting a bound buffer reverts the binding to 0, attribute arrays and
+  //other vertex arrays keep pointing at the dead name
+  if (array_buffer_ == buffer)
+    array_buffer_ = 0;
+  if (uniform_buffer_ == buffer)
+    uniform_buffer_ = 0;
+  for (int32_t i = 0; i < GLSTATE_MAX_UNIFORM_BUFFERS; ++i) {
+    if (uniform_buffers_[i].buffer == buffer)
+      uniform_buffers_[i].buffer = UNKNOWN;
+  }
+  if (vertex_array_state_->element_array_buffer == buffer)
+    vertex_array_state_->element_array_buffer = 0;
+  ForgetBuffer(vertex_array_state_, buffer);
+  for (std::map<GLuint, VertexArray>::iterator it = vertex_arrays_.begin();
+       it != vertex_arrays_.end(); ++it)
+    ForgetBuffer(&it->second, buffer);
+}
+
+void GLState::BindBufferBase(const GLenum target, const GLuint index,
+                             const GLuint buffer) {
+  if (target != GL_UNIFORM_BUFFER ||
+      index >= (GLuint)GLSTATE_MAX_UNIFORM_BUFFERS) {
+    ++counters_.issued;
+    glBindBufferBase(target, index, buffer);
+    return;
+  }
+  BufferRange &binding = uniform_buffers_[index];
+  if (Skip(binding.buffer == buffer && binding.size == -1))
+    return;
+  glBindBufferBase(target, index, buffer);
+  //Indexed binds set the generic binding as well
+  uniform_buffer_ = buffer;
+  binding.buffer = buffer;
+  binding.offset = 0;
+  binding.size = -1;
+}
+
+void GLState::BindBufferRange(const GLenum target, const GLuint index,
+                              const GLuint buffer, const GLintptr offset,
+                              const GLsizeiptr size) {
+  if (target != GL_UNIFORM_BUFFER ||
+      index >= (GLuint)GLSTATE_MAX_UNIFORM_BUFFERS) {
+    ++counters_.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+    return;
+  }
+  BufferRange &binding = uniform_buffers_[index];
+  if (Skip(binding.buffer == buffer && binding.offset == offset &&
+           binding.size == size))
+    return;
+  glBindBufferRange(target, index, buffer, offset, size);
+  uniform_buffer_ = buffer;
+  binding.buffer = buffer;
+  binding.offset = offset;
+  binding.size = size;
+}
+
+//--------------------------------------------------------------------------------
+// Vertex arrays
+//--------------------------------------------------------------------------------
+void GLState::ResetVertexArray(VertexArray *vertex_array, const bool initial) {
+  vertex_array->element_array_buffer = initial ? 0 : UNKNOWN;
+  for (int32_t i = 0; i < GLSTATE_MAX_ATTRIBS; ++i) {
+    VertexAttrib &attrib = vertex_array->attribs[i];
+    attrib.enabled = initial ? 0 : -1;
+    attrib.divisor = initial ? 0 : UNKNOWN;
+    attrib.buffer = UNKNOWN;
+  }
+}
+
+void GLState::ForgetBuffer(VertexArray *vertex_array, const GLuint buffer) {
+  if (vertex_array->element_array_buffer == buffer)
+    vertex_array->element_array_buffer = UNKNOWN;
+  for (int32_t i = 0; i < GLSTATE_MAX_ATTRIBS; ++i) {
+    if (vertex_array->attribs[i].buffer == buffer)
+      vertex_array->attribs[i].buffer = UNKNOWN;
+  }
+}
+
+//ES2 emulation, brings the GL state to the recorded layout. Unknown parts of
+//the layout are left alone, divisors don't exist in ES2
+void GLState::ApplyVertexArray(const VertexArray &vertex_array) {
+  VertexArray &current = emulated_state_;
+  if (vertex_array.element_array_buffer != UNKNOWN &&
+      vertex_array.element_array_buffer != current.element_array_buffer) {
+    ++counters_.issued;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_array.element_array_buffer);
+    current.element_array_buffer = vertex_array.element_array_buffer;
+  }
+
+  for (int32_t i = 0; i < GLSTATE_MAX_ATTRIBS; ++i) {
+    const VertexAttrib &attrib = vertex_array.attribs[i];
+    VertexAttrib &gl = current.attribs[i];
+    if (attrib.enabled == 0 && gl.enabled != 0) {
+      ++counters_.issued;
+      glDisableVertexAttribArray(i);
+      gl.enabled = 0;
+    }
+    if (attrib.enabled != 1)
+      continue;
+
+    if (attrib.buffer != UNKNOWN && !SameArray(attrib, gl)) {
+      if (array_buffer_ != attrib.buffer) {
+        ++counters_.issued;
+        glBindBuffer(GL_ARRAY_BUFFER, attrib.buffer);
+        array_buffer_ = attrib.buffer;
+      }
+      ++counters_.issued;
+      glVertexAttribPointer(i, attrib.size, attrib.type, attrib.normalized,
+                            attrib.stride, attrib.pointer);
+      gl.buffer = attrib.buffer;
+      gl.size = attrib.size;
+      gl.type = attrib.type;
+      gl.normalized = attrib.normalized;
+      gl.stride = attrib.stride;
+      gl.pointer = attrib.pointer;
+    }
+    if (gl.enabled != 1) {
+      ++counters_.issued;
+      glEnableVertexAttribArray(i);
+      gl.enabled = 1;
+    }
+  }
+}
+
+void GLState::SetVertexArraySupport(const bool native) {
+  native_vertex_arrays_ = native;
+  vertex_arrays_.clear();
+  next_vertex_array_ = 1;
+  //The default vertex array, its state is whatever GL has
+  ResetVertexArray(&vertex_arrays_[0], false);
+
+  vertex_array_ = UNKNOWN;
+  ResetVertexArray(&unknown_state_, false);
+  vertex_array_state_ = native ? &unknown_state_ : &emulated_state_;
+}
+
+GLuint GLState::GenVertexArray() {
+  GLuint vertex_array;
+  if (native_vertex_arrays_) {
+    ++counters_.issued;
+    glGenVertexArrays(1, &vertex_array);
+  } else {
+    vertex_array = next_vertex_array_++;
+  }
+  ResetVertexArray(&vertex_arrays_[vertex_array], true);
+  return vertex_array;
+}
+
+void GLState::BindVertexArray(const GLuint vertex_array) {
+  if (vertex_array == vertex_array_) {
+    ++counters_.skipped;
+    return;
+  }
+
+  if (native_vertex_arrays_) {
+    ++counters_.issued;
+    glBindVertexArray(vertex_array);
+    vertex_array_ = vertex_array;
+    vertex_array_state_ = &vertex_arrays_[vertex_array];
+    return;
+  }
+
+  //Emulation, the bound vertex array keeps what was set since it was bound
+  std::map<GLuint, VertexArray>::iterator it =
+      vertex_arrays_.find(vertex_array_);
+  if (it != vertex_arrays_.end())
+    it->second = emulated_state_;
+  vertex_array_ = vertex_array;
+  it = vertex_arrays_.find(vertex_array);
+  if (it != vertex_arrays_.end())
+    ApplyVertexArray(it->second);
+}
+
+void GLState::DeleteVertexArray(const GLuint vertex_array) {
+  if (vertex_array == 0)
+    return;
+  if (native_vertex_arrays_) {
+    ++counters_.issued;
+    glDeleteVertexArrays(1, &vertex_array);
+  }
+  vertex_arrays_.erase(vertex_array);
+
+  //Deleting the bound vertex array binds the default one
+  if (vertex_array == vertex_array_) {
+    vertex_array_ = 0;
+    if (native_vertex_arrays_)
+      vertex_array_state_ = &vertex_arrays_[0];
+    else
+      ApplyVertexArray(vertex_arrays_[0]);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Vertex attributes
+//--------------------------------------------------------------------------------
+void GLState::EnableVertexAttribArray(const GLuint index) {
+  if (index >= (GLuint)GLSTATE_MAX_ATTRIBS) {
+    ++counters_.issued;
+    glEnableVertexAttribArray(index);
+    return;
+  }
+  VertexAttrib &attrib = vertex_array_state_->attribs[index];
+  if (Skip(attrib.enabled == 1))
+    return;
+  glEnableVertexAttribArray(index);
+  attrib.enabled = 1;
+}
+
+void GLState::DisableVertexAttribArray(const GLuint index) {
+  if (index >= (GLuint)GLSTATE_MAX_ATTRIBS) {
+    ++counters_.issued;
+    glDisableVertexAttribArray(index);
+    return;
+  }
+  VertexAttrib &attrib = vertex_array_state_->attribs[index];
+  if (Skip(attrib.enabled == 0))
+    return;
+  glDisableVertexAttribArray(index);
+  attrib.enabled = 0;
+}
+
+void GLState::VertexAttribDivisor(const GLuint index, const GLuint divisor) {
+  if (index >= (GLuint)GLSTATE_MAX_ATTRIBS) {
+    ++counters_.issued;
+    glVertexAttribDivisor(index, divisor);
+    return;
+  }
+  VertexAttrib &attrib = vertex_array_state_->attribs[index];
+  if (Skip(attrib.divisor == divisor))
+    return;
+  glVertexAttribDivisor(index, divisor);
+  attrib.divisor = divisor;
+}
+
+void GLState::VertexAttribPointer(const GLuint index, const GLint size,
+                                  const GLenum type,
+                                  const GLboolean normalized,
+                                  const GLsizei stride, const void *pointer) {
+  if (index >= (GLuint)GLSTATE_MAX_ATTRIBS || array_buffer_ == UNKNOWN) {
+    ++counters_.issued;
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    if (index < (GLuint)GLSTATE_MAX_ATTRIBS)
+      vertex_array_state_->attribs[index].buffer = UNKNOWN;
+    return;
+  }
+
+  VertexAttrib array;
+  array.buffer = array_buffer_;
+  array.size = size;
+  array.type = type;
+  array.normalized = normalized;
+  array.stride = stride;
+  array.pointer = pointer;
+  VertexAttrib &attrib = vertex_array_state_->attribs[index];
+  if (Skip(SameArray(attrib, array)))
+    return;
+  glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+  attrib.buffer = array.buffer;
+  attrib.size = size;
+  attrib.type = type;
+  attrib.normalized = normalized;
+  attrib.stride = stride;
+  attrib.pointer = pointer;
+}
+
+//--------------------------------------------------------------------------------
+// Uniforms
+//--------------------------------------------------------------------------------
+bool GLState::SetUniform(const GLint location, const GLenum type,
+                         const void *data, const size_t size) {
+  //GL ignores location -1, so does the cache
+  if (location < 0) {
+    ++counters_.skipped;
+    return false;
+  }
+  if (program_uniforms_ == NULL) {
+    ++counters_.issued;
+    return true;
+  }
+
+  if ((size_t)location >= program_uniforms_->size()) {
+    Uniform unset;
+    unset.type = GL_NONE;
+    program_uniforms_->resize(location + 1, unset);
+  }
+  Uniform &uniform = (*program_uniforms_)[location];
+  if (Skip(uniform.type == type && memcmp(uniform.data, data, size) == 0))
+    return false;
+  uniform.type = type;
+  memcpy(uniform.data, data, size);
+  return true;
+}
+
+void GLState::Uniform1i(const GLint location, const GLint x) {
+  if (SetUniform(location, GL_INT, &x, sizeof(x)))
+    glUniform1i(location, x);
+}
+
+void GLState::Uniform1f(const GLint location, const GLfloat x) {
+  if (SetUniform(location, GL_FLOAT, &x, sizeof(x)))
+    glUniform1f(location, x);
+}
+
+void GLState::Uniform3f(const GLint location, const GLfloat x, const GLfloat y,
+                        const GLfloat z) {
+  const GLfloat value[] = { x, y, z };
+  if (SetUniform(location, GL_FLOAT_VEC3, value, sizeof(value)))
+    glUniform3f(location, x, y, z);
+}
+
+void GLState::Uniform4f(const GLint location, const GLfloat x, const GLfloat y,
+                        const GLfloat z, const GLfloat w) {
+  const GLfloat value[] = { x, y, z, w };
+  if (SetUniform(location, GL_FLOAT_VEC4, value, sizeof(value)))
+    glUniform4f(location, x, y, z, w);
+}
+
+void GLState::UniformMatrix4fv(const GLint location, const GLfloat *value) {
+  if (SetUniform(location, GL_FLOAT_MAT4, value, sizeof(GLfloat) * 16))
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+//--------------------------------------------------------------------------------
+// Fixed function state
+//--------------------------------------------------------------------------------
+int8_t *GLState::FindCapability(const GLenum cap) {
+  switch (cap) {
+  case GL_BLEND:
+    return &blend_;
+  case GL_CULL_FACE:
+    return &cull_face_;
+  case GL_DEPTH_TEST:
+    return &depth_test_;
+  default:
+    return NULL;
+  }
+}
+
+void GLState::Enable(const GLenum cap) {
+  int8_t *enabled = FindCapability(cap);
+  if (Skip(enabled != NULL && *enabled == 1))
+    return;
+  glEnable(cap);
+  if (enabled)
+    *enabled = 1;
+}
+
+void GLState::Disable(const GLenum cap) {
+  int8_t *enabled = FindCapability(cap);
+  if (Skip(enabled != NULL && *enabled == 0))
+    return;
+  glDisable(cap);
+  if (enabled)
+    *enabled = 0;
+}
+
+void GLState::BlendFunc(const GLenum src, const GLenum dst) {
+  if (Skip(src == blend_src_ && dst == blend_dst_))
+    return;
+  glBlendFunc(src, dst);
+  blend_src_ = src;
+  blend_dst_ = dst;
+}
+
+void GLState::CullFace(const GLenum mode) {
+  if (Skip(mode == cull_face_mode_))
+    return;
+  glCullFace(mode);
+  cull_face_mode_ = mode;
+}
+
+void GLState::FrontFace(const GLenum mode) {
+  if (Skip(mode == front_face_))
+    return;
+  glFrontFace(mode);
+  front_face_ = mode;
+}
+
+void GLState::DepthFunc(const GLenum func) {
+  if (Skip(func == depth_func_))
+    return;
+  glDepthFunc(func);
+  depth_func_ = func;
+}
+
+void GLState::DepthMask(const GLboolean flag) {
+  if (Skip(depth_mask_ == (flag ? 1 : 0)))
+    return;
+  glDepthMask(flag);
+  depth_mask_ = flag ? 1 : 0;
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// GLState.h
+//--------------------------------------------------------------------------------
+#ifndef GLSTATE_H_
+#define GLSTATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "gl3stub.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Vertex attributes shadowed by GLState, ES guarantees at least 8 and most
+//drivers expose 16
+const int32_t GLSTATE_MAX_ATTRIBS = 16;
+//Indexed GL_UNIFORM_BUFFER bindings shadowed by GLState, the ES3 minimum
+const int32_t GLSTATE_MAX_UNIFORM_BUFFERS = 24;
+
+//GL calls that reached the driver and calls GLState filtered out, since the
+//last ResetCounters()
+struct GLStateCounters {
+  uint32_t issued;
+  uint32_t skipped;
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * OpenGL state cache
+ * Shadows the state renderers set over and over every frame: bound program
+ * and buffers, vertex attribute arrays, uniforms of each program, uniform
+ * buffer bindings and the blend/depth/cull settings. Each setter compares against the shadow copy and
+ * only calls GL when the value changes.
+ *
+ * All state changes of the context need to go through the same GLState,
+ * otherwise the shadow copy goes stale. Code that calls GL directly must call
+ * Invalidate() afterwards. Objects are deleted through GLState as well, so a
+ * recycled name isn't mistaken for a bound one.
+ *
+ * GLContext owns the instance of its context and invalidates it whenever the
+ * context is (re)created, see GLContext::GetState().
+ *
+ * Vertex array objects: GenVertexArray() and BindVertexArray() use real VAOs
+ * on ES3. ES2 has none, there GLState emulates them with the same interface:
+ * attribute arrays and the element buffer set while a vertex array is bound
+ * are recorded with it, binding it again replays the difference to the
+ * current state. Either way a renderer records its layout once and binds it
+ * with one call per draw. As in GL, the GL_ARRAY_BUFFER binding isn't part of
+ * a vertex array, the emulation may change it though.
+ *
+ * Thread safety: same as the context, single thread only
+ */
+class GLState {
+private:
+  static const GLuint UNKNOWN = 0xffffffff;
+
+  struct VertexAttrib {
+    int8_t enabled; //-1 unknown
+    GLuint divisor;
+    GLuint buffer;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void *pointer;
+  };
+
+  //Up to a mat4 of floats or ints, compared bitwise
+  struct Uniform {
+    GLenum type; //GL_NONE until set
+    uint32_t data[16];
+  };
+
+  //Vertex array object state
+  struct VertexArray {
+    GLuint element_array_buffer;
+    VertexAttrib attribs[GLSTATE_MAX_ATTRIBS];
+  };
+
+  //Indexed binding, size -1 for the whole buffer
+  struct BufferRange {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+  };
+
+  GLuint program_;
+  GLuint array_buffer_;
+  GLuint uniform_buffer_;
+  BufferRange uniform_buffers_[GLSTATE_MAX_UNIFORM_BUFFERS];
+
+  //ES3: shadow of each vertex array object, vertex_array_state_ points at
+  //the bound one. ES2: recorded layouts of the emulated vertex arrays,
+  //vertex_array_state_ points at emulated_state_, the actual GL state
+  bool native_vertex_arrays_;
+  GLuint vertex_array_;
+  GLuint next_vertex_array_;
+  std::map<GLuint, VertexArray> vertex_arrays_;
+  VertexArray emulated_state_;
+  VertexArray unknown_state_; //Shadow while the bound vertex array is unknown
+  VertexArray *vertex_array_state_;
+
+  //Uniforms are program state, indexed by location
+  std::map<GLuint, std::vector<Uniform> > uniforms_;
+  std::vector<Uniform> *program_uniforms_;
+
+  int8_t blend_;
+  int8_t cull_face_;
+  int8_t depth_test_;
+  GLenum blend_src_;
+  GLenum blend_dst_;
+  GLenum cull_face_mode_;
+  GLenum front_face_;
+  GLenum depth_func_;
+  int8_t depth_mask_;
+
+  GLStateCounters counters_;
+
+  bool Skip(const bool unchanged) {
+    if (unchanged) {
+      ++counters_.skipped;
+      return true;
+    }
+    ++counters_.issued;
+    return false;
+  }
+  int8_t *FindCapability(const GLenum cap);
+  //initial: GL defaults of a new vertex array, otherwise unknown
+  static void ResetVertexArray(VertexArray *vertex_array, const bool initial);
+  static void ForgetBuffer(VertexArray *vertex_array, const GLuint buffer);
+  static bool SameArray(const VertexAttrib &a, const VertexAttrib &b) {
+    return a.buffer == b.buffer && a.size == b.size && a.type == b.type &&
+           a.normalized == b.normalized && a.stride == b.stride &&
+           a.pointer == b.pointer;
+  }
+  void ApplyVertexArray(const VertexArray &vertex_array);
+  bool SetUniform(const GLint location, const GLenum type, const void *data,
+                  const size_t size);
+
+  GLState(GLState const &);
+  void operator=(GLState const &);
+
+public:
+  GLState();
+  virtual ~GLState();
+
+  //Forgets all shadowed state, the next call of each setter reaches GL
+  void Invalidate();
+
+  //Real vertex array objects (ES3) or the emulation (ES2), deletes all
+  //vertex arrays. GLContext sets it for its context
+  void SetVertexArraySupport(const bool native);
+  bool HasNativeVertexArrays() const { return native_vertex_arrays_; }
+
+  void UseProgram(const GLuint program);
+  void DeleteProgram(const GLuint program);
+
+  //GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_UNIFORM_BUFFER are
+  //shadowed, other targets are passed through
+  void BindBuffer(const GLenum target, const GLuint buffer);
+  void DeleteBuffer(const GLuint buffer);
+  //ES3, indexed GL_UNIFORM_BUFFER bindings are shadowed, other targets are
+  //passed through
+  void BindBufferBase(const GLenum target, const GLuint index,
+                      const GLuint buffer);
+  void BindBufferRange(const GLenum target, const GLuint index,
+                       const GLuint buffer, const GLintptr offset,
+                       const GLsizeiptr size);
+
+  //A new vertex array starts with GL defaults: all arrays disabled and no
+  //element buffer. Vertex array 0 is the default one
+  GLuint GenVertexArray();
+  void BindVertexArray(const GLuint vertex_array);
+  void DeleteVertexArray(const GLuint vertex_array);
+
+  //State of the bound vertex array
+  void EnableVertexAttribArray(const GLuint index);
+  void DisableVertexAttribArray(const GLuint index);
+  void VertexAttribDivisor(const GLuint index, const GLuint divisor);
+  //Sources from the buffer bound with BindBuffer(GL_ARRAY_BUFFER)
+  void VertexAttribPointer(const GLuint index, const GLint size,
+                           const GLenum type, const GLboolean normalized,
+                           const GLsizei stride, const void *pointer);
+
+  //Uniforms of the program bound with UseProgram()
+  void Uniform1i(const GLint location, const GLint x);
+  void Uniform1f(const GLint location, const GLfloat x);
+  void Uniform3f(const GLint location, const GLfloat x, const GLfloat y,
+                 const GLfloat z);
+  void Uniform4f(const GLint location, const GLfloat x, const GLfloat y,
+                 const GLfloat z, const GLfloat w);
+  void UniformMatrix4fv(const GLint location, const GLfloat *value);
+
+  //GL_BLEND, GL_CULL_FACE and GL_DEPTH_TEST are shadowed, other caps are
+  //passed through
+  void Enable(const GLenum cap);
+  void Disable(const GLenum cap);
+  void BlendFunc(const GLenum src, const GLenum dst);
+  void CullFace(const GLenum mode);
+  void FrontFace(const GLenum mode);
+  void DepthFunc(const GLenum func);
+  void DepthMask(const GLboolean flag);
+
+  const GLStateCounters &GetCounters() const { return counters_; }
+  void ResetCounters() {
+    counters_.issued = 0;
+    counters_.skipped = 0;
+  }
+};
+
+} //namespace ndk_helper
+
+#endif /* GLSTATE_H_ */
@@ -190,6 +190,27 @@ bool JNIHelper::ReadFile(const char *fileName,
   }
 }
 
+/*
+ * OpenAsset
+ */
+AAsset *JNIHelper::OpenAsset(const char *fileName) {
+  if (activity_ == NULL) {
+    LOGI("JNIHelper has not been initialized.Call init() to initialize the "
+         "helper");
+    return NULL;
+  }
+
+  // Lock mutex
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  AAsset *assetFile =
+      AAssetManager_open(activity_->assetManager, fileName, AASSET_MODE_BUFFER);
+  if (!assetFile) {
+    LOGI("Failed to open:%s", fileName);
+  }
+  return assetFile;
+}
+
 std::string JNIHelper::GetExternalFilesDir() {
   if (activity_ == NULL) {
     LOGI("JNIHelper has not been initialized. Call init() to initialize the "
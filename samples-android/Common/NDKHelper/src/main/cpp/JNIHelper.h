@@ -116,6 +116,21 @@ public:
    */
   bool ReadFile(const char *file_name, std::vector<uint8_t> *buffer_ref);
 
+  /*
+   * Open an APK asset for in place access.
+   * Unlike ReadFile(), the contents are not copied: AAsset_getBuffer() on the
+   * returned asset maps the file directly when it is stored uncompressed in
+   * the APK.
+   *
+   * arguments:
+   * in: file_name, asset name to open
+   * return:
+   * AAsset opened with AASSET_MODE_BUFFER, the caller closes it with
+   * AAsset_close()
+   * NULL when it failed to open the asset
+   */
+  AAsset *OpenAsset(const char *file_name);
+
   /*
    * Load and create OpenGL texture from given file name.
    * The method invokes BitmapFactory in Java so it can read jpeg/png formatted
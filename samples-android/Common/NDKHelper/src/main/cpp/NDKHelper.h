@@ -30,12 +30,28 @@
  */
 #include "gl3stub.h"   //GLES3 stubs
 #include "GLContext.h" //EGL & OpenGL manager
+#include "GLState.h"   //OpenGL state cache
+#include "UniformBuffer.h" //ES3 uniform buffers
+#include "RenderQueue.h"   //Sorted draw submission
 #include "shader.h"    //Shader compiler support
+#include "shaderPreprocessor.h" //Shader #include/#define variants
+#include "ProgramCache.h" //Program binary cache
+#include "ProgramBuilder.h" //Asynchronous program builds
+#include "ShaderLibrary.h" //Shader variants and location tables
 #include "vecmath.h" //Vector math support, C++ implementation n current version
+#include "culling.h"     //Bounding volumes and frustum culling
+#include "vecmath_packing.h" //Half float/snorm vertex packing
+#include "mesh.h"            //Baked binary meshes
 #include "tapCamera.h"       //Tap/Pinch camera control
+#include "perfMonitor.h"     //FPS counter
+#include "framePipeline.h"   //Simulation/GL thread pipeline
+#include "fixedTimestep.h"   //Fixed timestep scheduler
+#include "interpolator.h"    //Interpolator
+#if defined(__ANDROID__)
 #include "JNIHelper.h"       //JNI support
 #include "gestureDetector.h" //Tap/Doubletap/Pinch detector
-#include "perfMonitor.h"     //FPS counter
 #include "sensorManager.h"   //SensorManager
-#include "interpolator.h"    //Interpolator
+#else
+#include "glDispatch.h" //Host side GL/EGL dispatch, see glRecorder.h
+#endif
 #endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ProgramBuilder.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include "ProgramBuilder.h"
+#include "shader.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace ndk_helper {
+
+namespace {
+
+//Compile without asking for the status, 0 if the shader is empty
+GLuint StartShader(const GLenum type, const std::string &source) {
+  if (source.empty())
+    return 0;
+  GLuint shader = glCreateShader(type);
+  const GLchar *string = source.data();
+  GLint length = (GLint)source.size();
+  glShaderSource(shader, 1, &string, &length);
+  glCompileShader(shader);
+  return shader;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ProgramBuilder::ProgramBuilder()
+    : state_(NULL), cache_(NULL), parallel_(false) {}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+ProgramBuilder::~ProgramBuilder() { Unload(); }
+
+void ProgramBuilder::Init(GLState *state, ProgramCache *cache,
+                          const bool parallel) {
+  Unload();
+  state_ = state;
+  cache_ = cache;
+  parallel_ = parallel;
+}
+
+void ProgramBuilder::Unload() {
+  for (size_t i = 0; i < programs_.size(); ++i) {
+    Program &program = programs_[i];
+    for (int32_t j = 0; j < 2; ++j) {
+      if (program.shaders[j])
+        glDeleteShader(program.shaders[j]);
+    }
+    if (program.program)
+      state_->DeleteProgram(program.program);
+  }
+  programs_.clear();
+}
+
+int32_t ProgramBuilder::Add(const std::string &vertex_source,
+                            const std::string &fragment_source,
+                            const ProgramAttribute *attributes,
+                            const int32_t num_attributes) {
+  Program program = { 0, { 0, 0 }, 0, PROGRAM_FAILED };
+  int32_t id = (int32_t)programs_.size();
+  if (vertex_source.empty() || fragment_source.empty()) {
+    programs_.push_back(program);
+    return id;
+  }
+
+  program.program = glCreateProgram();
+  if (cache_) {
+    program.key = cache_->MakeKey(vertex_source.c_str(),
+                                  fragment_source.c_str());
+    if (cache_->Load(program.program, program.key)) {
+      program.status = PROGRAM_READY;
+      programs_.push_back(program);
+      return id;
+    }
+  }
+
+  //Compiles, attribute bindings and the link go out back to back, a compile
+  //error shows up as a failed link
+  program.shaders[0] = StartShader(GL_VERTEX_SHADER, vertex_source);
+  program.shaders[1] = StartShader(GL_FRAGMENT_SHADER, fragment_source);
+  glAttachShader(program.program, program.shaders[0]);
+  glAttachShader(program.program, program.shaders[1]);
+  for (int32_t i = 0; i < num_attributes; ++i)
+    glBindAttribLocation(program.program, attributes[i].index,
+                         attributes[i].name);
+  if (cache_)
+    cache_->PrepareLink(program.program);
+  glLinkProgram(program.program);
+  program.status = PROGRAM_BUILDING;
+  programs_.push_back(program);
+  return id;
+}
+
+void ProgramBuilder::Finish(Program *program) {
+  //Compile logs before the link log, like the synchronous path
+  bool compiled = shader::CheckShader(program->shaders[0]);
+  compiled = shader::CheckShader(program->shaders[1]) && compiled;
+  bool linked = shader::CheckProgram(program->program);
+  for (int32_t i = 0; i < 2; ++i) {
+    glDeleteShader(program->shaders[i]);
+    program->shaders[i] = 0;
+  }
+
+  if (!compiled || !linked) {
+    LOGI("Failed to build program: %d", program->program);
+    state_->DeleteProgram(program->program);
+    program->program = 0;
+    program->status = PROGRAM_FAILED;
+    return;
+  }
+  if (cache_)
+    cache_->Store(program->program, program->key);
+  program->status = PROGRAM_READY;
+}
+
+ProgramStatus ProgramBuilder::GetStatus(const int32_t id) {
+  if (id < 0 || id >= (int32_t)programs_.size())
+    return PROGRAM_FAILED;
+
+  Program &program = programs_[id];
+  if (program.status == PROGRAM_BUILDING) {
+    if (parallel_) {
+      GLint completed = GL_FALSE;
+      glGetProgramiv(program.program, GL_COMPLETION_STATUS_KHR, &completed);
+      if (!completed)
+        return PROGRAM_BUILDING;
+    }
+    Finish(&program);
+  }
+  return program.status;
+}
+
+int32_t ProgramBuilder::GetNumReady() {
+  int32_t count = 0;
+  for (int32_t i = 0; i < (int32_t)programs_.size(); ++i) {
+    if (GetStatus(i) != PROGRAM_BUILDING)
+      ++count;
+  }
+  return count;
+}
+
+GLuint ProgramBuilder::GetProgram(const int32_t id) {
+  if (id < 0 || id >= (int32_t)programs_.size())
+    return 0;
+
+  Program &program = programs_[id];
+  if (program.status == PROGRAM_BUILDING)
+    Finish(&program);
+  return program.program;
+}
+
+} //namespace ndk_helper
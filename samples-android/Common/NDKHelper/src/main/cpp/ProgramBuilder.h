@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ProgramBuilder.h
+//--------------------------------------------------------------------------------
+#ifndef PROGRAMBUILDER_H_
+#define PROGRAMBUILDER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "GLState.h"
+#include "ProgramCache.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//glBindAttribLocation() of a program, before it is linked
+struct ProgramAttribute {
+  GLuint index;
+  const char *name;
+};
+
+enum ProgramStatus {
+  PROGRAM_BUILDING, //The driver is still compiling or linking
+  PROGRAM_READY,
+  PROGRAM_FAILED,
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Asynchronous program builder
+ * Add() issues the compiles and the link of a program and returns without
+ * asking GL about any of them, so the driver may work on all programs of a
+ * renderer at once. Status and info logs are only read once a program is
+ * needed, by GetStatus() or GetProgram().
+ *
+ * With GL_KHR_parallel_shader_compile (see
+ * GLContext::IsParallelShaderCompileSupported()) the driver builds on its own
+ * threads and GetStatus() polls GL_COMPLETION_STATUS_KHR without waiting, so
+ * a loading screen keeps animating until every program is ready. Without it,
+ * GetStatus() waits for the program like a synchronous compile would.
+ *
+ * Programs in the ProgramCache are loaded from their binary in Add() and are
+ * ready right away, the others are stored once they are linked.
+ *
+ *   builder.Init(state, cache, context->IsParallelShaderCompileSupported());
+ *   int32_t id = builder.Add(vertex_source, fragment_source, attributes, n);
+ *   ...every frame:
+ *   if (builder.GetStatus(id) == PROGRAM_READY)
+ *     state->UseProgram(builder.GetProgram(id));
+ *
+ * The builder owns its programs, Unload() deletes them.
+ */
+class ProgramBuilder {
+private:
+  struct Program {
+    GLuint program;
+    GLuint shaders[2]; //Vertex, fragment, until the link is checked
+    uint64_t key;      //Of the ProgramCache
+    ProgramStatus status;
+  };
+
+  GLState *state_;
+  ProgramCache *cache_;
+  bool parallel_;
+  std::vector<Program> programs_;
+
+  void Finish(Program *program);
+
+  ProgramBuilder(ProgramBuilder const &);
+  void operator=(ProgramBuilder const &);
+
+public:
+  ProgramBuilder();
+  virtual ~ProgramBuilder();
+
+  //cache may be NULL, parallel: GL_KHR_parallel_shader_compile is supported
+  void Init(GLState *state, ProgramCache *cache, const bool parallel);
+  //Deletes all programs
+  void Unload();
+
+  //Starts building a program of preprocessed sources, see ReadShader(). Id
+  //of the program, its status is PROGRAM_FAILED if a shader is empty
+  int32_t Add(const std::string &vertex_source,
+              const std::string &fragment_source,
+              const ProgramAttribute *attributes,
+              const int32_t num_attributes);
+
+  //Doesn't wait with parallel compiles
+  ProgramStatus GetStatus(const int32_t id);
+  //Programs of Add() whose status is no longer PROGRAM_BUILDING
+  int32_t GetNumReady();
+  int32_t GetNumPrograms() const { return (int32_t)programs_.size(); }
+  //Linked program of id, waits for it if it is building. 0 if it failed
+  GLuint GetProgram(const int32_t id);
+};
+
+} //namespace ndk_helper
+
+#endif /* PROGRAMBUILDER_H_ */
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ProgramCache.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "ProgramCache.h"
+#include "gl3stub.h"
+
+namespace ndk_helper {
+
+namespace {
+
+const uint32_t PROGRAM_CACHE_MAGIC = 0x42505448; //"HTPB"
+//Bump when the file layout changes
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+const char *const DRIVER_FILE_NAME = "driver";
+const char *const ENTRY_EXTENSION = ".bin";
+
+//Entry file, followed by the binary
+struct ProgramCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint64_t driver_hash;
+  uint64_t checksum; //Of the binary
+  uint32_t format;
+  uint32_t size;
+};
+
+bool ReadFile(const std::string &file_name, std::vector<uint8_t> *data) {
+  FILE *file = fopen(file_name.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  bool ret = false;
+  if (size >= 0) {
+    data->resize(size);
+    ret = fread(data->data(), 1, data->size(), file) == data->size();
+  }
+  fclose(file);
+  return ret;
+}
+
+//Written next to the file and renamed over it, a reader never sees a partial
+//file, e.g. of a process killed on the way
+bool WriteFile(const std::string &file_name, const void *header,
+               const size_t header_size, const void *data, const size_t size) {
+  std::string temp_name = file_name + ".tmp";
+  FILE *file = fopen(temp_name.c_str(), "wb");
+  if (file == NULL)
+    return false;
+  bool ret = fwrite(header, 1, header_size, file) == header_size &&
+             (size == 0 || fwrite(data, 1, size, file) == size);
+  ret = fclose(file) == 0 && ret;
+  if (ret)
+    ret = rename(temp_name.c_str(), file_name.c_str()) == 0;
+  if (!ret)
+    unlink(temp_name.c_str());
+  return ret;
+}
+
+const char *GetString(const GLenum name) {
+  const char *str = (const char *)glGetString(name);
+  return str ? str : "";
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ProgramCache::ProgramCache()
+    : driver_hash_(0), es3_(false), enabled_(false),
+      get_program_binary_(NULL), program_binary_(NULL) {
+  ResetCounters();
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+ProgramCache::~ProgramCache() {}
+
+void ProgramCache::SetDirectory(const char *directory) {
+  directory_ = directory ? directory : "";
+}
+
+bool ProgramCache::Init(const bool es3, const bool oes_program_binary) {
+  enabled_ = false;
+  es3_ = es3;
+  if (es3) {
+    get_program_binary_ = glGetProgramBinary;
+    program_binary_ = glProgramBinary;
+  } else if (oes_program_binary) {
+    get_program_binary_ = (GetProgramBinaryFunction)eglGetProcAddress(
+        "glGetProgramBinaryOES");
+    program_binary_ =
+        (ProgramBinaryFunction)eglGetProcAddress("glProgramBinaryOES");
+  } else {
+    get_program_binary_ = NULL;
+    program_binary_ = NULL;
+  }
+  if (get_program_binary_ == NULL || program_binary_ == NULL)
+    return false;
+
+  //Drivers may support the API without any format to save
+  GLint num_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+  if (num_formats <= 0)
+    return false;
+
+  path_ = directory_;
+#if defined(__ANDROID__)
+  if (path_.empty()) {
+    path_ = JNIHelper::GetInstance()->GetExternalFilesDir();
+    if (!path_.empty())
+      path_ = path_ + "/" + PROGRAM_CACHE_DIRECTORY;
+  }
+#endif
+  if (path_.empty())
+    return false;
+  mkdir(path_.c_str(), 0700);
+
+  driver_ = std::string(GetString(GL_VENDOR)) + "\n" + GetString(GL_RENDERER) +
+            "\n" + GetString(GL_VERSION) + "\n";
+  driver_hash_ = Hash(driver_.data(), driver_.size());
+
+  //Entries of another driver will never be loaded again
+  std::string driver_file = path_ + "/" + DRIVER_FILE_NAME;
+  std::vector<uint8_t> data;
+  if (!ReadFile(driver_file, &data) ||
+      std::string(data.begin(), data.end()) != driver_) {
+    Invalidate();
+    if (!WriteFile(driver_file, driver_.data(), driver_.size(), NULL, 0)) {
+      LOGI("Can not write a file:%s", driver_file.c_str());
+      return false;
+    }
+  }
+
+  enabled_ = true;
+  return true;
+}
+
+uint64_t ProgramCache::MakeKey(const char *vertex_source,
+                               const char *fragment_source) const {
+  //Lengths separate the sources, "ab"+"c" and "a"+"bc" differ
+  uint64_t sizes[2] = { strlen(vertex_source), strlen(fragment_source) };
+  uint64_t key = Hash(&driver_hash_, sizeof(driver_hash_));
+  key = Hash(sizes, sizeof(sizes), key);
+  key = Hash(vertex_source, sizes[0], key);
+  return Hash(fragment_source, sizes[1], key);
+}
+
+std::string ProgramCache::GetFileName(const uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx", (unsigned long long)key);
+  return path_ + name + ENTRY_EXTENSION;
+}
+
+bool ProgramCache::Load(const GLuint program, const uint64_t key) {
+  if (!enabled_)
+    return false;
+
+  std::string file_name = GetFileName(key);
+  std::vector<uint8_t> data;
+  if (!ReadFile(file_name, &data)) {
+    ++counters_.misses;
+    return false;
+  }
+
+  ProgramCacheHeader header;
+  bool valid = data.size() >= sizeof(header);
+  if (valid) {
+    memcpy(&header, data.data(), sizeof(header));
+    const uint8_t *binary = data.data() + sizeof(header);
+    valid = header.magic == PROGRAM_CACHE_MAGIC &&
+            header.version == PROGRAM_CACHE_VERSION && header.key == key &&
+            header.driver_hash == driver_hash_ &&
+            header.size == data.size() - sizeof(header) &&
+            header.checksum == Hash(binary, header.size);
+    if (valid) {
+      program_binary_(program, header.format, binary, header.size);
+      GLint status = 0;
+      glGetProgramiv(program, GL_LINK_STATUS, &status);
+      valid = status != 0;
+    }
+  }
+
+  if (!valid) {
+    //Stale or damaged, the program is compiled and stored again
+    LOGI("Rejected program binary:%s", file_name.c_str());
+    unlink(file_name.c_str());
+    ++counters_.rejected;
+    return false;
+  }
+  ++counters_.hits;
+  return true;
+}
+
+void ProgramCache::PrepareLink(const GLuint program) {
+  //The hint is core in ES3, the extension can always retrieve binaries
+  if (enabled_ && es3_)
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::Store(const GLuint program, const uint64_t key) {
+  if (!enabled_)
+    return false;
+
+  GLint size = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+  if (size <= 0)
+    return false;
+
+  std::vector<uint8_t> binary(size);
+  GLsizei length = 0;
+  GLenum format = 0;
+  get_program_binary_(program, size, &length, &format, binary.data());
+  if (length <= 0)
+    return false;
+
+  ProgramCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = PROGRAM_CACHE_MAGIC;
+  header.version = PROGRAM_CACHE_VERSION;
+  header.key = key;
+  header.driver_hash = driver_hash_;
+  header.checksum = Hash(binary.data(), length);
+  header.format = format;
+  header.size = length;
+
+  std::string file_name = GetFileName(key);
+  if (!WriteFile(file_name, &header, sizeof(header), binary.data(), length)) {
+    LOGI("Can not write a file:%s", file_name.c_str());
+    return false;
+  }
+  ++counters_.stores;
+  return true;
+}
+
+void ProgramCache::Clear() {
+  if (!path_.empty())
+    Invalidate();
+}
+
+void ProgramCache::Invalidate() {
+  DIR *dir = opendir(path_.c_str());
+  if (dir == NULL)
+    return;
+  const size_t extension_length = strlen(ENTRY_EXTENSION);
+  while (struct dirent *entry = readdir(dir)) {
+    size_t length = strlen(entry->d_name);
+    if (length > extension_length &&
+        strcmp(entry->d_name + length - extension_length, ENTRY_EXTENSION) ==
+            0)
+      unlink((path_ + "/" + entry->d_name).c_str());
+  }
+  closedir(dir);
+}
+
+void ProgramCache::ResetCounters() {
+  memset(&counters_, 0, sizeof(counters_));
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ProgramCache.h
+//--------------------------------------------------------------------------------
+#ifndef PROGRAMCACHE_H_
+#define PROGRAMCACHE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#if defined(__ANDROID__)
+#include <android/log.h>
+
+#include "JNIHelper.h"
+#else
+#include "vecmath.h"
+#endif
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Sub directory of GetExternalFilesDir() on Android
+const char *const PROGRAM_CACHE_DIRECTORY = "program_cache";
+
+struct ProgramCacheCounters {
+  uint32_t hits;
+  uint32_t misses;   //No cached binary
+  uint32_t rejected; //Cached binary the driver didn't take, or damaged
+  uint32_t stores;
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Program binary cache
+ * Linked programs are saved with glGetProgramBinary() (ES3) or
+ * glGetProgramBinaryOES() (GL_OES_get_program_binary) and loaded with
+ * glProgramBinary() the next time, skipping the compile and link of every
+ * shader on each InitDisplay()/resume.
+ *
+ * Entries are files named after a key: a hash of the preprocessed sources,
+ * so the defines patched in are part of it, and of the GL_VENDOR, GL_RENDERER
+ * and GL_VERSION strings. A driver update changes the key of every program,
+ * and Init() deletes the entries of any other driver it finds in the
+ * directory. A binary the driver rejects anyway, or a damaged file, is
+ * deleted and the program is compiled again.
+ *
+ * GLContext initializes the cache of each context, renderers use it through
+ * GLContext::GetProgramCache(). Programs of the same sources must be linked
+ * the same way, e.g. with the same attribute bindings, the key doesn't know
+ * about them. Uniform values and block bindings aren't part of a binary.
+ *
+ *   uint64_t key = cache->MakeKey(vertex_source, fragment_source);
+ *   GLuint program = glCreateProgram();
+ *   if (!cache->Load(program, key)) {
+ *     ...compile, attach, bind attributes...
+ *     cache->PrepareLink(program);
+ *     if (LinkProgram(program))
+ *       cache->Store(program, key);
+ *   }
+ */
+class ProgramCache {
+private:
+  typedef void(GL_APIENTRY *GetProgramBinaryFunction)(
+      GLuint program, GLsizei buf_size, GLsizei *length, GLenum *binary_format,
+      void *binary);
+  typedef void(GL_APIENTRY *ProgramBinaryFunction)(GLuint program,
+                                                   GLenum binary_format,
+                                                   const void *binary,
+                                                   GLsizei length);
+
+  std::string directory_; //Empty: the default, if any
+  std::string path_;      //Of Init()
+  std::string driver_;
+  uint64_t driver_hash_;
+  bool es3_;
+  bool enabled_;
+  GetProgramBinaryFunction get_program_binary_;
+  ProgramBinaryFunction program_binary_;
+  ProgramCacheCounters counters_;
+
+  std::string GetFileName(const uint64_t key) const;
+  void Invalidate();
+
+  ProgramCache(ProgramCache const &);
+  void operator=(ProgramCache const &);
+
+public:
+  ProgramCache();
+  virtual ~ProgramCache();
+
+  //Where entries go, taking effect with the next Init(). On Android the
+  //default is PROGRAM_CACHE_DIRECTORY in GetExternalFilesDir(), host builds
+  //have no default and stay disabled without one
+  void SetDirectory(const char *directory);
+  //Current context, es3: core program binaries, oes_program_binary: the
+  //extension is supported. False when the cache is disabled
+  bool Init(const bool es3, const bool oes_program_binary);
+  bool IsEnabled() const { return enabled_; }
+
+  //FNV-1a, hash continues a previous hash. Inline, the shader preprocessor
+  //keys variants with it without linking GL
+  static uint64_t Hash(const void *data, const size_t size,
+                       const uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t h = hash;
+    for (size_t i = 0; i < size; ++i) {
+      h ^= bytes[i];
+      h *= 0x100000001b3ull;
+    }
+    return h;
+  }
+  //Key of a program of the sources on the current driver
+  uint64_t MakeKey(const char *vertex_source,
+                   const char *fragment_source) const;
+
+  //Tries the cached binary of key on program, true if it is linked
+  bool Load(const GLuint program, const uint64_t key);
+  //Before linking a program to Store()
+  void PrepareLink(const GLuint program);
+  //Saves a linked program as the entry of key
+  bool Store(const GLuint program, const uint64_t key);
+  //Deletes all entries
+  void Clear();
+
+  const ProgramCacheCounters &GetCounters() const { return counters_; }
+  void ResetCounters();
+};
+
+} //namespace ndk_helper
+
+#endif /* PROGRAMCACHE_H_ */
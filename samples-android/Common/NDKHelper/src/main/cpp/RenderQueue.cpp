@@ -0,0 +1,173 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// RenderQueue.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include <string.h>
+#include "RenderQueue.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+RenderQueue::RenderQueue() { memset(&counters_, 0, sizeof(counters_)); }
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+RenderQueue::~RenderQueue() {}
+
+uint64_t RenderQueue::MakeKey(const RENDER_PASS pass, const uint32_t program,
+                              const uint32_t material, const float depth) {
+  //Bits of a non negative float compare like the float
+  uint32_t depth_bits = 0;
+  if (depth > 0.f)
+    memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+  uint64_t key = (uint64_t)(pass & 0xf) << 60;
+  if (pass == RENDER_PASS_TRANSPARENT)
+    return key | (uint64_t)(~depth_bits) << 28 |
+           (uint64_t)(program & 0xfff) << 16 | (material & 0xffff);
+  return key | (uint64_t)(program & 0xfff) << 48 |
+         (uint64_t)(material & 0xffff) << 32 | depth_bits;
+}
+
+void RenderQueue::Clear() {
+  packets_.clear();
+  entries_.clear();
+}
+
+void RenderQueue::Submit(const uint64_t key, const RenderPacket &packet) {
+  SortEntry entry = { key, (uint32_t)packets_.size() };
+  entries_.push_back(entry);
+  packets_.push_back(packet);
+}
+
+//--------------------------------------------------------------------------------
+// Sort
+// 8 passes of 8 bits, histograms of all passes are counted in one read
+//--------------------------------------------------------------------------------
+void RenderQueue::Sort() {
+  const size_t num_entries = entries_.size();
+  if (num_entries < 2)
+    return;
+
+  uint32_t histograms[8][256];
+  memset(histograms, 0, sizeof(histograms));
+  for (size_t i = 0; i < num_entries; ++i) {
+    uint64_t key = entries_[i].key;
+    for (int32_t byte = 0; byte < 8; ++byte)
+      ++histograms[byte][(key >> (byte * 8)) & 0xff];
+  }
+
+  scratch_.resize(num_entries);
+  SortEntry *src = &entries_[0];
+  SortEntry *dst = &scratch_[0];
+  for (int32_t byte = 0; byte < 8; ++byte) {
+    const int32_t shift = byte * 8;
+    uint32_t *histogram = histograms[byte];
+    //All keys share this byte, the order wouldn't change
+    if (histogram[(src[0].key >> shift) & 0xff] == num_entries)
+      continue;
+
+    uint32_t offset = 0;
+    for (int32_t i = 0; i < 256; ++i) {
+      uint32_t count = histogram[i];
+      histogram[i] = offset;
+      offset += count;
+    }
+    for (size_t i = 0; i < num_entries; ++i)
+      dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+
+    SortEntry *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != &entries_[0])
+    entries_.swap(scratch_);
+}
+
+//--------------------------------------------------------------------------------
+// Execute
+//--------------------------------------------------------------------------------
+void RenderQueue::ApplyMaterial(GLState *state, const RenderMaterial &material,
+                                const RenderMaterial *current) {
+  if (!current || current->program != material.program) {
+    state->UseProgram(material.program);
+    ++counters_.program_changes;
+  }
+
+  if (material.blend) {
+    state->Enable(GL_BLEND);
+    state->BlendFunc(material.blend_src, material.blend_dst);
+  } else {
+    state->Disable(GL_BLEND);
+  }
+  state->DepthMask(material.depth_write ? GL_TRUE : GL_FALSE);
+  if (material.cull_face)
+    state->Enable(GL_CULL_FACE);
+  else
+    state->Disable(GL_CULL_FACE);
+
+  if (material.apply)
+    material.apply(state, material.data);
+  ++counters_.material_changes;
+}
+
+void RenderQueue::Execute(GLState *state) {
+  memset(&counters_, 0, sizeof(counters_));
+
+  const RenderMaterial *material = NULL;
+  GLuint vertex_array = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const RenderPacket &packet = packets_[entries_[i].packet];
+    if (packet.material != material) {
+      ApplyMaterial(state, *packet.material, material);
+      material = packet.material;
+    }
+    if (packet.vertex_array != vertex_array || i == 0) {
+      state->BindVertexArray(packet.vertex_array);
+      vertex_array = packet.vertex_array;
+      ++counters_.vertex_array_changes;
+    }
+    if (packet.apply)
+      packet.apply(state, packet.data);
+
+    if (packet.index_type == GL_NONE) {
+      if (packet.num_instances > 1)
+        glDrawArraysInstanced(packet.mode, (GLint)packet.first, packet.count,
+                              packet.num_instances);
+      else
+        glDrawArrays(packet.mode, (GLint)packet.first, packet.count);
+    } else {
+      const void *indices = (const void *)packet.first;
+      if (packet.num_instances > 1)
+        glDrawElementsInstanced(packet.mode, packet.count, packet.index_type,
+                                indices, packet.num_instances);
+      else
+        glDrawElements(packet.mode, packet.count, packet.index_type, indices);
+    }
+  }
+  counters_.packets = (uint32_t)entries_.size();
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// RenderQueue.h
+//--------------------------------------------------------------------------------
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "GLState.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Passes are drawn in this order, 16 at most (4 bits of the sort key)
+enum RENDER_PASS {
+  RENDER_PASS_OPAQUE,      //Front to back within a material
+  RENDER_PASS_TRANSPARENT, //Back to front over all materials
+  RENDER_PASS_OVERLAY,     //By program and material, e.g. UI
+};
+
+//Sets uniforms, textures etc., data is the material's or the packet's
+typedef void (*RenderApplyFunc)(GLState *state, const void *data);
+
+/******************************************************************
+ * Render state shared by many draws: the program, blend/depth/cull settings
+ * and what apply() sets (uniforms, uniform buffers, textures of the
+ * material). Materials must stay alive until the queue is executed.
+ */
+struct RenderMaterial {
+  GLuint program;
+  bool blend;
+  GLenum blend_src;
+  GLenum blend_dst;
+  bool depth_write;
+  bool cull_face;
+  RenderApplyFunc apply; //May be NULL
+  const void *data;
+};
+
+//One draw, index_type GL_NONE draws count vertices from first, otherwise
+//count indices from byte offset first of the vertex array's element buffer
+struct RenderPacket {
+  const RenderMaterial *material;
+  GLuint vertex_array; //GLState::GenVertexArray()
+  GLenum mode;
+  GLsizei count;
+  GLenum index_type;
+  GLintptr first;
+  GLsizei num_instances; //Instanced draw if > 1, ES3 only
+  RenderApplyFunc apply; //Per object uniforms, may be NULL
+  const void *data;
+};
+
+//State changes of the last Execute()
+struct RenderQueueCounters {
+  uint32_t packets;
+  uint32_t program_changes;
+  uint32_t material_changes;
+  uint32_t vertex_array_changes;
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Sorted draw submission
+ * Renderers submit packets with a 64 bit sort key instead of drawing right
+ * away, Sort() orders all packets of the frame by key and Execute() draws
+ * them, changing program, material and vertex array only between packets
+ * that differ.
+ *
+ * MakeKey() packs, from the most significant bits:
+ *   opaque/overlay: pass:4 program:12 material:16 depth:32
+ *   transparent:    pass:4 depth:32 (inverted) program:12 material:16
+ * so opaque draws are grouped by program, then material and go front to back
+ * within a material, transparent draws go back to front. Program and
+ * material are sort ids, only their low bits are used; two ids sharing a
+ * key only cost extra state changes, Execute() compares the real objects.
+ *
+ * Sort() is an LSD radix sort of the keys, stable, so packets with equal
+ * keys keep their submission order. Bytes all keys have in common are
+ * skipped.
+ *
+ * Per frame:
+ *   queue.Clear();
+ *   queue.Submit(RenderQueue::MakeKey(...), packet);  //For each draw
+ *   queue.Sort();
+ *   queue.Execute(context->GetState());
+ */
+class RenderQueue {
+private:
+  struct SortEntry {
+    uint64_t key;
+    uint32_t packet;
+  };
+
+  std::vector<RenderPacket> packets_;
+  std::vector<SortEntry> entries_; //Submission order until Sort()
+  std::vector<SortEntry> scratch_;
+  RenderQueueCounters counters_;
+
+  void ApplyMaterial(GLState *state, const RenderMaterial &material,
+                     const RenderMaterial *current);
+
+  RenderQueue(RenderQueue const &);
+  void operator=(RenderQueue const &);
+
+public:
+  RenderQueue();
+  virtual ~RenderQueue();
+
+  //depth is the view space distance, >= 0
+  static uint64_t MakeKey(const RENDER_PASS pass, const uint32_t program,
+                          const uint32_t material, const float depth);
+
+  void Clear();
+  void Submit(const uint64_t key, const RenderPacket &packet);
+  void Sort();
+  //Draws the packets in key order, or submission order without Sort()
+  void Execute(GLState *state);
+
+  int32_t GetNumPackets() const { return (int32_t)packets_.size(); }
+  const RenderQueueCounters &GetCounters() const { return counters_; }
+};
+
+} //namespace ndk_helper
+
+#endif /* RENDERQUEUE_H_ */
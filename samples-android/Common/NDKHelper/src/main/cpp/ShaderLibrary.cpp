@@ -0,0 +1,139 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ShaderLibrary.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include "ShaderLibrary.h"
+#include "gl3stub.h"
+#include "shader.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ShaderLibrary::ShaderLibrary() {}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+ShaderLibrary::~ShaderLibrary() { Unload(); }
+
+void ShaderLibrary::Init(GLState *state, ProgramCache *cache,
+                         const bool parallel) {
+  Unload();
+  builder_.Init(state, cache, parallel);
+}
+
+void ShaderLibrary::Unload() {
+  builder_.Unload();
+  programs_.clear();
+  variants_.clear();
+  locations_.clear();
+}
+
+int32_t ShaderLibrary::AddProgram(const ShaderProgramDesc &desc) {
+  if (desc.num_options > SHADER_MAX_OPTIONS)
+    return -1;
+  programs_.push_back(desc);
+  return (int32_t)programs_.size() - 1;
+}
+
+ShaderHandle ShaderLibrary::Request(const int32_t program,
+                                    const uint32_t options) {
+  if (program < 0 || program >= (int32_t)programs_.size())
+    return SHADER_HANDLE_INVALID;
+  for (size_t i = 0; i < variants_.size(); ++i) {
+    if (variants_[i].program == program && variants_[i].options == options)
+      return (ShaderHandle)i;
+  }
+
+  const ShaderProgramDesc &desc = programs_[program];
+  ShaderDefines defines;
+  for (int32_t i = 0; i < desc.num_options; ++i) {
+    if (options & (1u << i))
+      defines[desc.options[i]] = "(1)";
+  }
+  std::string vsh, fsh;
+  if (!shader::ReadShader(desc.vertex_file, defines, &vsh) ||
+      !shader::ReadShader(desc.fragment_file, defines, &fsh)) {
+    LOGI("Failed to read shaders: %s %s", desc.vertex_file,
+         desc.fragment_file);
+    return SHADER_HANDLE_INVALID;
+  }
+
+  Variant variant;
+  variant.program = program;
+  variant.options = options;
+  variant.build_id = builder_.Add(vsh, fsh, desc.attributes,
+                                  desc.num_attributes);
+  variant.status = PROGRAM_BUILDING;
+  variant.gl_program = 0;
+  variant.first_uniform = (int32_t)locations_.size();
+  variant.first_attribute = variant.first_uniform + desc.num_uniforms;
+  locations_.resize(variant.first_attribute + desc.num_attributes, -1);
+  variants_.push_back(variant);
+  return (ShaderHandle)variants_.size() - 1;
+}
+
+void ShaderLibrary::Resolve(Variant *variant) {
+  const ShaderProgramDesc &desc = programs_[variant->program];
+  GLuint program = builder_.GetProgram(variant->build_id);
+  LOGI("Created Shader %d", program);
+
+  for (int32_t i = 0; i < desc.num_uniforms; ++i)
+    locations_[variant->first_uniform + i] =
+        glGetUniformLocation(program, desc.uniforms[i]);
+  for (int32_t i = 0; i < desc.num_attributes; ++i)
+    locations_[variant->first_attribute + i] =
+        glGetAttribLocation(program, desc.attributes[i].name);
+
+  //A block the variant doesn't use has no index
+  for (int32_t i = 0; i < desc.num_uniform_blocks; ++i) {
+    GLuint index = glGetUniformBlockIndex(program, desc.uniform_blocks[i]);
+    if (index != GL_INVALID_INDEX)
+      glUniformBlockBinding(program, index, i);
+  }
+  variant->gl_program = program;
+}
+
+ProgramStatus ShaderLibrary::GetStatus(const ShaderHandle handle) {
+  if (handle < 0 || handle >= (ShaderHandle)variants_.size())
+    return PROGRAM_FAILED;
+
+  Variant &variant = variants_[handle];
+  if (variant.status == PROGRAM_BUILDING) {
+    variant.status = builder_.GetStatus(variant.build_id);
+    if (variant.status == PROGRAM_READY)
+      Resolve(&variant);
+  }
+  return variant.status;
+}
+
+int32_t ShaderLibrary::GetNumReady() {
+  int32_t count = 0;
+  for (int32_t i = 0; i < (int32_t)variants_.size(); ++i) {
+    if (GetStatus(i) != PROGRAM_BUILDING)
+      ++count;
+  }
+  return count;
+}
+
+} //namespace ndk_helper
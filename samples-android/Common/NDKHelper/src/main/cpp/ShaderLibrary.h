@@ -0,0 +1,151 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// ShaderLibrary.h
+//--------------------------------------------------------------------------------
+#ifndef SHADERLIBRARY_H_
+#define SHADERLIBRARY_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "GLState.h"
+#include "ProgramBuilder.h"
+#include "ProgramCache.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Options of a program, bits of a variant
+const int32_t SHADER_MAX_OPTIONS = 32;
+
+//Variant of a ShaderLibrary, from Request()
+typedef int32_t ShaderHandle;
+const ShaderHandle SHADER_HANDLE_INVALID = -1;
+
+/******************************************************************
+ * A program of a ShaderLibrary: its files, the options its variants may
+ * turn on, and the names the renderer looks up, each list indexed by an enum
+ * of the renderer. The arrays must outlive the library, e.g. static tables.
+ */
+struct ShaderProgramDesc {
+  const char *vertex_file;
+  const char *fragment_file;
+  //Bit i of a variant defines options[i] as (1) in both shaders
+  const char *const *options;
+  int32_t num_options;
+  //Bound before linking, GetAttribute() tells which a variant uses
+  const ProgramAttribute *attributes;
+  int32_t num_attributes;
+  const char *const *uniforms;
+  int32_t num_uniforms;
+  //ES3, block i is bound to uniform buffer binding point i
+  const char *const *uniform_blocks;
+  int32_t num_uniform_blocks;
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Shader variant library
+ * Builds the variants of declared programs at load time and resolves their
+ * locations once, when a variant is ready. Draws then look a location up
+ * by handle and enum in a flat table, without glGetUniformLocation() or any
+ * other GL call:
+ *
+ *   enum { UNIFORM_MVP, UNIFORM_COLOR, UNIFORM_COUNT };
+ *   static const char *const UNIFORMS[UNIFORM_COUNT] = { "uMVP", "uColor" };
+ *   int32_t program = library.AddProgram(desc);
+ *   ShaderHandle plain = library.Request(program, 0);
+ *   ShaderHandle skinned = library.Request(program, OPTION_SKINNING);
+ *   ...every frame:
+ *   if (library.GetStatus(skinned) == PROGRAM_READY) {
+ *     state->UseProgram(library.GetProgram(skinned));
+ *     state->Uniform4f(library.GetUniform(skinned, UNIFORM_COLOR), ...);
+ *   }
+ *
+ * Variants are built by a ProgramBuilder, in parallel where the driver can,
+ * and go through the ProgramCache. A location a variant doesn't use is -1.
+ */
+class ShaderLibrary {
+private:
+  struct Variant {
+    int32_t program; //Of programs_
+    uint32_t options;
+    int32_t build_id; //Of builder_
+    ProgramStatus status;
+    GLuint gl_program; //0 until ready
+    //Uniforms, then attributes in locations_
+    int32_t first_uniform;
+    int32_t first_attribute;
+  };
+
+  ProgramBuilder builder_;
+  std::vector<ShaderProgramDesc> programs_;
+  std::vector<Variant> variants_;
+  std::vector<GLint> locations_;
+
+  void Resolve(Variant *variant);
+
+  ShaderLibrary(ShaderLibrary const &);
+  void operator=(ShaderLibrary const &);
+
+public:
+  ShaderLibrary();
+  virtual ~ShaderLibrary();
+
+  //cache may be NULL, parallel: GL_KHR_parallel_shader_compile is supported
+  void Init(GLState *state, ProgramCache *cache, const bool parallel);
+  //Deletes all programs and forgets the descriptions
+  void Unload();
+
+  //Id of the program of desc, -1 with too many options
+  int32_t AddProgram(const ShaderProgramDesc &desc);
+  //Starts building the variant of options, bits of desc.options. Requesting
+  //a variant again returns the same handle. SHADER_HANDLE_INVALID if its
+  //files can't be read
+  ShaderHandle Request(const int32_t program, const uint32_t options);
+
+  //Doesn't wait with parallel compiles, resolves the locations of a variant
+  //that just got ready
+  ProgramStatus GetStatus(const ShaderHandle handle);
+  //Variants whose status is no longer PROGRAM_BUILDING
+  int32_t GetNumReady();
+  int32_t GetNumVariants() const { return (int32_t)variants_.size(); }
+
+  //Lookups of a handle of Request(), no GL calls. 0 and -1 until GetStatus()
+  //returned PROGRAM_READY
+  GLuint GetProgram(const ShaderHandle handle) const {
+    return variants_[handle].gl_program;
+  }
+  GLint GetUniform(const ShaderHandle handle, const int32_t uniform) const {
+    return locations_[variants_[handle].first_uniform + uniform];
+  }
+  GLint GetAttribute(const ShaderHandle handle,
+                     const int32_t attribute) const {
+    return locations_[variants_[handle].first_attribute + attribute];
+  }
+};
+
+} //namespace ndk_helper
+
+#endif /* SHADERLIBRARY_H_ */
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// UniformBuffer.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include <string.h>
+#include "UniformBuffer.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// UniformBuffer
+//--------------------------------------------------------------------------------
+UniformBuffer::UniformBuffer() : state_(NULL), buffer_(0), uploaded_(false) {}
+
+UniformBuffer::~UniformBuffer() { Unload(); }
+
+bool UniformBuffer::Init(GLState *state, const size_t size) {
+  Unload();
+  state_ = state;
+  data_.assign(size, 0);
+  uploaded_ = false;
+
+  glGenBuffers(1, &buffer_);
+  state_->BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+  return buffer_ != 0;
+}
+
+void UniformBuffer::Unload() {
+  if (buffer_) {
+    state_->DeleteBuffer(buffer_);
+    buffer_ = 0;
+  }
+  data_.clear();
+}
+
+bool UniformBuffer::Update(const void *data) {
+  if (uploaded_ && memcmp(&data_[0], data, data_.size()) == 0)
+    return false;
+  memcpy(&data_[0], data, data_.size());
+  uploaded_ = true;
+
+  state_->BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, data_.size(), &data_[0]);
+  return true;
+}
+
+void UniformBuffer::Bind(const GLuint binding) {
+  state_->BindBufferBase(GL_UNIFORM_BUFFER, binding, buffer_);
+}
+
+//--------------------------------------------------------------------------------
+// UniformRingBuffer
+//--------------------------------------------------------------------------------
+UniformRingBuffer::UniformRingBuffer()
+    : state_(NULL), buffer_(0), block_size_(0), block_stride_(0),
+      blocks_per_frame_(0), num_frames_(0), frame_(0), num_blocks_(0) {}
+
+UniformRingBuffer::~UniformRingBuffer() { Unload(); }
+
+bool UniformRingBuffer::Init(GLState *state, const size_t block_size,
+                             const int32_t blocks_per_frame,
+                             const int32_t num_frames) {
+  Unload();
+  state_ = state;
+
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment <= 0)
+    alignment = 256; //Largest alignment seen in practice
+  block_size_ = block_size;
+  block_stride_ = (block_size + alignment - 1) / alignment * alignment;
+  blocks_per_frame_ = blocks_per_frame;
+  num_frames_ = num_frames;
+  frame_ = 0;
+  num_blocks_ = 0;
+  data_.assign(block_stride_ * blocks_per_frame, 0);
+
+  glGenBuffers(1, &buffer_);
+  state_->BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, data_.size() * num_frames, NULL,
+               GL_DYNAMIC_DRAW);
+  return buffer_ != 0;
+}
+
+void UniformRingBuffer::Unload() {
+  if (buffer_) {
+    state_->DeleteBuffer(buffer_);
+    buffer_ = 0;
+  }
+  data_.clear();
+  blocks_per_frame_ = 0;
+  num_frames_ = 0;
+  frame_ = 0;
+  num_blocks_ = 0;
+}
+
+void UniformRingBuffer::BeginFrame() {
+  //Not initialized, Allocate() fails
+  if (num_frames_ == 0)
+    return;
+  frame_ = (frame_ + 1) % num_frames_;
+  num_blocks_ = 0;
+}
+
+GLintptr UniformRingBuffer::Allocate(const void *data) {
+  if (buffer_ == 0 || num_blocks_ >= blocks_per_frame_)
+    return -1;
+  size_t offset = num_blocks_++ * block_stride_;
+  memcpy(&data_[offset], data, block_size_);
+  return frame_ * data_.size() + offset;
+}
+
+void UniformRingBuffer::EndFrame() {
+  if (num_blocks_ == 0)
+    return;
+  //Padding after the last block isn't needed
+  size_t size = (num_blocks_ - 1) * block_stride_ + block_size_;
+  state_->BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferSubData(GL_UNIFORM_BUFFER, frame_ * data_.size(), size, &data_[0]);
+}
+
+void UniformRingBuffer::Bind(const GLuint binding, const GLintptr offset) {
+  state_->BindBufferRange(GL_UNIFORM_BUFFER, binding, buffer_, offset,
+                          block_size_);
+}
+
+} //namespace ndk_helper
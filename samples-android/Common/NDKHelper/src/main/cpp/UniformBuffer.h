@@ -0,0 +1,117 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// UniformBuffer.h
+//--------------------------------------------------------------------------------
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "GLState.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Uniform buffer of one std140 block, ES3 only
+ * Keeps a copy of the block and only uploads it when Update() gets different
+ * contents, so constants that rarely change (e.g. materials) cost a compare
+ * per frame, and constants written once per frame cost one upload.
+ *
+ * Bindings go through the GLState of the context, binding the same buffer to
+ * the same point every frame doesn't reach GL.
+ */
+class UniformBuffer {
+private:
+  GLState *state_;
+  GLuint buffer_;
+  std::vector<uint8_t> data_; //Contents of buffer_
+  bool uploaded_;
+
+  UniformBuffer(UniformBuffer const &);
+  void operator=(UniformBuffer const &);
+
+public:
+  UniformBuffer();
+  virtual ~UniformBuffer();
+
+  bool Init(GLState *state, const size_t size);
+  void Unload();
+
+  //data is a whole block, returns false if it was unchanged
+  bool Update(const void *data);
+  void Bind(const GLuint binding);
+
+  GLuint GetBuffer() const { return buffer_; }
+};
+
+/******************************************************************
+ * Ring buffer of per object std140 blocks, ES3 only
+ * Each frame writes its blocks into the next of num_frames segments with one
+ * upload, draws bind their block with an offset (glBindBufferRange). The GPU
+ * may still read the segments of previous frames, writing a different one
+ * doesn't wait for it.
+ *
+ * Per frame:
+ *   ring.BeginFrame();
+ *   offset[i] = ring.Allocate(&block[i]);  //For each object
+ *   ring.EndFrame();
+ *   ring.Bind(binding, offset[i]);         //Before each draw
+ */
+class UniformRingBuffer {
+private:
+  GLState *state_;
+  GLuint buffer_;
+  std::vector<uint8_t> data_; //Blocks of the current frame
+  size_t block_size_;
+  size_t block_stride_; //GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT aligned
+  int32_t blocks_per_frame_;
+  int32_t num_frames_;
+  int32_t frame_;
+  int32_t num_blocks_; //Allocated in the current frame
+
+  UniformRingBuffer(UniformRingBuffer const &);
+  void operator=(UniformRingBuffer const &);
+
+public:
+  UniformRingBuffer();
+  virtual ~UniformRingBuffer();
+
+  //num_frames: frames the GPU may lag behind, plus the one being written
+  bool Init(GLState *state, const size_t block_size,
+            const int32_t blocks_per_frame, const int32_t num_frames = 3);
+  void Unload();
+
+  void BeginFrame();
+  //Copies a block into the current frame, returns its offset for Bind() or
+  //-1 when the frame is full or the ring isn't initialized
+  GLintptr Allocate(const void *data);
+  //Uploads the blocks of the frame, call before the draws using them
+  void EndFrame();
+  void Bind(const GLuint binding, const GLintptr offset);
+};
+
+} //namespace ndk_helper
+
+#endif /* UNIFORMBUFFER_H_ */
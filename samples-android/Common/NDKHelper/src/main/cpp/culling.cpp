@@ -0,0 +1,316 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// culling.cpp
+//--------------------------------------------------------------------------------
+#include "culling.h"
+#include "vecmath_simd.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// BoundingBox
+//--------------------------------------------------------------------------------
+BoundingBox BoundingBox::FromPoints(const float *positions,
+                                    const int32_t stride, const int32_t count) {
+  Vec3 vec_min(positions);
+  Vec3 vec_max(positions);
+  for (int32_t i = 1; i < count; ++i) {
+    const float *p = positions + i * stride;
+    vec_min.x_ = p[0] < vec_min.x_ ? p[0] : vec_min.x_;
+    vec_min.y_ = p[1] < vec_min.y_ ? p[1] : vec_min.y_;
+    vec_min.z_ = p[2] < vec_min.z_ ? p[2] : vec_min.z_;
+    vec_max.x_ = p[0] > vec_max.x_ ? p[0] : vec_max.x_;
+    vec_max.y_ = p[1] > vec_max.y_ ? p[1] : vec_max.y_;
+    vec_max.z_ = p[2] > vec_max.z_ ? p[2] : vec_max.z_;
+  }
+  return FromMinMax(vec_min, vec_max);
+}
+
+BoundingBox BoundingBox::Transform(const Mat4 &mat) const {
+  //Center moves as a point, the extent picks up the absolute value of the
+  //upper 3x3 so the result still encloses every corner
+  const float *f = mat.f_;
+  BoundingBox ret;
+  ret.center_.x_ =
+      f[0] * center_.x_ + f[4] * center_.y_ + f[8] * center_.z_ + f[12];
+  ret.center_.y_ =
+      f[1] * center_.x_ + f[5] * center_.y_ + f[9] * center_.z_ + f[13];
+  ret.center_.z_ =
+      f[2] * center_.x_ + f[6] * center_.y_ + f[10] * center_.z_ + f[14];
+  ret.extent_.x_ = fabsf(f[0]) * extent_.x_ + fabsf(f[4]) * extent_.y_ +
+                   fabsf(f[8]) * extent_.z_;
+  ret.extent_.y_ = fabsf(f[1]) * extent_.x_ + fabsf(f[5]) * extent_.y_ +
+                   fabsf(f[9]) * extent_.z_;
+  ret.extent_.z_ = fabsf(f[2]) * extent_.x_ + fabsf(f[6]) * extent_.y_ +
+                   fabsf(f[10]) * extent_.z_;
+  return ret;
+}
+
+//--------------------------------------------------------------------------------
+// Frustum
+//--------------------------------------------------------------------------------
+Frustum::Frustum() {
+  for (int32_t i = 0; i < NUM_PLANES_PADDED; ++i) {
+    a_[i] = b_[i] = c_[i] = 0.f;
+    abs_a_[i] = abs_b_[i] = abs_c_[i] = 0.f;
+    d_[i] = 1.f;
+  }
+}
+
+Frustum::Frustum(const Mat4 &clip) { Set(clip); }
+
+void Frustum::Set(const Mat4 &clip) {
+  //Gribb/Hartmann: with clip = M * v, the planes are row3 +- row0..2 of M.
+  //Mat4 is column major, row i is f_[i], f_[4 + i], f_[8 + i], f_[12 + i]
+  const float *f = clip.f_;
+  for (int32_t i = 0; i < NUM_PLANES; ++i) {
+    const int32_t row = i / 2;
+    const float sign = (i & 1) ? -1.f : 1.f;
+    float a = f[3] + sign * f[row];
+    float b = f[7] + sign * f[4 + row];
+    float c = f[11] + sign * f[8 + row];
+    float d = f[15] + sign * f[12 + row];
+
+    float len = sqrtf(a * a + b * b + c * c);
+    if (len > 0.f) {
+      float inv = 1.f / len;
+      a *= inv;
+      b *= inv;
+      c *= inv;
+      d *= inv;
+    }
+    a_[i] = a;
+    b_[i] = b;
+    c_[i] = c;
+    d_[i] = d;
+    abs_a_[i] = fabsf(a);
+    abs_b_[i] = fabsf(b);
+    abs_c_[i] = fabsf(c);
+  }
+  for (int32_t i = NUM_PLANES; i < NUM_PLANES_PADDED; ++i) {
+    a_[i] = b_[i] = c_[i] = 0.f;
+    abs_a_[i] = abs_b_[i] = abs_c_[i] = 0.f;
+    d_[i] = 1.f;
+  }
+}
+
+Vec4 Frustum::GetPlane(const int32_t index) const {
+  return Vec4(a_[index], b_[index], c_[index], d_[index]);
+}
+
+bool Frustum::IsVisible(const BoundingBox &box) const {
+  const Vec3 &c = box.center_;
+  const Vec3 &e = box.extent_;
+  for (int32_t i = 0; i < NUM_PLANES; ++i) {
+    //Signed distance of the box corner furthest along the plane normal,
+    //summed in the same order as the SIMD paths
+    float dist = d_[i] + a_[i] * c.x_ + b_[i] * c.y_ + c_[i] * c.z_ +
+                 abs_a_[i] * e.x_ + abs_b_[i] * e.y_ + abs_c_[i] * e.z_;
+    if (dist < 0.f)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::IsVisible(const BoundingSphere &sphere) const {
+  const Vec3 &c = sphere.center_;
+  for (int32_t i = 0; i < NUM_PLANES; ++i) {
+    float dist =
+        (d_[i] + sphere.radius_) + a_[i] * c.x_ + b_[i] * c.y_ + c_[i] * c.z_;
+    if (dist < 0.f)
+      return false;
+  }
+  return true;
+}
+
+int32_t Frustum::Cull(const BoundingBox *boxes, const int32_t count,
+                      int32_t *visible_indices) const {
+  int32_t num_visible = 0;
+#if defined(NDK_HELPER_SIMD)
+  //One box per step, planes 0-3 and 4-7 in the two halves
+  const simd::float4 a0 = simd::Load(a_), a1 = simd::Load(a_ + 4);
+  const simd::float4 b0 = simd::Load(b_), b1 = simd::Load(b_ + 4);
+  const simd::float4 c0 = simd::Load(c_), c1 = simd::Load(c_ + 4);
+  const simd::float4 d0 = simd::Load(d_), d1 = simd::Load(d_ + 4);
+  const simd::float4 aa0 = simd::Load(abs_a_), aa1 = simd::Load(abs_a_ + 4);
+  const simd::float4 ab0 = simd::Load(abs_b_), ab1 = simd::Load(abs_b_ + 4);
+  const simd::float4 ac0 = simd::Load(abs_c_), ac1 = simd::Load(abs_c_ + 4);
+  const simd::float4 zero = simd::Splat(0.f);
+  for (int32_t i = 0; i < count; ++i) {
+    const Vec3 &center = boxes[i].center_;
+    const Vec3 &extent = boxes[i].extent_;
+    simd::float4 x = simd::Splat(center.x_);
+    simd::float4 y = simd::Splat(center.y_);
+    simd::float4 z = simd::Splat(center.z_);
+    simd::float4 ex = simd::Splat(extent.x_);
+    simd::float4 ey = simd::Splat(extent.y_);
+    simd::float4 ez = simd::Splat(extent.z_);
+
+    simd::float4 dist0 = simd::MulAdd(d0, a0, x);
+    dist0 = simd::MulAdd(dist0, b0, y);
+    dist0 = simd::MulAdd(dist0, c0, z);
+    dist0 = simd::MulAdd(dist0, aa0, ex);
+    dist0 = simd::MulAdd(dist0, ab0, ey);
+    dist0 = simd::MulAdd(dist0, ac0, ez);
+    simd::float4 dist1 = simd::MulAdd(d1, a1, x);
+    dist1 = simd::MulAdd(dist1, b1, y);
+    dist1 = simd::MulAdd(dist1, c1, z);
+    dist1 = simd::MulAdd(dist1, aa1, ex);
+    dist1 = simd::MulAdd(dist1, ab1, ey);
+    dist1 = simd::MulAdd(dist1, ac1, ez);
+
+    //Branchless compaction, the slot is overwritten when the box is culled.
+    //Culled below 0 like IsVisible(), -0 and NaN distances don't cull
+    simd::float4 culled = simd::Or(simd::CmpLt(dist0, zero),
+                                   simd::CmpLt(dist1, zero));
+    visible_indices[num_visible] = i;
+    num_visible += simd::SignMask(culled) == 0;
+  }
+#else
+  for (int32_t i = 0; i < count; ++i) {
+    visible_indices[num_visible] = i;
+    num_visible += IsVisible(boxes[i]);
+  }
+#endif
+  return num_visible;
+}
+
+int32_t Frustum::Cull(const BoundingSphere *spheres, const int32_t count,
+                      int32_t *visible_indices) const {
+  int32_t num_visible = 0;
+#if defined(NDK_HELPER_SIMD)
+  const simd::float4 a0 = simd::Load(a_), a1 = simd::Load(a_ + 4);
+  const simd::float4 b0 = simd::Load(b_), b1 = simd::Load(b_ + 4);
+  const simd::float4 c0 = simd::Load(c_), c1 = simd::Load(c_ + 4);
+  const simd::float4 d0 = simd::Load(d_), d1 = simd::Load(d_ + 4);
+  const simd::float4 zero = simd::Splat(0.f);
+  for (int32_t i = 0; i < count; ++i) {
+    const Vec3 &center = spheres[i].center_;
+    simd::float4 x = simd::Splat(center.x_);
+    simd::float4 y = simd::Splat(center.y_);
+    simd::float4 z = simd::Splat(center.z_);
+    simd::float4 r = simd::Splat(spheres[i].radius_);
+
+    simd::float4 dist0 = simd::MulAdd(simd::Add(d0, r), a0, x);
+    dist0 = simd::MulAdd(dist0, b0, y);
+    dist0 = simd::MulAdd(dist0, c0, z);
+    simd::float4 dist1 = simd::MulAdd(simd::Add(d1, r), a1, x);
+    dist1 = simd::MulAdd(dist1, b1, y);
+    dist1 = simd::MulAdd(dist1, c1, z);
+
+    simd::float4 culled = simd::Or(simd::CmpLt(dist0, zero),
+                                   simd::CmpLt(dist1, zero));
+    visible_indices[num_visible] = i;
+    num_visible += simd::SignMask(culled) == 0;
+  }
+#else
+  for (int32_t i = 0; i < count; ++i) {
+    visible_indices[num_visible] = i;
+    num_visible += IsVisible(spheres[i]);
+  }
+#endif
+  return num_visible;
+}
+
+int32_t Frustum::CullBoxes(const float *center_x, const float *center_y,
+                           const float *center_z, const float *extent_x,
+                           const float *extent_y, const float *extent_z,
+                           const int32_t count,
+                           int32_t *visible_indices) const {
+  int32_t num_visible = 0;
+  int32_t i = 0;
+#if defined(NDK_HELPER_SIMD)
+  //Four boxes per step, one plane at a time
+  const simd::float4 zero = simd::Splat(0.f);
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x = simd::Load(center_x + i);
+    simd::float4 y = simd::Load(center_y + i);
+    simd::float4 z = simd::Load(center_z + i);
+    simd::float4 ex = simd::Load(extent_x + i);
+    simd::float4 ey = simd::Load(extent_y + i);
+    simd::float4 ez = simd::Load(extent_z + i);
+
+    //Lanes below 0 on any plane are culled, like IsVisible()
+    simd::float4 culled = zero;
+    for (int32_t p = 0; p < NUM_PLANES; ++p) {
+      simd::float4 dist =
+          simd::MulAdd(simd::Splat(d_[p]), simd::Splat(a_[p]), x);
+      dist = simd::MulAdd(dist, simd::Splat(b_[p]), y);
+      dist = simd::MulAdd(dist, simd::Splat(c_[p]), z);
+      dist = simd::MulAdd(dist, simd::Splat(abs_a_[p]), ex);
+      dist = simd::MulAdd(dist, simd::Splat(abs_b_[p]), ey);
+      dist = simd::MulAdd(dist, simd::Splat(abs_c_[p]), ez);
+      culled = simd::Or(culled, simd::CmpLt(dist, zero));
+    }
+
+    int32_t culled_lanes = simd::SignMask(culled);
+    for (int32_t lane = 0; lane < 4; ++lane) {
+      visible_indices[num_visible] = i + lane;
+      num_visible += ((culled_lanes >> lane) & 1) ^ 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    BoundingBox box(Vec3(center_x[i], center_y[i], center_z[i]),
+                    Vec3(extent_x[i], extent_y[i], extent_z[i]));
+    visible_indices[num_visible] = i;
+    num_visible += IsVisible(box);
+  }
+  return num_visible;
+}
+
+int32_t Frustum::CullSpheres(const float *center_x, const float *center_y,
+                             const float *center_z, const float *radius,
+                             const int32_t count,
+                             int32_t *visible_indices) const {
+  int32_t num_visible = 0;
+  int32_t i = 0;
+#if defined(NDK_HELPER_SIMD)
+  const simd::float4 zero = simd::Splat(0.f);
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x = simd::Load(center_x + i);
+    simd::float4 y = simd::Load(center_y + i);
+    simd::float4 z = simd::Load(center_z + i);
+    simd::float4 r = simd::Load(radius + i);
+
+    simd::float4 culled = zero;
+    for (int32_t p = 0; p < NUM_PLANES; ++p) {
+      simd::float4 dist = simd::MulAdd(simd::Add(simd::Splat(d_[p]), r),
+                                       simd::Splat(a_[p]), x);
+      dist = simd::MulAdd(dist, simd::Splat(b_[p]), y);
+      dist = simd::MulAdd(dist, simd::Splat(c_[p]), z);
+      culled = simd::Or(culled, simd::CmpLt(dist, zero));
+    }
+
+    int32_t culled_lanes = simd::SignMask(culled);
+    for (int32_t lane = 0; lane < 4; ++lane) {
+      visible_indices[num_visible] = i + lane;
+      num_visible += ((culled_lanes >> lane) & 1) ^ 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    BoundingSphere sphere(Vec3(center_x[i], center_y[i], center_z[i]),
+                          radius[i]);
+    visible_indices[num_visible] = i;
+    num_visible += IsVisible(sphere);
+  }
+  return num_visible;
+}
+
+}      //namespace ndk_helper
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CULLING_H_
+#define CULLING_H_
+
+#include <stdint.h>
+#include "vecmath.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Axis aligned bounding box, stored as center and half extent
+ *
+ */
+class BoundingBox {
+private:
+  Vec3 center_;
+  Vec3 extent_;
+
+public:
+  friend class Frustum;
+
+  BoundingBox() {}
+
+  BoundingBox(const Vec3 &center, const Vec3 &extent)
+      : center_(center), extent_(extent) {}
+
+  static BoundingBox FromMinMax(const Vec3 &vec_min, const Vec3 &vec_max) {
+    return BoundingBox((vec_min + vec_max) * 0.5f, (vec_max - vec_min) * 0.5f);
+  }
+
+  //Smallest box enclosing the points, count must be > 0
+  static BoundingBox FromPoints(const float *positions, const int32_t stride,
+                                const int32_t count);
+
+  //Axis aligned box enclosing this box transformed by mat
+  BoundingBox Transform(const Mat4 &mat) const;
+
+  const Vec3 &GetCenter() const { return center_; }
+  const Vec3 &GetExtent() const { return extent_; }
+};
+
+/******************************************************************
+ * Bounding sphere
+ *
+ */
+class BoundingSphere {
+private:
+  Vec3 center_;
+  float radius_;
+
+public:
+  friend class Frustum;
+
+  BoundingSphere() : radius_(0.f) {}
+
+  BoundingSphere(const Vec3 &center, const float radius)
+      : center_(center), radius_(radius) {}
+
+  const Vec3 &GetCenter() const { return center_; }
+  float GetRadius() const { return radius_; }
+};
+
+/******************************************************************
+ * View frustum and visibility tests
+ * Planes are extracted from a clip matrix (projection * view, optionally
+ * * model), bounding volumes are tested in the space that matrix maps from.
+ *
+ * Tests are conservative: a volume is reported visible unless it is fully
+ * outside one of the planes, so a few volumes near the frustum corners are
+ * kept even though they are not on screen.
+ *
+ * Cull() functions write the indices of visible volumes to visible_indices
+ * in increasing order and return how many were written. visible_indices must
+ * have room for count entries.
+ */
+class Frustum {
+private:
+  enum {
+    PLANE_LEFT,
+    PLANE_RIGHT,
+    PLANE_BOTTOM,
+    PLANE_TOP,
+    PLANE_NEAR,
+    PLANE_FAR,
+    NUM_PLANES,
+    //Padded so SIMD code tests 4 planes at a time. Padding planes are
+    //0x + 0y + 0z + 1 and never reject anything
+    NUM_PLANES_PADDED = 8,
+  };
+
+  //Normalized planes a x + b y + c z + d >= 0 inside, structure of arrays
+  float a_[NUM_PLANES_PADDED];
+  float b_[NUM_PLANES_PADDED];
+  float c_[NUM_PLANES_PADDED];
+  float d_[NUM_PLANES_PADDED];
+  float abs_a_[NUM_PLANES_PADDED];
+  float abs_b_[NUM_PLANES_PADDED];
+  float abs_c_[NUM_PLANES_PADDED];
+
+public:
+  Frustum();
+  explicit Frustum(const Mat4 &clip);
+
+  void Set(const Mat4 &clip);
+
+  //Plane as (a, b, c, d), index in [0, 6): left, right, bottom, top, near, far
+  Vec4 GetPlane(const int32_t index) const;
+
+  bool IsVisible(const BoundingBox &box) const;
+  bool IsVisible(const BoundingSphere &sphere) const;
+
+  int32_t Cull(const BoundingBox *boxes, const int32_t count,
+               int32_t *visible_indices) const;
+  int32_t Cull(const BoundingSphere *spheres, const int32_t count,
+               int32_t *visible_indices) const;
+
+  //Structure of arrays variants, 4 volumes per SIMD step
+  int32_t CullBoxes(const float *center_x, const float *center_y,
+                    const float *center_z, const float *extent_x,
+                    const float *extent_y, const float *extent_z,
+                    const int32_t count, int32_t *visible_indices) const;
+  int32_t CullSpheres(const float *center_x, const float *center_y,
+                      const float *center_z, const float *radius,
+                      const int32_t count, int32_t *visible_indices) const;
+};
+
+}      //namespace ndk_helper
+#endif /* CULLING_H_ */
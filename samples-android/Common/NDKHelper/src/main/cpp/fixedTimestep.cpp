@@ -0,0 +1,85 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// fixedTimestep.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include "fixedTimestep.h"
+
+namespace ndk_helper {
+
+namespace {
+//Clock jitter below this doesn't move a step to the next frame, frames of
+//exactly one step apart would otherwise alternate between 0 and 2 steps
+const double STEP_TOLERANCE = 1e-6;
+}
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+FixedTimestep::FixedTimestep(const double rate, const int32_t max_steps)
+    : step_(1.0 / rate), max_steps_(max_steps), time_(0.0),
+      dropped_steps_(0) {
+  Reset();
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+FixedTimestep::~FixedTimestep() {}
+
+void FixedTimestep::Reset() {
+  last_time_ = -1.0;
+  accumulator_ = 0.0;
+  steps_ = 0;
+}
+
+int32_t FixedTimestep::Advance(const double time) {
+  //The first frame runs one step to have a state to render
+  if (last_time_ < 0.0) {
+    last_time_ = time;
+    accumulator_ = 0.0;
+    time_ += step_;
+    steps_ = 1;
+    return steps_;
+  }
+
+  double elapsed = time - last_time_;
+  last_time_ = time;
+  if (elapsed > 0.0)
+    accumulator_ += elapsed;
+
+  steps_ = 0;
+  while (accumulator_ + STEP_TOLERANCE >= step_) {
+    if (steps_ == max_steps_) {
+      //Catch up limit, drop whatever is left
+      dropped_steps_ += (uint32_t)(accumulator_ / step_);
+      accumulator_ = 0.0;
+      break;
+    }
+    accumulator_ -= step_;
+    ++steps_;
+  }
+  if (accumulator_ < 0.0)
+    accumulator_ = 0.0;
+  time_ += steps_ * step_;
+  return steps_;
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// fixedTimestep.h
+//--------------------------------------------------------------------------------
+#ifndef FIXEDTIMESTEP_H_
+#define FIXEDTIMESTEP_H_
+
+#include <stdint.h>
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Fixed timestep scheduler
+ * Simulation advances in steps of 1/rate seconds regardless of the frame
+ * rate, so it behaves the same at 30 and 60 fps and costs the same per
+ * simulated second. Each frame Advance() turns the wall clock time since the
+ * last frame into a number of steps to run, the remainder carries over and
+ * GetAlpha() tells how far rendering is between the last two steps.
+ *
+ * At most max_steps run per frame. When a frame falls further behind (a slow
+ * frame, the app was paused) the rest of the time is dropped, simulation
+ * slows down for a moment instead of running ever more steps per frame.
+ *
+ * Per frame:
+ *   int32_t steps = timestep.Advance(PerfMonitor::GetCurrentTime());
+ *   for (int32_t i = 0; i < steps; ++i)
+ *     Simulate(timestep.GetStepTime(i));
+ *   Render(timestep.GetAlpha());  //Previous state blended towards the last
+ */
+class FixedTimestep {
+private:
+  double step_;
+  int32_t max_steps_;
+  double last_time_; //Wall clock time of the last Advance(), < 0 before
+  double accumulator_; //Not yet simulated
+  double time_; //Simulation time of the last step
+  int32_t steps_; //Of the last Advance()
+  uint32_t dropped_steps_;
+
+public:
+  FixedTimestep(const double rate = 60.0, const int32_t max_steps = 4);
+  virtual ~FixedTimestep();
+
+  void SetRate(const double rate) { step_ = 1.0 / rate; }
+  void SetMaxSteps(const int32_t max_steps) { max_steps_ = max_steps; }
+  //The next Advance() starts over without catching up, e.g. after a pause
+  void Reset();
+
+  //Steps due at the wall clock time, 0 to max_steps
+  int32_t Advance(const double time);
+  //Simulation time of step index (< steps) of the last Advance()
+  double GetStepTime(const int32_t index) const {
+    return time_ - (steps_ - 1 - index) * step_;
+  }
+  //0: the previous step's state, 1: the last step's
+  float GetAlpha() const { return (float)(accumulator_ / step_); }
+
+  double GetStep() const { return step_; }
+  double GetTime() const { return time_; }
+  //Steps dropped by the catch up limit since the last ResetCounters()
+  uint32_t GetDroppedSteps() const { return dropped_steps_; }
+  void ResetCounters() { dropped_steps_ = 0; }
+};
+
+} //namespace ndk_helper
+
+#endif /* FIXEDTIMESTEP_H_ */
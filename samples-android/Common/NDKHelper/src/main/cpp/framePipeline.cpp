@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// framePipeline.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include "framePipeline.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+FramePipeline::FramePipeline() : running_(false) {}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+FramePipeline::~FramePipeline() { Stop(); }
+
+bool FramePipeline::Start(const int32_t num_slots,
+                          std::function<void(int32_t)> simulate) {
+  Stop();
+  if (num_slots < 2 || num_slots > FRAME_PIPELINE_MAX_SLOTS)
+    return false;
+
+  simulate_ = simulate;
+  for (int32_t i = 0; i < num_slots; ++i)
+    free_slots_.push_back(i);
+  running_ = true;
+  worker_ = std::thread(&FramePipeline::Work, this);
+  return true;
+}
+
+void FramePipeline::Stop() {
+  if (!running_)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_all();
+  worker_.join();
+
+  free_slots_.clear();
+  ready_slots_.clear();
+  simulate_ = nullptr;
+}
+
+int32_t FramePipeline::AcquireFrame() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]() { return !ready_slots_.empty(); });
+  int32_t slot = ready_slots_.front();
+  ready_slots_.pop_front();
+  return slot;
+}
+
+void FramePipeline::ReleaseFrame(const int32_t slot) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_slots_.push_back(slot);
+  }
+  condition_.notify_all();
+}
+
+//--------------------------------------------------------------------------------
+// Worker
+//--------------------------------------------------------------------------------
+void FramePipeline::Work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    condition_.wait(lock,
+                    [this]() { return !running_ || !free_slots_.empty(); });
+    if (!running_)
+      return;
+    int32_t slot = free_slots_.front();
+    free_slots_.pop_front();
+
+    lock.unlock();
+    simulate_(slot);
+    lock.lock();
+
+    ready_slots_.push_back(slot);
+    condition_.notify_all();
+  }
+}
+
+} //namespace ndk_helper
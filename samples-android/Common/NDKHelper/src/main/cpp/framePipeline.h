@@ -0,0 +1,103 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// framePipeline.h
+//--------------------------------------------------------------------------------
+#ifndef FRAMEPIPELINE_H_
+#define FRAMEPIPELINE_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Slots of frame state, 2: double buffered, 3: triple buffered
+const int32_t FRAME_PIPELINE_MAX_SLOTS = 3;
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Two stage frame pipeline
+ * A worker thread simulates frame N+1 (camera, culling, matrices, draw lists,
+ * no GL calls) while the GL thread submits frame N, so on a multi core device
+ * a frame costs the longer of the two stages instead of their sum.
+ *
+ * Frame state lives in slots the caller owns, e.g. an array of per frame
+ * structs. The simulate function fills a slot on the worker, the GL thread
+ * takes filled slots in order with AcquireFrame() and hands each back with
+ * ReleaseFrame() once its data has reached GL. With 2 slots the worker runs
+ * at most one frame ahead, with 3 it can absorb a slow frame at the cost of
+ * another frame of latency.
+ *
+ * The worker only runs between Start() and Stop(). Whatever the simulate
+ * function reads must not change while it runs: stop the pipeline before
+ * reinitializing it (e.g. on a new surface), and lock state shared with
+ * other threads (e.g. a camera the input handler moves).
+ *
+ * On the GL thread:
+ *   pipeline.Start(2, [&](int32_t slot) { Simulate(&frames[slot]); });
+ *   ...each frame:
+ *   int32_t slot = pipeline.AcquireFrame();
+ *   Submit(frames[slot]);
+ *   pipeline.ReleaseFrame(slot);
+ *   ...
+ *   pipeline.Stop();
+ */
+class FramePipeline {
+private:
+  std::function<void(int32_t)> simulate_;
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<int32_t> free_slots_;
+  std::deque<int32_t> ready_slots_; //Simulated, oldest first
+  bool running_;
+
+  void Work();
+
+  FramePipeline(FramePipeline const &);
+  void operator=(FramePipeline const &);
+
+public:
+  FramePipeline();
+  virtual ~FramePipeline();
+
+  //Starts the worker, it begins simulating into all slots right away
+  bool Start(const int32_t num_slots, std::function<void(int32_t)> simulate);
+  //Waits for the frame being simulated, frames not yet acquired are dropped
+  void Stop();
+  bool IsRunning() const { return running_; }
+
+  //GL thread, blocks until the oldest simulated frame is ready
+  int32_t AcquireFrame();
+  //GL thread, the worker may simulate into the slot again
+  void ReleaseFrame(const int32_t slot);
+};
+
+} //namespace ndk_helper
+
+#endif /* FRAMEPIPELINE_H_ */
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glDispatch.cpp
+// Host side EGL/GLES entry points, replaces libEGL, libGLESv2 and gl3stub.cpp
+// in host builds. Not part of the Android library
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include "glDispatch.h"
+
+namespace ndk_helper {
+
+namespace {
+
+const GLDispatch *g_dispatch = NULL;
+
+} //namespace
+
+#define NDK_HELPER_GL_FUNCTION_INFO(api, category, ret, name, params, args,    \
+                                    size)                                      \
+  { #name, GL_CALL_##category },
+const GLFunctionInfo GL_FUNCTION_INFO[GL_FUNCTION_COUNT] = {
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_FUNCTION_INFO)
+};
+#undef NDK_HELPER_GL_FUNCTION_INFO
+
+void SetGLDispatch(const GLDispatch *dispatch) { g_dispatch = dispatch; }
+
+const GLDispatch *GetGLDispatch() { return g_dispatch; }
+
+size_t GetShaderSourceSize(const GLsizei count, const GLchar *const *string,
+                           const GLint *length) {
+  size_t size = 0;
+  for (GLsizei i = 0; i < count; ++i) {
+    if (length && length[i] >= 0)
+      size += length[i];
+    else
+      size += strlen(string[i]);
+  }
+  return size;
+}
+
+size_t GetImageSize(const GLsizei width, const GLsizei height,
+                    const GLenum format, const GLenum type) {
+  size_t components = 4;
+  switch (format) {
+  case GL_ALPHA:
+  case GL_LUMINANCE:
+    components = 1;
+    break;
+  case GL_LUMINANCE_ALPHA:
+    components = 2;
+    break;
+  case GL_RGB:
+    components = 3;
+    break;
+  }
+
+  size_t pixel_size = components;
+  if (type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 ||
+      type == GL_UNSIGNED_SHORT_5_5_5_1)
+    pixel_size = 2;
+  else if (type == GL_FLOAT)
+    pixel_size = components * sizeof(GLfloat);
+
+  //Rows are GL_UNPACK_ALIGNMENT (4 by default) aligned
+  size_t row_size = (width * pixel_size + 3) & ~(size_t)3;
+  return row_size * height;
+}
+
+} //namespace ndk_helper
+
+//--------------------------------------------------------------------------------
+// Forwarders
+// ES2 and EGL functions are defined with their API names, ES3 functions are
+// the gl3stub.h pointers, initialized to their forwarder. Extension functions
+// only have the forwarder eglGetProcAddress() returns
+//--------------------------------------------------------------------------------
+#define NDK_HELPER_GL_FORWARD_ES2(ret, name, params, args)                     \
+  GL_APICALL ret GL_APIENTRY name params {                                     \
+    return ndk_helper::g_dispatch->name args;                                  \
+  }
+#define NDK_HELPER_GL_FORWARD_ES3(ret, name, params, args)                     \
+  static ret GL_APIENTRY Forward_##name params {                               \
+    return ndk_helper::g_dispatch->name args;                                  \
+  }                                                                            \
+  GL_APICALL ret(*GL_APIENTRY name) params = Forward_##name;
+#define NDK_HELPER_GL_FORWARD_EXT(ret, name, params, args)                     \
+  static ret GL_APIENTRY Forward_##name params {                               \
+    return ndk_helper::g_dispatch->name args;                                  \
+  }
+#define NDK_HELPER_GL_FORWARD_EGL(ret, name, params, args)                     \
+  EGLAPI ret EGLAPIENTRY name params {                                         \
+    return ndk_helper::g_dispatch->name args;                                  \
+  }
+#define NDK_HELPER_GL_FORWARD(api, category, ret, name, params, args, size)    \
+  NDK_HELPER_GL_FORWARD_##api(ret, name, params, args)
+
+NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_FORWARD)
+
+#undef NDK_HELPER_GL_FORWARD
+#undef NDK_HELPER_GL_FORWARD_ES2
+#undef NDK_HELPER_GL_FORWARD_ES3
+#undef NDK_HELPER_GL_FORWARD_EXT
+#undef NDK_HELPER_GL_FORWARD_EGL
+
+namespace {
+
+struct ProcAddress {
+  const char *name;
+  __eglMustCastToProperFunctionPointerType address;
+};
+
+//EGL entries aren't returned, like most drivers
+#define NDK_HELPER_GL_PROC_ES2(name) { #name, (__eglMustCastToProperFunctionPointerType)name },
+#define NDK_HELPER_GL_PROC_ES3(name) { #name, (__eglMustCastToProperFunctionPointerType)Forward_##name },
+#define NDK_HELPER_GL_PROC_EXT(name) { #name, (__eglMustCastToProperFunctionPointerType)Forward_##name },
+#define NDK_HELPER_GL_PROC_EGL(name)
+#define NDK_HELPER_GL_PROC(api, category, ret, name, params, args, size)       \
+  NDK_HELPER_GL_PROC_##api(name)
+const ProcAddress PROC_ADDRESSES[] = {
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_PROC)
+};
+#undef NDK_HELPER_GL_PROC
+#undef NDK_HELPER_GL_PROC_ES2
+#undef NDK_HELPER_GL_PROC_ES3
+#undef NDK_HELPER_GL_PROC_EXT
+#undef NDK_HELPER_GL_PROC_EGL
+
+} //namespace
+
+EGLAPI __eglMustCastToProperFunctionPointerType EGLAPIENTRY
+eglGetProcAddress(const char *procname) {
+  for (size_t i = 0; i < sizeof(PROC_ADDRESSES) / sizeof(PROC_ADDRESSES[0]);
+       ++i) {
+    if (strcmp(PROC_ADDRESSES[i].name, procname) == 0)
+      return PROC_ADDRESSES[i].address;
+  }
+  return NULL;
+}
+
+//Host replacement of gl3stubInit(), the ES3 pointers are always set. Whether
+//the backend is ES3 capable is up to its GL_VERSION, see GLContext::InitGLES()
+GLboolean gl3stubInit() { return GL_TRUE; }
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glDispatch.h
+//--------------------------------------------------------------------------------
+#ifndef GLDISPATCH_H_
+#define GLDISPATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <EGL/egl.h>
+#include "gl3stub.h"
+
+/******************************************************************
+ * Pluggable GL/EGL dispatch for host builds
+ *
+ * On Android the samples call the driver directly. Host builds (desktop
+ * Linux benchmarks and tools) link glDispatch.cpp instead of libEGL and
+ * libGLESv2: it defines the EGL and GLES entry points listed below and
+ * forwards each call through a table of function pointers, the same way
+ * gl3stub forwards the ES3 entry points. A backend fills the table, e.g.
+ * GLRecorder, which records the command stream without any GPU.
+ *
+ * ES3 entries are reached through the gl3stub.h pointers, and
+ * eglGetProcAddress() returns the forwarders of ES3 and extension entries,
+ * so host code is source compatible with the device build. Only the entry
+ * points in the lists are available on host; add new ones there.
+ */
+
+//--------------------------------------------------------------------------------
+// Entry point lists
+// X(api, category, return type, name, parameters, arguments, data size)
+// api: ES2 core symbol, ES3 gl3stub pointer, EGL symbol, EXT extension entry
+// reached through eglGetProcAddress() only
+// category: GLCallCategory without prefix
+// data size: bytes of client memory the call passes to GL
+//--------------------------------------------------------------------------------
+#define NDK_HELPER_GL_FUNCTIONS(X)                                             \
+  X(ES2, STATE, void, glActiveTexture, (GLenum texture), (texture), 0)         \
+  X(ES2, RESOURCE, void, glAttachShader, (GLuint program, GLuint shader),      \
+    (program, shader), 0)                                                      \
+  X(ES2, RESOURCE, void, glBindAttribLocation,                                 \
+    (GLuint program, GLuint index, const GLchar *name), (program, index, name),\
+    0)                                                                         \
+  X(ES2, STATE, void, glBindBuffer, (GLenum target, GLuint buffer),            \
+    (target, buffer), 0)                                                       \
+  X(ES2, STATE, void, glBindTexture, (GLenum target, GLuint texture),          \
+    (target, texture), 0)                                                      \
+  X(ES2, STATE, void, glBlendFunc, (GLenum sfactor, GLenum dfactor),           \
+    (sfactor, dfactor), 0)                                                     \
+  X(ES2, UPLOAD, void, glBufferData,                                           \
+    (GLenum target, GLsizeiptr size, const void *data, GLenum usage),          \
+    (target, size, data, usage), data ? size : 0)                              \
+  X(ES2, UPLOAD, void, glBufferSubData,                                        \
+    (GLenum target, GLintptr offset, GLsizeiptr size, const void *data),       \
+    (target, offset, size, data), size)                                        \
+  X(ES2, CLEAR, void, glClear, (GLbitfield mask), (mask), 0)                   \
+  X(ES2, STATE, void, glClearColor,                                            \
+    (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha),                 \
+    (red, green, blue, alpha), 0)                                              \
+  X(ES2, RESOURCE, void, glCompileShader, (GLuint shader), (shader), 0)        \
+  X(ES2, QUERY, GLuint, glCreateProgram, (), (), 0)                            \
+  X(ES2, QUERY, GLuint, glCreateShader, (GLenum type), (type), 0)              \
+  X(ES2, STATE, void, glCullFace, (GLenum mode), (mode), 0)                    \
+  X(ES2, RESOURCE, void, glDeleteBuffers, (GLsizei n, const GLuint *buffers),  \
+    (n, buffers), 0)                                                           \
+  X(ES2, RESOURCE, void, glDeleteProgram, (GLuint program), (program), 0)      \
+  X(ES2, RESOURCE, void, glDeleteShader, (GLuint shader), (shader), 0)         \
+  X(ES2, RESOURCE, void, glDeleteTextures,                                     \
+    (GLsizei n, const GLuint *textures), (n, textures), 0)                     \
+  X(ES2, STATE, void, glDepthFunc, (GLenum func), (func), 0)                   \
+  X(ES2, STATE, void, glDepthMask, (GLboolean flag), (flag), 0)                \
+  X(ES2, STATE, void, glDisable, (GLenum cap), (cap), 0)                       \
+  X(ES2, STATE, void, glDisableVertexAttribArray, (GLuint index), (index), 0)  \
+  X(ES2, DRAW, void, glDrawArrays, (GLenum mode, GLint first, GLsizei count),  \
+    (mode, first, count), 0)                                                   \
+  X(ES2, DRAW, void, glDrawElements,                                           \
+    (GLenum mode, GLsizei count, GLenum type, const void *indices),            \
+    (mode, count, type, indices), 0)                                           \
+  X(ES2, STATE, void, glEnable, (GLenum cap), (cap), 0)                        \
+  X(ES2, STATE, void, glEnableVertexAttribArray, (GLuint index), (index), 0)   \
+  X(ES2, RESOURCE, void, glFinish, (), (), 0)                                  \
+  X(ES2, RESOURCE, void, glFlush, (), (), 0)                                   \
+  X(ES2, STATE, void, glFrontFace, (GLenum mode), (mode), 0)                   \
+  X(ES2, QUERY, void, glGenBuffers, (GLsizei n, GLuint *buffers),              \
+    (n, buffers), 0)                                                           \
+  X(ES2, QUERY, void, glGenTextures, (GLsizei n, GLuint *textures),            \
+    (n, textures), 0)                                                          \
+  X(ES2, QUERY, GLint, glGetAttribLocation,                                    \
+    (GLuint program, const GLchar *name), (program, name), 0)                  \
+  X(ES2, QUERY, GLenum, glGetError, (), (), 0)                                 \
+  X(ES2, QUERY, void, glGetIntegerv, (GLenum pname, GLint *data),              \
+    (pname, data), 0)                                                          \
+  X(ES2, QUERY, void, glGetProgramInfoLog,                                     \
+    (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog),       \
+    (program, bufSize, length, infoLog), 0)                                    \
+  X(ES2, QUERY, void, glGetProgramiv,                                          \
+    (GLuint program, GLenum pname, GLint *params), (program, pname, params), 0)\
+  X(ES2, QUERY, void, glGetShaderInfoLog,                                      \
+    (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog),        \
+    (shader, bufSize, length, infoLog), 0)                                     \
+  X(ES2, QUERY, void, glGetShaderiv,                                           \
+    (GLuint shader, GLenum pname, GLint *params), (shader, pname, params), 0)  \
+  X(ES2, QUERY, const GLubyte *, glGetString, (GLenum name), (name), 0)        \
+  X(ES2, QUERY, GLint, glGetUniformLocation,                                   \
+    (GLuint program, const GLchar *name), (program, name), 0)                  \
+  X(ES2, RESOURCE, void, glLinkProgram, (GLuint program), (program), 0)        \
+  X(ES2, STATE, void, glScissor,                                               \
+    (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height),  \
+    0)                                                                         \
+  X(ES2, RESOURCE, void, glShaderSource,                                       \
+    (GLuint shader, GLsizei count, const GLchar *const *string,                \
+     const GLint *length),                                                     \
+    (shader, count, string, length),                                           \
+    ndk_helper::GetShaderSourceSize(count, string, length))                    \
+  X(ES2, UPLOAD, void, glTexImage2D,                                           \
+    (GLenum target, GLint level, GLint internalformat, GLsizei width,          \
+     GLsizei height, GLint border, GLenum format, GLenum type,                 \
+     const void *pixels),                                                      \
+    (target, level, internalformat, width, height, border, format, type,       \
+     pixels),                                                                  \
+    pixels ? ndk_helper::GetImageSize(width, height, format, type) : 0)        \
+  X(ES2, STATE, void, glTexParameteri,                                         \
+    (GLenum target, GLenum pname, GLint param), (target, pname, param), 0)     \
+  X(ES2, STATE, void, glUniform1f, (GLint location, GLfloat v0),               \
+    (location, v0), sizeof(GLfloat))                                           \
+  X(ES2, STATE, void, glUniform1i, (GLint location, GLint v0), (location, v0), \
+    sizeof(GLint))                                                             \
+  X(ES2, STATE, void, glUniform3f,                                             \
+    (GLint location, GLfloat v0, GLfloat v1, GLfloat v2),                      \
+    (location, v0, v1, v2), 3 * sizeof(GLfloat))                               \
+  X(ES2, STATE, void, glUniform3fv,                                            \
+    (GLint location, GLsizei count, const GLfloat *value),                     \
+    (location, count, value), count * 3 * sizeof(GLfloat))                     \
+  X(ES2, STATE, void, glUniform4f,                                             \
+    (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3),          \
+    (location, v0, v1, v2, v3), 4 * sizeof(GLfloat))                           \
+  X(ES2, STATE, void, glUniform4fv,                                            \
+    (GLint location, GLsizei count, const GLfloat *value),                     \
+    (location, count, value), count * 4 * sizeof(GLfloat))                     \
+  X(ES2, STATE, void, glUniformMatrix4fv,                                      \
+    (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value),\
+    (location, count, transpose, value), count * 16 * sizeof(GLfloat))        \
+  X(ES2, STATE, void, glUseProgram, (GLuint program), (program), 0)            \
+  X(ES2, RESOURCE, void, glValidateProgram, (GLuint program), (program), 0)    \
+  X(ES2, STATE, void, glVertexAttribPointer,                                   \
+    (GLuint index, GLint size, GLenum type, GLboolean normalized,              \
+     GLsizei stride, const void *pointer),                                     \
+    (index, size, type, normalized, stride, pointer), 0)                       \
+  X(ES2, STATE, void, glViewport,                                              \
+    (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height),  \
+    0)                                                                         \
+  X(ES3, STATE, void, glBindBufferBase,                                        \
+    (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), 0)  \
+  X(ES3, STATE, void, glBindBufferRange,                                       \
+    (GLenum target, GLuint index, GLuint buffer, GLintptr offset,              \
+     GLsizeiptr size),                                                         \
+    (target, index, buffer, offset, size), 0)                                  \
+  X(ES3, STATE, void, glBindVertexArray, (GLuint array), (array), 0)           \
+  X(ES3, RESOURCE, void, glDeleteVertexArrays,                                 \
+    (GLsizei n, const GLuint *arrays), (n, arrays), 0)                         \
+  X(ES3, DRAW, void, glDrawArraysInstanced,                                    \
+    (GLenum mode, GLint first, GLsizei count, GLsizei instancecount),          \
+    (mode, first, count, instancecount), 0)                                    \
+  X(ES3, DRAW, void, glDrawElementsInstanced,                                  \
+    (GLenum mode, GLsizei count, GLenum type, const void *indices,             \
+     GLsizei instancecount),                                                   \
+    (mode, count, type, indices, instancecount), 0)                            \
+  X(ES3, QUERY, void, glGenVertexArrays, (GLsizei n, GLuint *arrays),          \
+    (n, arrays), 0)                                                            \
+  X(ES3, QUERY, void, glGetProgramBinary,                                      \
+    (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat,   \
+     void *binary),                                                            \
+    (program, bufSize, length, binaryFormat, binary), 0)                       \
+  X(ES3, QUERY, GLuint, glGetUniformBlockIndex,                                \
+    (GLuint program, const GLchar *uniformBlockName),                          \
+    (program, uniformBlockName), 0)                                            \
+  X(ES3, RESOURCE, void, glProgramBinary,                                      \
+    (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length), \
+    (program, binaryFormat, binary, length), length)                           \
+  X(ES3, RESOURCE, void, glProgramParameteri,                                  \
+    (GLuint program, GLenum pname, GLint value), (program, pname, value), 0)   \
+  X(ES3, RESOURCE, void, glUniformBlockBinding,                                \
+    (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding),    \
+    (program, uniformBlockIndex, uniformBlockBinding), 0)                      \
+  X(ES3, STATE, void, glVertexAttribDivisor, (GLuint index, GLuint divisor),   \
+    (index, divisor), 0)                                                       \
+  X(EXT, STATE, void, glMaxShaderCompilerThreadsKHR, (GLuint count), (count),  \
+    0)                                                                         \
+  X(EGL, EGL, EGLBoolean, eglChooseConfig,                                     \
+    (EGLDisplay dpy, const EGLint *attrib_list, EGLConfig *configs,            \
+     EGLint config_size, EGLint *num_config),                                  \
+    (dpy, attrib_list, configs, config_size, num_config), 0)                   \
+  X(EGL, EGL, EGLContext, eglCreateContext,                                    \
+    (EGLDisplay dpy, EGLConfig config, EGLContext share_context,               \
+     const EGLint *attrib_list),                                               \
+    (dpy, config, share_context, attrib_list), 0)                              \
+  X(EGL, EGL, EGLSurface, eglCreatePbufferSurface,                             \
+    (EGLDisplay dpy, EGLConfig config, const EGLint *attrib_list),             \
+    (dpy, config, attrib_list), 0)                                             \
+  X(EGL, EGL, EGLSurface, eglCreateWindowSurface,                              \
+    (EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win,                \
+     const EGLint *attrib_list),                                               \
+    (dpy, config, win, attrib_list), 0)                                        \
+  X(EGL, EGL, EGLBoolean, eglDestroyContext,                                   \
+    (EGLDisplay dpy, EGLContext ctx), (dpy, ctx), 0)                           \
+  X(EGL, EGL, EGLBoolean, eglDestroySurface,                                   \
+    (EGLDisplay dpy, EGLSurface surface), (dpy, surface), 0)                   \
+  X(EGL, EGL, EGLDisplay, eglGetDisplay, (EGLNativeDisplayType display_id),    \
+    (display_id), 0)                                                           \
+  X(EGL, EGL, EGLint, eglGetError, (), (), 0)                                  \
+  X(EGL, EGL, EGLDisplay, eglGetPlatformDisplay,                               \
+    (EGLenum platform, void *native_display, const EGLAttrib *attrib_list),    \
+    (platform, native_display, attrib_list), 0)                                \
+  X(EGL, EGL, EGLBoolean, eglInitialize,                                       \
+    (EGLDisplay dpy, EGLint *major, EGLint *minor), (dpy, major, minor), 0)    \
+  X(EGL, EGL, EGLBoolean, eglMakeCurrent,                                      \
+    (EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx),        \
+    (dpy, draw, read, ctx), 0)                                                 \
+  X(EGL, EGL, EGLBoolean, eglQuerySurface,                                     \
+    (EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint *value),     \
+    (dpy, surface, attribute, value), 0)                                       \
+  X(EGL, EGL, EGLBoolean, eglSwapBuffers,                                      \
+    (EGLDisplay dpy, EGLSurface surface), (dpy, surface), 0)                   \
+  X(EGL, EGL, EGLBoolean, eglSwapInterval, (EGLDisplay dpy, EGLint interval),  \
+    (dpy, interval), 0)                                                        \
+  X(EGL, EGL, EGLBoolean, eglTerminate, (EGLDisplay dpy), (dpy), 0)
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+enum GLCallCategory {
+  GL_CALL_STATE,    //Binds, enables, uniforms, attribute setup
+  GL_CALL_DRAW,     //glDraw* calls
+  GL_CALL_CLEAR,    //Framebuffer clears
+  GL_CALL_UPLOAD,   //Buffer and texture data
+  GL_CALL_RESOURCE, //Object and program life time, shader compiles, flushes
+  GL_CALL_QUERY,    //Calls returning data, including Gen*/Create*
+  GL_CALL_EGL,
+  GL_CALL_CATEGORY_COUNT
+};
+
+#define NDK_HELPER_GL_FUNCTION_ENUM(api, category, ret, name, params, args,    \
+                                    size)                                      \
+  GL_FUNCTION_##name,
+enum GLFunction {
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_FUNCTION_ENUM) GL_FUNCTION_COUNT
+};
+#undef NDK_HELPER_GL_FUNCTION_ENUM
+
+struct GLFunctionInfo {
+  const char *name;
+  GLCallCategory category;
+};
+
+//Indexed by GLFunction
+extern const GLFunctionInfo GL_FUNCTION_INFO[GL_FUNCTION_COUNT];
+
+//--------------------------------------------------------------------------------
+// Dispatch table
+//--------------------------------------------------------------------------------
+#define NDK_HELPER_GL_DISPATCH_ENTRY(api, category, ret, name, params, args,   \
+                                     size)                                     \
+  ret(GL_APIENTRY *name) params;
+struct GLDispatch {
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_DISPATCH_ENTRY)
+};
+#undef NDK_HELPER_GL_DISPATCH_ENTRY
+
+//Every entry of dispatch but EXT ones must be set, the table must outlive its
+//use. Like on a device, an extension entry may only be called when the
+//backend's GL_EXTENSIONS has the extension.
+//Passing NULL removes the backend, GL calls then crash
+void SetGLDispatch(const GLDispatch *dispatch);
+const GLDispatch *GetGLDispatch();
+
+//Data sizes of the list above
+size_t GetShaderSourceSize(const GLsizei count, const GLchar *const *string,
+                           const GLint *length);
+size_t GetImageSize(const GLsizei width, const GLsizei height,
+                    const GLenum format, const GLenum type);
+
+} //namespace ndk_helper
+
+#endif /* GLDISPATCH_H_ */
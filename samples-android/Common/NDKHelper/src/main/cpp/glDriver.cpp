@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glDriver.cpp
+//--------------------------------------------------------------------------------
+#include <dlfcn.h>
+#include <string.h>
+
+#include "glDriver.h"
+#include "vecmath.h"
+
+namespace ndk_helper {
+
+namespace {
+
+typedef __eglMustCastToProperFunctionPointerType(EGLAPIENTRY *
+                                                 GetProcAddressFunction)(
+    const char *procname);
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+GLDriver::GLDriver()
+    : egl_library_(NULL), gles_library_(NULL), installed_(false) {
+  memset(&dispatch_, 0, sizeof(dispatch_));
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+GLDriver::~GLDriver() { Unload(); }
+
+void GLDriver::Unload() {
+  if (installed_) {
+    if (GetGLDispatch() == &dispatch_)
+      SetGLDispatch(NULL);
+    installed_ = false;
+  }
+  if (gles_library_)
+    dlclose(gles_library_);
+  if (egl_library_)
+    dlclose(egl_library_);
+  gles_library_ = NULL;
+  egl_library_ = NULL;
+}
+
+bool GLDriver::Load(const char *egl_library, const char *gles_library) {
+  Unload();
+
+  //Local symbols, the process defines the same names in glDispatch.cpp
+  egl_library_ = dlopen(egl_library, RTLD_NOW | RTLD_LOCAL);
+  gles_library_ = dlopen(gles_library, RTLD_NOW | RTLD_LOCAL);
+  if (egl_library_ == NULL || gles_library_ == NULL) {
+    LOGW("Can not open GL libraries:%s %s", egl_library, gles_library);
+    Unload();
+    return false;
+  }
+
+  //Entry points the libraries don't export, e.g. of extensions, come from
+  //eglGetProcAddress()
+  GetProcAddressFunction get_proc_address =
+      (GetProcAddressFunction)dlsym(egl_library_, "eglGetProcAddress");
+
+  //Extension entries may be missing, users check GL_EXTENSIONS first
+  bool complete = true;
+#define NDK_HELPER_GL_LIBRARY_ES2 gles_library_
+#define NDK_HELPER_GL_LIBRARY_ES3 gles_library_
+#define NDK_HELPER_GL_LIBRARY_EXT gles_library_
+#define NDK_HELPER_GL_LIBRARY_EGL egl_library_
+#define NDK_HELPER_GL_REQUIRED_ES2 true
+#define NDK_HELPER_GL_REQUIRED_ES3 true
+#define NDK_HELPER_GL_REQUIRED_EXT false
+#define NDK_HELPER_GL_REQUIRED_EGL true
+#define NDK_HELPER_GL_LOAD(api, category, ret, name, params, args, size)       \
+  {                                                                            \
+    void *address = dlsym(NDK_HELPER_GL_LIBRARY_##api, #name);                 \
+    if (address == NULL && get_proc_address)                                   \
+      address = (void *)get_proc_address(#name);                               \
+    if (address == NULL && NDK_HELPER_GL_REQUIRED_##api) {                     \
+      LOGW("Missing GL entry point:%s", #name);                                \
+      complete = false;                                                        \
+    }                                                                          \
+    dispatch_.name = (ret(GL_APIENTRY *) params)address;                       \
+  }
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_LOAD)
+#undef NDK_HELPER_GL_LOAD
+#undef NDK_HELPER_GL_LIBRARY_ES2
+#undef NDK_HELPER_GL_LIBRARY_ES3
+#undef NDK_HELPER_GL_LIBRARY_EXT
+#undef NDK_HELPER_GL_LIBRARY_EGL
+#undef NDK_HELPER_GL_REQUIRED_ES2
+#undef NDK_HELPER_GL_REQUIRED_ES3
+#undef NDK_HELPER_GL_REQUIRED_EXT
+#undef NDK_HELPER_GL_REQUIRED_EGL
+
+  if (!complete)
+    Unload();
+  return complete;
+}
+
+void GLDriver::Install() {
+  SetGLDispatch(&dispatch_);
+  installed_ = true;
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glDriver.h
+//--------------------------------------------------------------------------------
+#ifndef GLDRIVER_H_
+#define GLDRIVER_H_
+
+#include "glDispatch.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Native GL/EGL backend for host builds
+ * Load() opens the system EGL and GLES libraries at run time and fills a
+ * dispatch table with their entry points, Install() makes it the GL dispatch
+ * of the process, see glDispatch.h. Host code then renders for real, e.g. on
+ * Mesa llvmpipe on a machine without a GPU, together with
+ * GLContext::InitHeadless().
+ *
+ * Typical use:
+ *   GLDriver driver;
+ *   if (driver.Load()) {
+ *     driver.Install();
+ *     GLContext::GetInstance()->InitHeadless(1280, 720);
+ *     ...
+ *   }
+ */
+class GLDriver {
+private:
+  void *egl_library_;
+  void *gles_library_;
+  GLDispatch dispatch_;
+  bool installed_;
+
+  void Unload();
+
+  GLDriver(GLDriver const &);
+  void operator=(GLDriver const &);
+
+public:
+  GLDriver();
+  virtual ~GLDriver();
+
+  //Fails when a library can not be opened or misses an entry point of
+  //NDK_HELPER_GL_FUNCTIONS other than an extension's
+  bool Load(const char *egl_library = "libEGL.so.1",
+            const char *gles_library = "libGLESv2.so.2");
+
+  //Routes all GL/EGL calls of the process to the driver. The destructor
+  //removes it again
+  void Install();
+};
+
+} //namespace ndk_helper
+
+#endif /* GLDRIVER_H_ */
@@ -0,0 +1,366 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glRecorder.cpp
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include <algorithm>
+
+#include "glRecorder.h"
+
+namespace ndk_helper {
+
+namespace {
+
+GLRecorder *g_recorder = NULL;
+
+//Names of the emulated EGL objects
+EGLDisplay const DISPLAY = (EGLDisplay)1;
+EGLConfig const CONFIG = (EGLConfig)1;
+EGLContext const CONTEXT = (EGLContext)1;
+EGLSurface const SURFACE = (EGLSurface)1;
+
+//Program binaries, of any program
+const GLenum PROGRAM_BINARY_FORMAT = 0x1;
+const GLint PROGRAM_BINARY_SIZE = 64;
+
+GLArg MakeResult(const uint64_t value) {
+  GLArg arg;
+  arg.type = GL_ARG_UINT;
+  arg.u = value;
+  return arg;
+}
+
+GLArg MakePointerResult(const void *value) {
+  GLArg arg;
+  arg.type = GL_ARG_POINTER;
+  arg.p = value;
+  return arg;
+}
+
+//Pointer arguments the emulation writes to
+template <class T>
+T *Output(const GLCommand &command, const int32_t index) {
+  return (T *)command.args[index].p;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Dispatch thunks
+//--------------------------------------------------------------------------------
+#define NDK_HELPER_GL_RECORD(api, category, ret, name, params, args, size)     \
+  static ret GL_APIENTRY Record_##name params {                                \
+    GLCommand &command = g_recorder->Begin(GL_FUNCTION_##name, (size));        \
+    command.SetArgs args;                                                      \
+    return g_recorder->End<ret>(command);                                      \
+  }
+NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_RECORD)
+#undef NDK_HELPER_GL_RECORD
+
+#define NDK_HELPER_GL_RECORD_ENTRY(api, category, ret, name, params, args,     \
+                                   size)                                       \
+  Record_##name,
+static const GLDispatch RECORD_DISPATCH = {
+  NDK_HELPER_GL_FUNCTIONS(NDK_HELPER_GL_RECORD_ENTRY)
+};
+#undef NDK_HELPER_GL_RECORD_ENTRY
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+GLRecorder::GLRecorder()
+    : version_("OpenGL ES 3.0 GLRecorder"),
+      extensions_("GL_OES_element_index_uint GL_OES_vertex_half_float"),
+      surface_width_(1280), surface_height_(720), viewport_set_(false),
+      next_name_(1) {
+  memset(viewport_, 0, sizeof(viewport_));
+}
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+GLRecorder::~GLRecorder() {
+  if (g_recorder == this) {
+    SetGLDispatch(NULL);
+    g_recorder = NULL;
+  }
+}
+
+void GLRecorder::Install() {
+  g_recorder = this;
+  SetGLDispatch(&RECORD_DISPATCH);
+}
+
+GLCommand &GLRecorder::Begin(const GLFunction function,
+                             const uint64_t data_size) {
+  commands_.push_back(GLCommand());
+  GLCommand &command = commands_.back();
+  command.function = function;
+  command.data_size = data_size;
+  return command;
+}
+
+//--------------------------------------------------------------------------------
+// Emulation
+// Results and side effects GLContext and the renderers depend on, everything
+// else is only recorded
+//--------------------------------------------------------------------------------
+GLArg GLRecorder::Emulate(const GLCommand &command) {
+  const GLArg *args = command.args;
+  switch (command.function) {
+  //Objects
+  case GL_FUNCTION_glCreateProgram:
+  case GL_FUNCTION_glCreateShader:
+    return MakeResult(next_name_++);
+  case GL_FUNCTION_glGenBuffers:
+  case GL_FUNCTION_glGenTextures:
+  case GL_FUNCTION_glGenVertexArrays:
+    for (int64_t i = 0; i < args[0].i; ++i)
+      Output<GLuint>(command, 1)[i] = next_name_++;
+    break;
+
+  //Compiles, links and program binaries always succeed without a log
+  case GL_FUNCTION_glGetShaderiv:
+  case GL_FUNCTION_glGetProgramiv: {
+    GLenum pname = (GLenum)args[1].u;
+    GLint *data = Output<GLint>(command, 2);
+    if (pname == GL_PROGRAM_BINARY_LENGTH)
+      *data = PROGRAM_BINARY_SIZE;
+    else
+      *data = pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS ||
+                      pname == GL_VALIDATE_STATUS
+                  ? GL_TRUE
+                  : 0;
+    break;
+  }
+  case GL_FUNCTION_glGetProgramBinary: {
+    GLsizei size = std::min((GLsizei)args[1].i, PROGRAM_BINARY_SIZE);
+    if (args[2].p)
+      *Output<GLsizei>(command, 2) = size;
+    *Output<GLenum>(command, 3) = PROGRAM_BINARY_FORMAT;
+    memset(Output<uint8_t>(command, 4), 0, size);
+    break;
+  }
+  case GL_FUNCTION_glGetShaderInfoLog:
+  case GL_FUNCTION_glGetProgramInfoLog:
+    if (args[2].p)
+      *Output<GLsizei>(command, 2) = 0;
+    if (args[1].i > 0)
+      *Output<GLchar>(command, 3) = '\0';
+    break;
+
+  //Locations and block indices are stable per name over all programs
+  case GL_FUNCTION_glGetUniformBlockIndex:
+  case GL_FUNCTION_glGetUniformLocation:
+  case GL_FUNCTION_glGetAttribLocation: {
+    std::map<std::string, GLint> &locations =
+        command.function == GL_FUNCTION_glGetAttribLocation
+            ? attrib_locations_
+            : uniform_locations_;
+    std::string name(Output<const GLchar>(command, 1));
+    std::map<std::string, GLint>::iterator it = locations.find(name);
+    if (it == locations.end())
+      it = locations.insert(std::make_pair(name, (GLint)locations.size()))
+               .first;
+    return MakeResult(it->second);
+  }
+
+  //Queries
+  case GL_FUNCTION_glGetError:
+    return MakeResult(GL_NO_ERROR);
+  case GL_FUNCTION_glGetString:
+    switch (args[0].u) {
+    case GL_VERSION:
+      return MakePointerResult(version_.c_str());
+    case GL_EXTENSIONS:
+      return MakePointerResult(extensions_.c_str());
+    case GL_VENDOR:
+    case GL_RENDERER:
+      return MakePointerResult("GLRecorder");
+    case GL_SHADING_LANGUAGE_VERSION:
+      return MakePointerResult(strncmp(version_.c_str(), "OpenGL ES 3.", 12)
+                                   ? "OpenGL ES GLSL ES 1.00"
+                                   : "OpenGL ES GLSL ES 3.00");
+    default:
+      return MakePointerResult(NULL);
+    }
+  case GL_FUNCTION_glGetIntegerv: {
+    GLint *data = Output<GLint>(command, 1);
+    switch (args[0].u) {
+    case GL_VIEWPORT:
+      memcpy(data, viewport_, sizeof(viewport_));
+      break;
+    case GL_MAX_VERTEX_ATTRIBS:
+      *data = 16;
+      break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+      *data = 256;
+      break;
+    case GL_NUM_PROGRAM_BINARY_FORMATS:
+      *data = 1;
+      break;
+    case GL_PROGRAM_BINARY_FORMATS:
+      *data = PROGRAM_BINARY_FORMAT;
+      break;
+    default:
+      *data = 0;
+      break;
+    }
+    break;
+  }
+  case GL_FUNCTION_glViewport:
+    for (int32_t i = 0; i < 4; ++i)
+      viewport_[i] = (GLint)args[i].i;
+    viewport_set_ = true;
+    break;
+
+  //EGL, one display, config, context and surface
+  case GL_FUNCTION_eglGetDisplay:
+  case GL_FUNCTION_eglGetPlatformDisplay:
+    return MakePointerResult(DISPLAY);
+  case GL_FUNCTION_eglInitialize:
+    if (args[1].p)
+      *Output<EGLint>(command, 1) = 1;
+    if (args[2].p)
+      *Output<EGLint>(command, 2) = 4;
+    return MakeResult(EGL_TRUE);
+  case GL_FUNCTION_eglChooseConfig:
+    if (args[2].p && args[3].i > 0)
+      *Output<EGLConfig>(command, 2) = CONFIG;
+    *Output<EGLint>(command, 4) = 1;
+    return MakeResult(EGL_TRUE);
+  case GL_FUNCTION_eglCreateWindowSurface:
+  case GL_FUNCTION_eglCreatePbufferSurface:
+    return MakePointerResult(SURFACE);
+  case GL_FUNCTION_eglCreateContext:
+    return MakePointerResult(CONTEXT);
+  case GL_FUNCTION_eglQuerySurface:
+    if (args[2].i == EGL_WIDTH)
+      *Output<EGLint>(command, 3) = surface_width_;
+    else if (args[2].i == EGL_HEIGHT)
+      *Output<EGLint>(command, 3) = surface_height_;
+    else
+      *Output<EGLint>(command, 3) = 0;
+    return MakeResult(EGL_TRUE);
+  case GL_FUNCTION_eglMakeCurrent:
+    //The first surface a context is made current with sets the viewport
+    if (args[3].p != EGL_NO_CONTEXT && !viewport_set_) {
+      viewport_[2] = surface_width_;
+      viewport_[3] = surface_height_;
+      viewport_set_ = true;
+    }
+    return MakeResult(EGL_TRUE);
+  case GL_FUNCTION_eglGetError:
+    return MakeResult(EGL_SUCCESS);
+  case GL_FUNCTION_eglDestroyContext:
+  case GL_FUNCTION_eglDestroySurface:
+  case GL_FUNCTION_eglSwapBuffers:
+  case GL_FUNCTION_eglSwapInterval:
+  case GL_FUNCTION_eglTerminate:
+    return MakeResult(EGL_TRUE);
+
+  default:
+    break;
+  }
+  return MakeResult(0);
+}
+
+//--------------------------------------------------------------------------------
+// Reports
+//--------------------------------------------------------------------------------
+GLStatistics GLRecorder::GetStatistics() const {
+  GLStatistics statistics;
+  memset(&statistics, 0, sizeof(statistics));
+
+  for (size_t i = 0; i < commands_.size(); ++i) {
+    const GLCommand &command = commands_[i];
+    const GLCallCategory category = GL_FUNCTION_INFO[command.function].category;
+    ++statistics.calls;
+    ++statistics.calls_by_category[category];
+    if (category == GL_CALL_UPLOAD)
+      statistics.upload_bytes += command.data_size;
+    else if (category == GL_CALL_STATE)
+      statistics.uniform_bytes += command.data_size;
+
+    switch (command.function) {
+    case GL_FUNCTION_eglSwapBuffers:
+      ++statistics.swaps;
+      break;
+    case GL_FUNCTION_glDrawArrays:
+      statistics.draw_vertices += command.args[2].i;
+      break;
+    case GL_FUNCTION_glDrawElements:
+      statistics.draw_vertices += command.args[1].i;
+      break;
+    case GL_FUNCTION_glDrawArraysInstanced:
+      statistics.draw_vertices += command.args[2].i * command.args[3].i;
+      break;
+    case GL_FUNCTION_glDrawElementsInstanced:
+      statistics.draw_vertices += command.args[1].i * command.args[4].i;
+      break;
+    case GL_FUNCTION_glBufferData:
+    case GL_FUNCTION_glBufferSubData:
+      if (command.args[0].u == GL_UNIFORM_BUFFER)
+        ++statistics.uniform_buffer_uploads;
+      break;
+    case GL_FUNCTION_glBindBufferBase:
+    case GL_FUNCTION_glBindBufferRange:
+      if (command.args[0].u == GL_UNIFORM_BUFFER)
+        ++statistics.uniform_buffer_binds;
+      break;
+    default:
+      break;
+    }
+  }
+  return statistics;
+}
+
+void GLRecorder::Dump(FILE *file) const {
+  for (size_t i = 0; i < commands_.size(); ++i) {
+    const GLCommand &command = commands_[i];
+    fprintf(file, "%s(", GL_FUNCTION_INFO[command.function].name);
+    for (int32_t j = 0; j < command.num_args; ++j) {
+      const GLArg &arg = command.args[j];
+      if (j)
+        fprintf(file, ", ");
+      switch (arg.type) {
+      case GL_ARG_INT:
+        fprintf(file, "%lld", (long long)arg.i);
+        break;
+      case GL_ARG_UINT:
+        //Enums and bitfields in hex, names and counts in decimal
+        fprintf(file, arg.u >= 0x100 ? "0x%llx" : "%llu",
+                (unsigned long long)arg.u);
+        break;
+      case GL_ARG_FLOAT:
+        fprintf(file, "%g", arg.f);
+        break;
+      case GL_ARG_POINTER:
+        fprintf(file, "%p", arg.p);
+        break;
+      }
+    }
+    fprintf(file, ")");
+    if (command.data_size)
+      fprintf(file, " %llu bytes", (unsigned long long)command.data_size);
+    fprintf(file, "\n");
+  }
+}
+
+} //namespace ndk_helper
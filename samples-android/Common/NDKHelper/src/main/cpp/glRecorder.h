@@ -0,0 +1,216 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// glRecorder.h
+//--------------------------------------------------------------------------------
+#ifndef GLRECORDER_H_
+#define GLRECORDER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "glDispatch.h"
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Most arguments of a function in NDK_HELPER_GL_FUNCTIONS
+const int32_t GL_COMMAND_MAX_ARGS = 9;
+
+enum GLArgType { GL_ARG_INT, GL_ARG_UINT, GL_ARG_FLOAT, GL_ARG_POINTER };
+
+struct GLArg {
+  GLArgType type;
+  union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    const void *p;
+  };
+};
+
+//One recorded call, data_size is the client memory it passes to GL
+struct GLCommand {
+  GLFunction function;
+  int32_t num_args;
+  uint64_t data_size;
+  GLArg args[GL_COMMAND_MAX_ARGS];
+
+  template <class... T>
+  void SetArgs(T... values) {
+    static_assert(sizeof...(T) <= GL_COMMAND_MAX_ARGS, "GL_COMMAND_MAX_ARGS");
+    num_args = 0;
+    Add(values...);
+  }
+
+private:
+  void Add() {}
+  template <class T, class... R>
+  void Add(T value, R... rest) {
+    args[num_args++] = MakeArg(value);
+    Add(rest...);
+  }
+
+  template <class T>
+  static GLArg MakeArg(T value, typename std::enable_if<
+                                    std::is_integral<T>::value>::type * = 0) {
+    GLArg arg;
+    if (std::is_signed<T>::value) {
+      arg.type = GL_ARG_INT;
+      arg.i = value;
+    } else {
+      arg.type = GL_ARG_UINT;
+      arg.u = value;
+    }
+    return arg;
+  }
+  static GLArg MakeArg(const double value) {
+    GLArg arg;
+    arg.type = GL_ARG_FLOAT;
+    arg.f = value;
+    return arg;
+  }
+  static GLArg MakeArg(const void *value) {
+    GLArg arg;
+    arg.type = GL_ARG_POINTER;
+    arg.p = value;
+    return arg;
+  }
+};
+
+//Summary of a recorded command stream
+struct GLStatistics {
+  uint32_t calls;
+  uint32_t calls_by_category[GL_CALL_CATEGORY_COUNT];
+  uint32_t swaps;         //eglSwapBuffers, frames
+  uint64_t upload_bytes;  //Buffer and texture data
+  uint64_t uniform_bytes; //Uniform data
+  uint64_t draw_vertices; //Vertices (indices) of all draws and instances
+  uint32_t uniform_buffer_uploads; //glBuffer(Sub)Data of GL_UNIFORM_BUFFER
+  uint32_t uniform_buffer_binds;   //glBindBufferBase/Range of uniform blocks
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Recording GL/EGL backend for host builds
+ * Install() makes the recorder the GL dispatch of the process, see
+ * glDispatch.h. Every call is appended to the command stream with its
+ * arguments and data size, nothing is rendered.
+ *
+ * The recorder emulates just enough of EGL and GLES for GLContext and
+ * renderers to initialize: one display/config/context, object names,
+ * successful compiles and links, stable uniform and attribute locations,
+ * the viewport and the version/extension strings set with SetVersion()/
+ * SetExtensions(), so both ES2 and ES3 paths can be recorded.
+ *
+ * Typical use:
+ *   GLRecorder recorder;
+ *   recorder.Install();
+ *   ...init...
+ *   recorder.Clear();
+ *   ...render a frame...
+ *   GLStatistics statistics = recorder.GetStatistics();
+ */
+class GLRecorder {
+private:
+  std::vector<GLCommand> commands_;
+
+  std::string version_;
+  std::string extensions_;
+  EGLint surface_width_;
+  EGLint surface_height_;
+  GLint viewport_[4];
+  bool viewport_set_;
+  GLuint next_name_;
+  std::map<std::string, GLint> uniform_locations_;
+  std::map<std::string, GLint> attrib_locations_;
+
+  GLArg Emulate(const GLCommand &command);
+
+  GLRecorder(GLRecorder const &);
+  void operator=(GLRecorder const &);
+
+public:
+  GLRecorder();
+  virtual ~GLRecorder();
+
+  //Routes all GL/EGL calls of the process to this recorder. The destructor
+  //removes it again
+  void Install();
+
+  //GL_VERSION, starting with "OpenGL ES 3." selects the ES3 paths
+  void SetVersion(const char *version) { version_ = version; }
+  void SetExtensions(const char *extensions) { extensions_ = extensions; }
+  //Size of EGL window surfaces and the initial viewport
+  void SetSurfaceSize(const int32_t width, const int32_t height) {
+    surface_width_ = width;
+    surface_height_ = height;
+  }
+
+  const std::vector<GLCommand> &GetCommands() const { return commands_; }
+  void Clear() { commands_.clear(); }
+  GLStatistics GetStatistics() const;
+
+  //Writes the command stream one call per line, e.g.
+  //glBufferSubData(0x8892, 0, 4096, 0x7f0012345678) 4096 bytes
+  void Dump(FILE *file) const;
+
+  //Used by the dispatch thunks
+  GLCommand &Begin(const GLFunction function, const uint64_t data_size);
+  template <class T>
+  T End(const GLCommand &command);
+};
+
+//--------------------------------------------------------------------------------
+// Inlines
+//--------------------------------------------------------------------------------
+namespace gl_recorder {
+
+//Return values are carried in a GLArg
+template <class T>
+struct Result {
+  static T Get(const GLArg &arg) { return (T)arg.u; }
+};
+template <class T>
+struct Result<T *> {
+  static T *Get(const GLArg &arg) { return (T *)arg.p; }
+};
+template <>
+struct Result<void> {
+  static void Get(const GLArg &) {}
+};
+
+} //namespace gl_recorder
+
+template <class T>
+T GLRecorder::End(const GLCommand &command) {
+  return gl_recorder::Result<T>::Get(Emulate(command));
+}
+
+} //namespace ndk_helper
+
+#endif /* GLRECORDER_H_ */
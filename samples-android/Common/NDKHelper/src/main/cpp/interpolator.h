@@ -17,10 +17,13 @@
 #ifndef INTERPOLATOR_H_
 #define INTERPOLATOR_H_
 
-#include <jni.h>
 #include <errno.h>
 #include <time.h>
+
+#if defined(__ANDROID__)
+#include <jni.h>
 #include "JNIHelper.h"
+#endif
 #include "perfMonitor.h"
 #include <list>
 
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh.cpp
+//--------------------------------------------------------------------------------
+#include <stdio.h>
+
+#if defined(__ANDROID__)
+#include "JNIHelper.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mesh.h"
+
+namespace ndk_helper {
+
+static_assert(sizeof(MeshHeader) == 188, "MeshHeader is part of the file format");
+
+namespace {
+
+uint32_t Align(const uint32_t offset) {
+  return (offset + MESH_ALIGNMENT - 1) & ~(MESH_ALIGNMENT - 1);
+}
+
+//Checks that everything the header points to lies inside the file
+bool Validate(const MeshHeader &header, const size_t size) {
+  if (header.magic != MESH_MAGIC || header.version != MESH_VERSION ||
+      header.header_size != sizeof(MeshHeader) || header.file_size != size)
+    return false;
+
+  int32_t index_size = Mesh::GetIndexSize(header.index_type);
+  if (!index_size || header.vertex_offset % MESH_ALIGNMENT ||
+      header.index_offset % MESH_ALIGNMENT)
+    return false;
+  if (header.vertex_offset < sizeof(MeshHeader) ||
+      header.vertex_offset + (uint64_t)header.num_vertices *
+                                 header.vertex_stride > size ||
+      header.index_offset < sizeof(MeshHeader) ||
+      header.index_offset + (uint64_t)header.num_indices * index_size > size)
+    return false;
+
+  if (header.num_attributes > MESH_MAX_ATTRIBUTES)
+    return false;
+  for (int32_t i = 0; i < header.num_attributes; ++i) {
+    int32_t format_size = Mesh::GetFormatSize(header.attributes[i].format);
+    if (!format_size ||
+        header.attributes[i].offset + format_size > header.vertex_stride)
+      return false;
+  }
+
+  if (header.num_lods < 1 || header.num_lods > (uint32_t)MESH_MAX_LODS)
+    return false;
+  for (uint32_t i = 0; i < header.num_lods; ++i) {
+    if ((uint64_t)header.lods[i].first_index + header.lods[i].num_indices >
+        header.num_indices)
+      return false;
+  }
+  return true;
+}
+
+} //namespace
+
+Mesh::Mesh()
+    : data_(NULL), size_(0), header_(NULL),
+#if defined(__ANDROID__)
+      asset_(NULL)
+#else
+      mapping_(NULL)
+#endif
+{
+}
+
+Mesh::~Mesh() { Close(); }
+
+bool Mesh::Open(const char *file_name) {
+  Close();
+
+#if defined(__ANDROID__)
+  asset_ = JNIHelper::GetInstance()->OpenAsset(file_name);
+  if (asset_ == NULL) {
+    LOGI("Can not open a file:%s", file_name);
+    return false;
+  }
+  const void *data = AAsset_getBuffer(asset_);
+  size_t size = static_cast<size_t>(AAsset_getLength(asset_));
+#else
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    LOGI("Can not open a file:%s", file_name);
+    return false;
+  }
+  struct stat st;
+  size_t size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+  void *data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  close(fd);
+  if (data == MAP_FAILED)
+    data = NULL;
+  mapping_ = data;
+#endif
+
+  if (data == NULL || !Open(data, size)) {
+    LOGI("Invalid mesh:%s", file_name);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool Mesh::Open(const void *data, const size_t size) {
+  //The header is read in place, zipalign keeps uncompressed assets 4 byte
+  //aligned
+  if (size < sizeof(MeshHeader) || (uintptr_t)data % 4)
+    return false;
+
+  const MeshHeader *header = static_cast<const MeshHeader *>(data);
+  if (!Validate(*header, size))
+    return false;
+
+  data_ = static_cast<const uint8_t *>(data);
+  size_ = size;
+  header_ = header;
+  return true;
+}
+
+void Mesh::Close() {
+#if defined(__ANDROID__)
+  if (asset_) {
+    AAsset_close(asset_);
+    asset_ = NULL;
+  }
+#else
+  if (mapping_) {
+    munmap(mapping_, size_);
+    mapping_ = NULL;
+  }
+#endif
+  data_ = NULL;
+  size_ = 0;
+  header_ = NULL;
+}
+
+const MeshAttribute *Mesh::FindAttribute(const MESH_SEMANTIC semantic) const {
+  for (int32_t i = 0; i < header_->num_attributes; ++i) {
+    if (header_->attributes[i].semantic == semantic)
+      return &header_->attributes[i];
+  }
+  return NULL;
+}
+
+BoundingBox Mesh::GetBounds() const {
+  return BoundingBox(Vec3(header_->bounds_center),
+                     Vec3(header_->bounds_extent));
+}
+
+int32_t Mesh::GetFormatSize(const uint8_t format) {
+  switch (format) {
+  case MESH_FORMAT_FLOAT2:
+    return 2 * sizeof(float);
+  case MESH_FORMAT_FLOAT3:
+    return 3 * sizeof(float);
+  case MESH_FORMAT_HALF4:
+    return 4 * sizeof(uint16_t);
+  case MESH_FORMAT_SNORM16_2:
+    return 2 * sizeof(int16_t);
+  default:
+    return 0;
+  }
+}
+
+int32_t Mesh::GetIndexSize(const uint8_t index_type) {
+  switch (index_type) {
+  case MESH_INDEX_TYPE_UINT16:
+    return sizeof(uint16_t);
+  case MESH_INDEX_TYPE_UINT32:
+    return sizeof(uint32_t);
+  default:
+    return 0;
+  }
+}
+
+bool Mesh::Write(const char *file_name, const MeshHeader &header,
+                 const void *vertices, const void *indices) {
+  MeshHeader out = header;
+  uint32_t vertex_size = out.num_vertices * out.vertex_stride;
+  uint32_t index_size = out.num_indices * GetIndexSize(out.index_type);
+  out.magic = MESH_MAGIC;
+  out.version = MESH_VERSION;
+  out.header_size = sizeof(MeshHeader);
+  out.vertex_offset = Align(sizeof(MeshHeader));
+  out.index_offset = Align(out.vertex_offset + vertex_size);
+  out.file_size = out.index_offset + index_size;
+
+  FILE *file = fopen(file_name, "wb");
+  if (file == NULL) {
+    LOGI("Can not open a file:%s", file_name);
+    return false;
+  }
+
+  static const uint8_t PADDING[MESH_ALIGNMENT] = {};
+  bool ret =
+      fwrite(&out, sizeof(out), 1, file) == 1 &&
+      fwrite(PADDING, out.vertex_offset - sizeof(out), 1, file) <= 1 &&
+      fwrite(vertices, vertex_size, 1, file) == 1 &&
+      fwrite(PADDING, out.index_offset - out.vertex_offset - vertex_size, 1,
+             file) <= 1 &&
+      fwrite(indices, index_size, 1, file) == 1;
+  return fclose(file) == 0 && ret;
+}
+
+} //namespace ndk_helper
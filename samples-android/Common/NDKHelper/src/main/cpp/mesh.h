@@ -0,0 +1,159 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_H_
+#define MESH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__ANDROID__)
+#include <android/asset_manager.h>
+#endif
+
+#include "culling.h"
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Baked binary mesh format
+ *
+ * File layout, all values little endian:
+ *   MeshHeader
+ *   vertex data at vertex_offset, num_vertices * vertex_stride bytes,
+ *   interleaved as described by attributes[]
+ *   index data at index_offset, num_indices indices of index_type
+ * Both offsets are MESH_ALIGNMENT aligned so the data can be passed to
+ * glBufferData() straight from a mapping of the file.
+ * lods[0] is the full detail mesh, further entries are index ranges of
+ * coarser versions sharing the same vertices.
+ *
+ * Meshes are baked offline with tools/mesh_baker.
+ */
+const uint32_t MESH_MAGIC = 0x4d4b444e; //"NDKM"
+const uint16_t MESH_VERSION = 1;
+const uint32_t MESH_ALIGNMENT = 16;
+const int32_t MESH_MAX_ATTRIBUTES = 8;
+const int32_t MESH_MAX_LODS = 8;
+
+enum MESH_SEMANTIC {
+  MESH_SEMANTIC_POSITION,
+  MESH_SEMANTIC_NORMAL,
+  MESH_SEMANTIC_TEXCOORD,
+};
+
+enum MESH_FORMAT {
+  MESH_FORMAT_FLOAT2,
+  MESH_FORMAT_FLOAT3,
+  MESH_FORMAT_HALF4,     //Half floats, see vecmath_packing.h
+  MESH_FORMAT_SNORM16_2, //Octahedral encoded unit vector, see vecmath_packing.h
+};
+
+enum MESH_INDEX_TYPE {
+  MESH_INDEX_TYPE_UINT16,
+  MESH_INDEX_TYPE_UINT32,
+};
+
+struct MeshAttribute {
+  uint8_t semantic; //MESH_SEMANTIC
+  uint8_t format;   //MESH_FORMAT
+  uint16_t offset;  //From the start of the vertex
+};
+
+struct MeshLod {
+  uint32_t first_index;
+  uint32_t num_indices;
+  float error; //Object space simplification error, 0 for lods[0]
+};
+
+struct MeshHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t file_size;
+  uint32_t num_vertices;
+  uint32_t num_indices;
+  uint32_t vertex_offset;
+  uint32_t index_offset;
+  uint16_t vertex_stride;
+  uint8_t index_type; //MESH_INDEX_TYPE
+  uint8_t num_attributes;
+  uint32_t num_lods;
+  float bounds_center[3];
+  float bounds_extent[3];
+  MeshAttribute attributes[MESH_MAX_ATTRIBUTES];
+  MeshLod lods[MESH_MAX_LODS];
+};
+
+/******************************************************************
+ * Read only view of a baked mesh
+ * Open() maps the file without copying it: AAsset_getBuffer() on Android,
+ * which maps assets stored uncompressed in the APK (noCompress 'mesh' in
+ * build.gradle), mmap() on other platforms. The data stays valid until Close().
+ *
+ */
+class Mesh {
+private:
+  const uint8_t *data_;
+  size_t size_;
+  const MeshHeader *header_;
+#if defined(__ANDROID__)
+  AAsset *asset_;
+#else
+  void *mapping_;
+#endif
+
+  Mesh(const Mesh &rhs);
+  Mesh &operator=(const Mesh &rhs);
+
+public:
+  Mesh();
+  ~Mesh();
+
+  //Android: APK asset name, other platforms: file name
+  bool Open(const char *file_name);
+
+  //Uses a mesh already in memory, data must outlive the Mesh
+  bool Open(const void *data, const size_t size);
+
+  void Close();
+
+  const MeshHeader &GetHeader() const { return *header_; }
+  const void *GetVertexData() const { return data_ + header_->vertex_offset; }
+  size_t GetVertexDataSize() const {
+    return (size_t)header_->num_vertices * header_->vertex_stride;
+  }
+  const void *GetIndexData() const { return data_ + header_->index_offset; }
+  size_t GetIndexDataSize() const {
+    return (size_t)header_->num_indices * GetIndexSize(header_->index_type);
+  }
+
+  //NULL when the mesh has no attribute with this semantic
+  const MeshAttribute *FindAttribute(const MESH_SEMANTIC semantic) const;
+
+  BoundingBox GetBounds() const;
+
+  static int32_t GetFormatSize(const uint8_t format);
+  static int32_t GetIndexSize(const uint8_t index_type);
+
+  //Writes a mesh file. Offsets, sizes, magic and version of header are filled
+  //in, the rest has to be set by the caller
+  static bool Write(const char *file_name, const MeshHeader &header,
+                    const void *vertices, const void *indices);
+};
+
+} //namespace ndk_helper
+#endif /* MESH_H_ */
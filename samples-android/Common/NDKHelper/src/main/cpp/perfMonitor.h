@@ -17,10 +17,15 @@
 #ifndef PERFMONITOR_H_
 #define PERFMONITOR_H_
 
-#include <jni.h>
 #include <errno.h>
+#include <stdint.h>
 #include <time.h>
+#include <sys/time.h>
+
+#if defined(__ANDROID__)
+#include <jni.h>
 #include "JNIHelper.h"
+#endif
 
 namespace ndk_helper {
 
@@ -19,55 +19,25 @@
 #include <malloc.h>
 
 #include "shader.h"
-#include "JNIHelper.h"
 
 namespace ndk_helper {
 
 #define DEBUG (1)
 
-bool shader::CompileShader(
-    GLuint *shader, const GLenum type, const char *str_file_name,
-    const std::map<std::string, std::string> &map_parameters) {
-  std::vector<uint8_t> data;
-  if (!JNIHelper::GetInstance()->ReadFile(str_file_name, &data)) {
-    LOGI("Can not open a file:%s", str_file_name);
-    return false;
-  }
-
-  const char REPLACEMENT_TAG = '*';
-  //Fill-in parameters
-  std::string str(data.begin(), data.end());
-  std::string str_replacement_map(data.size(), ' ');
-
-  std::map<std::string, std::string>::const_iterator it =
-      map_parameters.begin();
-  std::map<std::string, std::string>::const_iterator itEnd =
-      map_parameters.end();
-  while (it != itEnd) {
-    size_t pos = 0;
-    while ((pos = str.find(it->first, pos)) != std::string::npos) {
-      //Check if the sub string is already touched
-
-      size_t replaced_pos = str_replacement_map.find(REPLACEMENT_TAG, pos);
-      if (replaced_pos == std::string::npos || replaced_pos > pos) {
-
-        str.replace(pos, it->first.length(), it->second);
-        str_replacement_map.replace(pos, it->first.length(), it->first.length(),
-                                    REPLACEMENT_TAG);
-        pos += it->second.length();
-      } else {
-        //The replacement target has been touched by other tag, skipping them
-        pos += it->second.length();
-      }
-    }
-    it++;
-  }
-
-  LOGI("Patched Shdader:\n%s", str.c_str());
+bool shader::ReadShader(const char *str_file_name,
+                        const ShaderDefines &defines, std::string *source) {
+  return ShaderPreprocessor::GetInstance()->Preprocess(str_file_name, defines,
+                                                       source);
+}
 
-  std::vector<uint8_t> v(str.begin(), str.end());
-  str.clear();
-  return shader::CompileShader(shader, type, v);
+bool shader::CompileShader(GLuint *shader, const GLenum type,
+                           const char *str_file_name,
+                           const ShaderDefines &defines) {
+  std::string source;
+  if (!ReadShader(str_file_name, defines, &source))
+    return false;
+  return shader::CompileShader(shader, type, source.data(),
+                               (int32_t)source.size());
 }
 
 bool shader::CompileShader(GLuint *shader, const GLenum type,
@@ -82,20 +52,7 @@ bool shader::CompileShader(GLuint *shader, const GLenum type,
 
   glCompileShader(*shader);
 
-#if defined(DEBUG)
-  GLint logLength;
-  glGetShaderiv(*shader, GL_INFO_LOG_LENGTH, &logLength);
-  if (logLength > 0) {
-    GLchar *log = (GLchar *)malloc(logLength);
-    glGetShaderInfoLog(*shader, logLength, &logLength, log);
-    LOGI("Shader compile log:\n%s", log);
-    free(log);
-  }
-#endif
-
-  GLint status;
-  glGetShaderiv(*shader, GL_COMPILE_STATUS, &status);
-  if (status == 0) {
+  if (!CheckShader(*shader)) {
     glDeleteShader(*shader);
     return false;
   }
@@ -115,20 +72,33 @@ bool shader::CompileShader(GLuint *shader, const GLenum type,
 
 bool shader::CompileShader(GLuint *shader, const GLenum type,
                            const char *strFileName) {
-  std::vector<uint8_t> data;
-  bool b = JNIHelper::GetInstance()->ReadFile(strFileName, &data);
-  if (!b) {
-    LOGI("Can not open a file:%s", strFileName);
-    return false;
-  }
-
-  return shader::CompileShader(shader, type, data);
+  return shader::CompileShader(shader, type, strFileName, ShaderDefines());
 }
 
 bool shader::LinkProgram(const GLuint prog) {
+  glLinkProgram(prog);
+  return CheckProgram(prog);
+}
+
+bool shader::CheckShader(const GLuint shader) {
+#if defined(DEBUG)
+  GLint logLength;
+  glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+  if (logLength > 0) {
+    GLchar *log = (GLchar *)malloc(logLength);
+    glGetShaderInfoLog(shader, logLength, &logLength, log);
+    LOGI("Shader compile log:\n%s", log);
+    free(log);
+  }
+#endif
+
   GLint status;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  return status != 0;
+}
 
-  glLinkProgram(prog);
+bool shader::CheckProgram(const GLuint prog) {
+  GLint status;
 
 #if defined(DEBUG)
   GLint logLength;
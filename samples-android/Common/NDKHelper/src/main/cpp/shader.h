@@ -17,8 +17,6 @@
 #ifndef SHADER_H_
 #define SHADER_H_
 
-#include <jni.h>
-
 #include <vector>
 #include <map>
 #include <string>
@@ -26,9 +24,15 @@
 #include <EGL/egl.h>
 #include <GLES/gl.h>
 
+#if defined(__ANDROID__)
+#include <jni.h>
 #include <android/log.h>
 
 #include "JNIHelper.h"
+#else
+#include "vecmath.h"
+#endif
+#include "shaderPreprocessor.h"
 
 namespace ndk_helper {
 
@@ -80,20 +84,37 @@ bool CompileShader(GLuint *shader, const GLenum type, const GLchar *source,
 bool CompileShader(GLuint *shader, const GLenum type, const char *strFileName);
 
 /******************************************************************
- * CompileShader() with std::map helps patching on a shader on the fly.
+ * CompileShader() with defines compiles a variant of a shader, see
+ * ShaderPreprocessor. The file may #include others.
  *
  * arguments:
  *  out: shader, shader variable
  *  in: type, shader type (i.e. GL_VERTEX_SHADER/GL_FRAGMENT_SHADER)
- *  in: mapParameters
+ *  in: str_file_name, filename
+ *  in: defines
  *      For a example,
- *      map : %KEY% -> %VALUE% replaces all %KEY% entries in the given shader
- * code to %VALUE"
+ *      map : INSTANCING -> (1) turns "#define INSTANCING (0)" in the given
+ * shader code into "#define INSTANCING (1)", or adds it when there is none
  * return: true if a shader compilation succeeded, false if it failed
  *
  */
 bool CompileShader(GLuint *shader, const GLenum type, const char *str_file_name,
-                   const std::map<std::string, std::string> &map_parameters);
+                   const ShaderDefines &defines);
+
+/******************************************************************
+ * ReadShader() preprocesses a shader like CompileShader() with defines,
+ * without compiling it. E.g. to key a program binary by the source the driver
+ * gets. Repeated reads of a variant come from memory
+ *
+ * arguments:
+ *  in: str_file_name, filename
+ *  in: defines, macro name -> value
+ *  out: source, preprocessed shader code
+ * return: true if the shader could be read, false if it failed
+ *
+ */
+bool ReadShader(const char *str_file_name, const ShaderDefines &defines,
+                std::string *source);
 
 /******************************************************************
  * LinkProgram()
@@ -105,6 +126,19 @@ bool CompileShader(GLuint *shader, const GLenum type, const char *str_file_name,
  */
 bool LinkProgram(const GLuint prog);
 
+/******************************************************************
+ * CheckShader() and CheckProgram() get the status of a compile or link
+ * issued earlier, and log it in debug builds. They wait for the driver to
+ * finish it, see ProgramBuilder to only ask once it has.
+ *
+ * arguments:
+ *  in: shader/program
+ * return: true if the compilation/linkage succeeded, false if it failed
+ *
+ */
+bool CheckShader(const GLuint shader);
+bool CheckProgram(const GLuint prog);
+
 /******************************************************************
  * validateProgram()
  *
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// shaderPreprocessor.cpp
+//--------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------
+// includes
+//--------------------------------------------------------------------------------
+#include <string.h>
+
+#include <vector>
+
+#include "shaderPreprocessor.h"
+#include "ProgramCache.h"
+#if defined(__ANDROID__)
+#include "JNIHelper.h"
+#else
+#include <stdio.h>
+#include "vecmath.h"
+#endif
+
+namespace ndk_helper {
+
+namespace {
+
+//Shader sources are APK assets on Android, paths relative to the working
+//directory in host builds
+bool ReadFile(const char *file_name, std::vector<uint8_t> *data) {
+#if defined(__ANDROID__)
+  return JNIHelper::GetInstance()->ReadFile(file_name, data);
+#else
+  FILE *file = fopen(file_name, "rb");
+  if (file == NULL)
+    return false;
+  fseek(file, 0, SEEK_END);
+  data->resize(ftell(file));
+  fseek(file, 0, SEEK_SET);
+  bool ret = fread(data->data(), 1, data->size(), file) == data->size();
+  fclose(file);
+  return ret;
+#endif
+}
+
+//--------------------------------------------------------------------------------
+// Tokens
+//--------------------------------------------------------------------------------
+const char *SkipSpaces(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t'))
+    ++p;
+  return p;
+}
+
+const char *SkipIdentifier(const char *p, const char *end) {
+  while (p < end && (*p == '_' || (*p >= 'a' && *p <= 'z') ||
+                     (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9')))
+    ++p;
+  return p;
+}
+
+bool IsToken(const char *begin, const char *end, const char *token) {
+  size_t length = strlen(token);
+  return (size_t)(end - begin) == length && memcmp(begin, token, length) == 0;
+}
+
+//Whether a block comment is open at the end of the line. Jumps between '/'
+//and '*' instead of testing every character
+bool ScanComments(const char *p, const char *end, bool comment) {
+  while (p < end) {
+    if (comment) {
+      p = (const char *)memchr(p, '*', end - p);
+      if (p == NULL || p + 1 >= end)
+        break;
+      if (p[1] == '/') {
+        comment = false;
+        p += 2;
+      } else {
+        ++p;
+      }
+    } else {
+      p = (const char *)memchr(p, '/', end - p);
+      if (p == NULL || p + 1 >= end || p[1] == '/')
+        break;
+      if (p[1] == '*') {
+        comment = true;
+        p += 2;
+      } else {
+        ++p;
+      }
+    }
+  }
+  return comment;
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------
+ShaderPreprocessor::ShaderPreprocessor() { ResetCounters(); }
+
+//--------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------
+ShaderPreprocessor::~ShaderPreprocessor() {}
+
+uint64_t ShaderPreprocessor::GetVariantKey(const char *file_name,
+                                           const ShaderDefines &defines) {
+  //Terminators separate the strings, "AB"+"C" and "A"+"BC" differ
+  uint64_t key = ProgramCache::Hash(file_name, strlen(file_name) + 1);
+  for (ShaderDefines::const_iterator it = defines.begin(); it != defines.end();
+       ++it) {
+    key = ProgramCache::Hash(it->first.c_str(), it->first.size() + 1, key);
+    key = ProgramCache::Hash(it->second.c_str(), it->second.size() + 1, key);
+  }
+  return key;
+}
+
+bool ShaderPreprocessor::Preprocess(const char *file_name,
+                                    const ShaderDefines &defines,
+                                    std::string *source) {
+  uint64_t key = GetVariantKey(file_name, defines);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::unordered_map<uint64_t, std::string>::const_iterator it =
+      sources_.find(key);
+  if (it != sources_.end()) {
+    *source = it->second;
+    ++counters_.memoized;
+    return true;
+  }
+
+  std::string str;
+  std::set<std::string> included;
+  std::set<std::string> defined;
+  size_t version_end = 0;
+  included.insert(file_name);
+  if (!Process(file_name, defines, 0, &included, &defined, &version_end, &str))
+    return false;
+
+  //Defines the source doesn't have, #version must stay first
+  std::string injected;
+  for (ShaderDefines::const_iterator define = defines.begin();
+       define != defines.end(); ++define) {
+    if (defined.find(define->first) == defined.end())
+      injected += "#define " + define->first + " " + define->second + "\n";
+  }
+  str.insert(version_end, injected);
+
+  ++counters_.preprocessed;
+  *source = str;
+  sources_[key].swap(str);
+  return true;
+}
+
+bool ShaderPreprocessor::Process(const std::string &file_name,
+                                 const ShaderDefines &defines,
+                                 const int32_t depth,
+                                 std::set<std::string> *included,
+                                 std::set<std::string> *defined,
+                                 size_t *version_end, std::string *source) {
+  std::vector<uint8_t> data;
+  if (!ReadFile(file_name.c_str(), &data)) {
+    LOGI("Can not open a file:%s", file_name.c_str());
+    return false;
+  }
+  source->reserve(source->size() + data.size());
+
+  //Lines between directives are copied in one piece
+  const char *p = (const char *)data.data();
+  const char *end = p + data.size();
+  const char *copied = p;
+  bool comment = false;
+  while (p < end) {
+    const char *line_end = (const char *)memchr(p, '\n', end - p);
+    line_end = line_end ? line_end + 1 : end;
+
+    //Directives start a line outside of block comments
+    const char *token = SkipSpaces(p, line_end);
+    if (!comment && token < line_end && *token == '#') {
+      token = SkipSpaces(token + 1, line_end);
+      const char *token_end = SkipIdentifier(token, line_end);
+      bool replaced = true;
+
+      if (IsToken(token, token_end, "include")) {
+        const char *name = SkipSpaces(token_end, line_end);
+        const char *name_end = NULL;
+        if (name < line_end && (*name == '"' || *name == '<'))
+          name_end = (const char *)memchr(name + 1, *name == '"' ? '"' : '>',
+                                          line_end - name - 1);
+        if (name_end == NULL) {
+          LOGI("Invalid #include in %s", file_name.c_str());
+          return false;
+        }
+        if (depth + 1 >= SHADER_MAX_INCLUDE_DEPTH) {
+          LOGI("Too deeply nested #include in %s", file_name.c_str());
+          return false;
+        }
+
+        //Relative to the including file
+        std::string include_name =
+            file_name.substr(0, file_name.rfind('/') + 1) +
+            std::string(name + 1, name_end);
+        source->append(copied, p);
+        if (included->insert(include_name).second) {
+          if (!Process(include_name, defines, depth + 1, included, defined,
+                       version_end, source))
+            return false;
+          if (!source->empty() && (*source)[source->size() - 1] != '\n')
+            *source += '\n';
+        }
+      } else if (IsToken(token, token_end, "define")) {
+        const char *name = SkipSpaces(token_end, line_end);
+        std::string define_name(name, SkipIdentifier(name, line_end));
+        ShaderDefines::const_iterator it = defines.find(define_name);
+        if (it != defines.end()) {
+          defined->insert(define_name);
+          source->append(copied, p);
+          source->append("#define ").append(define_name).append(" ");
+          source->append(it->second).append("\n");
+        } else {
+          replaced = false;
+        }
+      } else if (IsToken(token, token_end, "version") && depth == 0) {
+        source->append(copied, line_end);
+        if (line_end == end)
+          *source += '\n';
+        *version_end = source->size();
+      } else {
+        replaced = false;
+      }
+      if (replaced)
+        copied = line_end;
+    }
+
+    comment = ScanComments(p, line_end, comment);
+    p = line_end;
+  }
+  source->append(copied, end);
+  return true;
+}
+
+void ShaderPreprocessor::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sources_.clear();
+}
+
+ShaderPreprocessorCounters ShaderPreprocessor::GetCounters() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return counters_;
+}
+
+void ShaderPreprocessor::ResetCounters() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  memset(&counters_, 0, sizeof(counters_));
+}
+
+} //namespace ndk_helper
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// shaderPreprocessor.h
+//--------------------------------------------------------------------------------
+#ifndef SHADERPREPROCESSOR_H_
+#define SHADERPREPROCESSOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace ndk_helper {
+
+//--------------------------------------------------------------------------------
+// Constants
+//--------------------------------------------------------------------------------
+//Macro name -> value of a shader variant, e.g. "INSTANCING" -> "(1)"
+typedef std::map<std::string, std::string> ShaderDefines;
+
+//Nested #include levels
+const int32_t SHADER_MAX_INCLUDE_DEPTH = 8;
+
+struct ShaderPreprocessorCounters {
+  uint32_t preprocessed; //Variants read and preprocessed
+  uint32_t memoized;     //Variants returned from memory
+};
+
+//--------------------------------------------------------------------------------
+// Class
+//--------------------------------------------------------------------------------
+
+/******************************************************************
+ * Shader preprocessor
+ * Turns a shader file and a set of defines into the source of one variant,
+ * in a single pass over the lines of the file:
+ * - #include "file" is replaced with the preprocessed file, relative to the
+ *   including one. A file is included once per variant, later includes of it
+ *   and include cycles are dropped.
+ * - #define NAME of a name in the defines gets the value of the defines
+ *   instead of its own, defines the source doesn't have are added after
+ *   #version (or at the top). So the source states the defaults of all
+ *   options and a variant only lists what it changes.
+ * - Everything else, including #if and the other directives, is left to the
+ *   GLSL compiler. Directives in comments are ignored.
+ *
+ * Files are APK assets on Android, relative to the working directory on host.
+ * A variant is read and preprocessed once, later requests return the memoized
+ * source, keyed by GetVariantKey() of the file and defines. Assets don't
+ * change, Clear() drops the sources e.g. after a file on host has.
+ *
+ * Thread safety: Preprocess() may be called from any thread
+ */
+class ShaderPreprocessor {
+private:
+  std::unordered_map<uint64_t, std::string> sources_; //By variant key
+  std::mutex mutex_;
+  ShaderPreprocessorCounters counters_;
+
+  bool Process(const std::string &file_name, const ShaderDefines &defines,
+               const int32_t depth, std::set<std::string> *included,
+               std::set<std::string> *defined, size_t *version_end,
+               std::string *source);
+
+  ShaderPreprocessor(ShaderPreprocessor const &);
+  void operator=(ShaderPreprocessor const &);
+  ShaderPreprocessor();
+  virtual ~ShaderPreprocessor();
+
+public:
+  static ShaderPreprocessor *GetInstance() {
+    //Singleton
+    static ShaderPreprocessor instance;
+
+    return &instance;
+  }
+
+  static uint64_t GetVariantKey(const char *file_name,
+                                const ShaderDefines &defines);
+
+  //Source of the variant of file_name, false if a file can't be read
+  bool Preprocess(const char *file_name, const ShaderDefines &defines,
+                  std::string *source);
+  void Clear();
+
+  ShaderPreprocessorCounters GetCounters();
+  void ResetCounters();
+};
+
+} //namespace ndk_helper
+
+#endif /* SHADERPREPROCESSOR_H_ */
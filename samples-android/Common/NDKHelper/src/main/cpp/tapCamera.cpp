@@ -72,6 +72,9 @@ void TapCamera::InitParameters() {
   vec_offset_delta_ = Vec3();
 
   momentum_ = false;
+
+  quat_ball_last_ = quat_ball_previous_ = quat_ball_now_;
+  vec_transform_last_ = vec_transform_previous_ = Vec3();
 }
 
 //----------------------------------------------------------
@@ -121,6 +124,21 @@ void TapCamera::Update(const double time) {
   vec *= vec_tmp * vec_pinch_transform_factor_;
 
   mat_transform_ = Mat4::Translation(vec);
+
+  quat_ball_previous_ = quat_ball_last_;
+  quat_ball_last_ = quat_ball_now_;
+  vec_transform_previous_ = vec_transform_last_;
+  vec_transform_last_ = vec;
+}
+
+void TapCamera::Interpolate(const float alpha, Mat4 *rotation,
+                            Mat4 *transform) const {
+  Quaternion quat = Quaternion::Nlerp(quat_ball_previous_, quat_ball_last_,
+                                      alpha);
+  quat.ToMatrix(*rotation);
+  *transform = Mat4::Translation(
+      vec_transform_previous_ +
+      (vec_transform_last_ - vec_transform_previous_) * alpha);
 }
 
 Mat4 &TapCamera::GetRotationMatrix() { return mat_rotation_; }
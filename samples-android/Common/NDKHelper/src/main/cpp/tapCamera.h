@@ -17,9 +17,12 @@
 #pragma once
 #include <vector>
 #include <string>
+
+#if defined(__ANDROID__)
 #include <GLES2/gl2.h>
 
 #include "JNIHelper.h"
+#endif
 #include "vecmath.h"
 #include "interpolator.h"
 
@@ -75,6 +78,12 @@ private:
 
   Vec3 vec_pinch_transform_factor_;
 
+  //Rotation and translation after the last two Update() calls
+  Quaternion quat_ball_last_;
+  Quaternion quat_ball_previous_;
+  Vec3 vec_transform_last_;
+  Vec3 vec_transform_previous_;
+
   Vec3 PointOnSphere(Vec2 &point);
   void BallUpdate();
   void InitParameters();
@@ -89,6 +98,9 @@ public:
 
   Mat4 &GetRotationMatrix();
   Mat4 &GetTransformMatrix();
+  //Rotation and transform matrices between the last two Update() calls, for
+  //rendering between fixed simulation steps. alpha 1 is the last one
+  void Interpolate(const float alpha, Mat4 *rotation, Mat4 *transform) const;
 
   void BeginPinch(const Vec2 &v1, const Vec2 &v2);
   void EndPinch();
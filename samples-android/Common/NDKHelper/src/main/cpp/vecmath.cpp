@@ -18,108 +18,308 @@
 // vecmath.cpp
 //--------------------------------------------------------------------------------
 #include "vecmath.h"
+#include "vecmath_simd.h"
 
-namespace ndk_helper {
+//Every product and sum of the SIMD and reference kernels is rounded on its
+//own. Clang contracts a * b + c in the reference to a fused multiply-add by
+//default on arm64, GCC with -ffp-contract=fast fuses SSE MulAdd() as well
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
 
-//--------------------------------------------------------------------------------
-// vec3
-//--------------------------------------------------------------------------------
-Vec3::Vec3(const Vec4 &vec) {
-  x_ = vec.x_;
-  y_ = vec.y_;
-  z_ = vec.z_;
-}
+namespace ndk_helper {
 
 //--------------------------------------------------------------------------------
 // vec4
 //--------------------------------------------------------------------------------
 Vec4 Vec4::operator*(const Mat4 &rhs) const {
   Vec4 out;
-  out.x_ = x_ * rhs.f_[0] + y_ * rhs.f_[1] + z_ * rhs.f_[2] + w_ * rhs.f_[3];
-  out.y_ = x_ * rhs.f_[4] + y_ * rhs.f_[5] + z_ * rhs.f_[6] + w_ * rhs.f_[7];
-  out.z_ = x_ * rhs.f_[8] + y_ * rhs.f_[9] + z_ * rhs.f_[10] + w_ * rhs.f_[11];
-  out.w_ =
-      x_ * rhs.f_[12] + y_ * rhs.f_[13] + z_ * rhs.f_[14] + w_ * rhs.f_[15];
+#if defined(NDK_HELPER_SIMD)
+  simd::float4 v = simd::Load(&x_);
+  simd::float4 r0 = simd::Mul(v, simd::Load(rhs.f_));
+  simd::float4 r1 = simd::Mul(v, simd::Load(rhs.f_ + 4));
+  simd::float4 r2 = simd::Mul(v, simd::Load(rhs.f_ + 8));
+  simd::float4 r3 = simd::Mul(v, simd::Load(rhs.f_ + 12));
+  //Horizontal sums, accumulated x, y, z, w in the same order as the reference
+  simd::Transpose(r0, r1, r2, r3);
+  simd::Store(&out.x_, simd::Add(simd::Add(simd::Add(r0, r1), r2), r3));
+#else
+  reference::MultiplyVec4Mat4(&x_, rhs.f_, &out.x_);
+#endif
   return out;
 }
 
 //--------------------------------------------------------------------------------
 // mat4
 //--------------------------------------------------------------------------------
-Mat4::Mat4() {
-  f_[0] = 1.f;
-  f_[1] = 0;
-  f_[2] = 0;
-  f_[3] = 0;
-  f_[4] = 0;
-  f_[5] = 1.f;
-  f_[6] = 0;
-  f_[7] = 0;
-  f_[8] = 0;
-  f_[9] = 0;
-  f_[10] = 1.f;
-  f_[11] = 0;
-  f_[12] = 0;
-  f_[13] = 0;
-  f_[14] = 0;
-  f_[15] = 1.f;
-}
-
 Mat4::Mat4(const float *mIn) {
   for (int32_t i = 0; i < 16; ++i)
     f_[i] = mIn[i];
 }
 
 Mat4 Mat4::operator*(const Mat4 &rhs) const {
-  Mat4 ret;
-  ret.f_[0] = f_[0] * rhs.f_[0] + f_[4] * rhs.f_[1] + f_[8] * rhs.f_[2] +
-              f_[12] * rhs.f_[3];
-  ret.f_[1] = f_[1] * rhs.f_[0] + f_[5] * rhs.f_[1] + f_[9] * rhs.f_[2] +
-              f_[13] * rhs.f_[3];
-  ret.f_[2] = f_[2] * rhs.f_[0] + f_[6] * rhs.f_[1] + f_[10] * rhs.f_[2] +
-              f_[14] * rhs.f_[3];
-  ret.f_[3] = f_[3] * rhs.f_[0] + f_[7] * rhs.f_[1] + f_[11] * rhs.f_[2] +
-              f_[15] * rhs.f_[3];
-
-  ret.f_[4] = f_[0] * rhs.f_[4] + f_[4] * rhs.f_[5] + f_[8] * rhs.f_[6] +
-              f_[12] * rhs.f_[7];
-  ret.f_[5] = f_[1] * rhs.f_[4] + f_[5] * rhs.f_[5] + f_[9] * rhs.f_[6] +
-              f_[13] * rhs.f_[7];
-  ret.f_[6] = f_[2] * rhs.f_[4] + f_[6] * rhs.f_[5] + f_[10] * rhs.f_[6] +
-              f_[14] * rhs.f_[7];
-  ret.f_[7] = f_[3] * rhs.f_[4] + f_[7] * rhs.f_[5] + f_[11] * rhs.f_[6] +
-              f_[15] * rhs.f_[7];
-
-  ret.f_[8] = f_[0] * rhs.f_[8] + f_[4] * rhs.f_[9] + f_[8] * rhs.f_[10] +
-              f_[12] * rhs.f_[11];
-  ret.f_[9] = f_[1] * rhs.f_[8] + f_[5] * rhs.f_[9] + f_[9] * rhs.f_[10] +
-              f_[13] * rhs.f_[11];
-  ret.f_[10] = f_[2] * rhs.f_[8] + f_[6] * rhs.f_[9] + f_[10] * rhs.f_[10] +
-               f_[14] * rhs.f_[11];
-  ret.f_[11] = f_[3] * rhs.f_[8] + f_[7] * rhs.f_[9] + f_[11] * rhs.f_[10] +
-               f_[15] * rhs.f_[11];
-
-  ret.f_[12] = f_[0] * rhs.f_[12] + f_[4] * rhs.f_[13] + f_[8] * rhs.f_[14] +
-               f_[12] * rhs.f_[15];
-  ret.f_[13] = f_[1] * rhs.f_[12] + f_[5] * rhs.f_[13] + f_[9] * rhs.f_[14] +
-               f_[13] * rhs.f_[15];
-  ret.f_[14] = f_[2] * rhs.f_[12] + f_[6] * rhs.f_[13] + f_[10] * rhs.f_[14] +
-               f_[14] * rhs.f_[15];
-  ret.f_[15] = f_[3] * rhs.f_[12] + f_[7] * rhs.f_[13] + f_[11] * rhs.f_[14] +
-               f_[15] * rhs.f_[15];
-
+  Mat4 ret(MAT4_UNINITIALIZED);
+  Multiply(ret, *this, rhs);
   return ret;
 }
 
+void Mat4::Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b) {
+#if defined(NDK_HELPER_SIMD)
+  //Columns of a are loaded up front and column i of b is read before column
+  //i of out is written, so out may alias either operand
+  simd::float4 c0 = simd::Load(a.f_);
+  simd::float4 c1 = simd::Load(a.f_ + 4);
+  simd::float4 c2 = simd::Load(a.f_ + 8);
+  simd::float4 c3 = simd::Load(a.f_ + 12);
+  for (int32_t i = 0; i < 16; i += 4) {
+    simd::float4 r = simd::Mul(c0, simd::Splat(b.f_[i]));
+    r = simd::MulAdd(r, c1, simd::Splat(b.f_[i + 1]));
+    r = simd::MulAdd(r, c2, simd::Splat(b.f_[i + 2]));
+    r = simd::MulAdd(r, c3, simd::Splat(b.f_[i + 3]));
+    simd::Store(out.f_ + i, r);
+  }
+#else
+  float ret[16];
+  reference::MultiplyMat4(a.f_, b.f_, ret);
+  for (int32_t i = 0; i < 16; ++i)
+    out.f_[i] = ret[i];
+#endif
+}
+
+namespace {
+
+//m * v, m given by its columns and v a column vector in memory
+inline simd::float4 MultiplyColumn(const simd::float4 m0, const simd::float4 m1,
+                                   const simd::float4 m2, const simd::float4 m3,
+                                   const float *v) {
+  simd::float4 r = simd::Mul(m0, simd::Splat(v[0]));
+  r = simd::MulAdd(r, m1, simd::Splat(v[1]));
+  r = simd::MulAdd(r, m2, simd::Splat(v[2]));
+  return simd::MulAdd(r, m3, simd::Splat(v[3]));
+}
+
+//out = lhs * rhs[0] * rhs[1] ..., left to right. The running product stays
+//in registers and out is only written once every operand has been read
+void MultiplyChain(float *out, const float *lhs, const float *const *rhs,
+                   const int32_t count) {
+  simd::float4 c0 = simd::Load(lhs);
+  simd::float4 c1 = simd::Load(lhs + 4);
+  simd::float4 c2 = simd::Load(lhs + 8);
+  simd::float4 c3 = simd::Load(lhs + 12);
+  for (int32_t i = 0; i < count; ++i) {
+    const float *m = rhs[i];
+    simd::float4 r0 = MultiplyColumn(c0, c1, c2, c3, m);
+    simd::float4 r1 = MultiplyColumn(c0, c1, c2, c3, m + 4);
+    simd::float4 r2 = MultiplyColumn(c0, c1, c2, c3, m + 8);
+    simd::float4 r3 = MultiplyColumn(c0, c1, c2, c3, m + 12);
+    c0 = r0;
+    c1 = r1;
+    c2 = r2;
+    c3 = r3;
+  }
+  simd::Store(out, c0);
+  simd::Store(out + 4, c1);
+  simd::Store(out + 8, c2);
+  simd::Store(out + 12, c3);
+}
+
+} //namespace
+
+void Mat4::Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b, const Mat4 &c) {
+  const float *rhs[2] = { b.f_, c.f_ };
+  MultiplyChain(out.f_, a.f_, rhs, 2);
+}
+
+void Mat4::Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b, const Mat4 &c,
+                    const Mat4 &d) {
+  const float *rhs[3] = { b.f_, c.f_, d.f_ };
+  MultiplyChain(out.f_, a.f_, rhs, 3);
+}
+
 Vec4 Mat4::operator*(const Vec4 &rhs) const {
   Vec4 ret;
-  ret.x_ = rhs.x_ * f_[0] + rhs.y_ * f_[4] + rhs.z_ * f_[8] + rhs.w_ * f_[12];
-  ret.y_ = rhs.x_ * f_[1] + rhs.y_ * f_[5] + rhs.z_ * f_[9] + rhs.w_ * f_[13];
-  ret.z_ = rhs.x_ * f_[2] + rhs.y_ * f_[6] + rhs.z_ * f_[10] + rhs.w_ * f_[14];
-  ret.w_ = rhs.x_ * f_[3] + rhs.y_ * f_[7] + rhs.z_ * f_[11] + rhs.w_ * f_[15];
+#if defined(NDK_HELPER_SIMD)
+  simd::float4 r = simd::Mul(simd::Load(f_), simd::Splat(rhs.x_));
+  r = simd::MulAdd(r, simd::Load(f_ + 4), simd::Splat(rhs.y_));
+  r = simd::MulAdd(r, simd::Load(f_ + 8), simd::Splat(rhs.z_));
+  r = simd::MulAdd(r, simd::Load(f_ + 12), simd::Splat(rhs.w_));
+  simd::Store(&ret.x_, r);
+#else
+  reference::MultiplyMat4Vec4(f_, &rhs.x_, &ret.x_);
+#endif
   return ret;
 }
 
+namespace {
+
+enum TRANSFORM_MODE {
+  TRANSFORM_POINT,
+  TRANSFORM_DIRECTION,
+  TRANSFORM_PROJECT,
+};
+
+//Transform packed xyz triples, one element per iteration
+template <TRANSFORM_MODE mode>
+void TransformXYZ(const float *m, const float *in, float *out,
+                  const int32_t count) {
+  const simd::float4 c0 = simd::Load(m);
+  const simd::float4 c1 = simd::Load(m + 4);
+  const simd::float4 c2 = simd::Load(m + 8);
+  const simd::float4 c3 = simd::Load(m + 12);
+  float f[4];
+  for (int32_t i = 0; i < count; ++i, in += 3, out += 3) {
+    simd::float4 r = simd::Mul(c0, simd::Splat(in[0]));
+    r = simd::MulAdd(r, c1, simd::Splat(in[1]));
+    r = simd::MulAdd(r, c2, simd::Splat(in[2]));
+    if (mode != TRANSFORM_DIRECTION)
+      r = simd::Add(r, c3);
+    if (mode == TRANSFORM_PROJECT)
+      r = simd::Div(r, simd::SplatLane<3>(r));
+    simd::Store(f, r);
+    out[0] = f[0];
+    out[1] = f[1];
+    out[2] = f[2];
+  }
+}
+
+//Transform separate x, y, z streams, four elements per iteration
+template <TRANSFORM_MODE mode>
+void TransformStreams(const float *m, const float *in_x, const float *in_y,
+                      const float *in_z, float *out_x, float *out_y,
+                      float *out_z, const int32_t count) {
+  int32_t i = 0;
+#if defined(NDK_HELPER_SIMD)
+  const simd::float4 m0 = simd::Splat(m[0]);
+  const simd::float4 m1 = simd::Splat(m[1]);
+  const simd::float4 m2 = simd::Splat(m[2]);
+  const simd::float4 m3 = simd::Splat(m[3]);
+  const simd::float4 m4 = simd::Splat(m[4]);
+  const simd::float4 m5 = simd::Splat(m[5]);
+  const simd::float4 m6 = simd::Splat(m[6]);
+  const simd::float4 m7 = simd::Splat(m[7]);
+  const simd::float4 m8 = simd::Splat(m[8]);
+  const simd::float4 m9 = simd::Splat(m[9]);
+  const simd::float4 m10 = simd::Splat(m[10]);
+  const simd::float4 m11 = simd::Splat(m[11]);
+  const simd::float4 m12 = simd::Splat(m[12]);
+  const simd::float4 m13 = simd::Splat(m[13]);
+  const simd::float4 m14 = simd::Splat(m[14]);
+  const simd::float4 m15 = simd::Splat(m[15]);
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x = simd::Load(in_x + i);
+    simd::float4 y = simd::Load(in_y + i);
+    simd::float4 z = simd::Load(in_z + i);
+
+    simd::float4 rx =
+        simd::MulAdd(simd::MulAdd(simd::Mul(x, m0), y, m4), z, m8);
+    simd::float4 ry =
+        simd::MulAdd(simd::MulAdd(simd::Mul(x, m1), y, m5), z, m9);
+    simd::float4 rz =
+        simd::MulAdd(simd::MulAdd(simd::Mul(x, m2), y, m6), z, m10);
+    if (mode != TRANSFORM_DIRECTION) {
+      rx = simd::Add(rx, m12);
+      ry = simd::Add(ry, m13);
+      rz = simd::Add(rz, m14);
+    }
+    if (mode == TRANSFORM_PROJECT) {
+      simd::float4 rw = simd::Add(
+          simd::MulAdd(simd::MulAdd(simd::Mul(x, m3), y, m7), z, m11), m15);
+      rx = simd::Div(rx, rw);
+      ry = simd::Div(ry, rw);
+      rz = simd::Div(rz, rw);
+    }
+    simd::Store(out_x + i, rx);
+    simd::Store(out_y + i, ry);
+    simd::Store(out_z + i, rz);
+  }
+#endif
+  for (; i < count; ++i) {
+    const float x = in_x[i];
+    const float y = in_y[i];
+    const float z = in_z[i];
+    float rx = x * m[0] + y * m[4] + z * m[8];
+    float ry = x * m[1] + y * m[5] + z * m[9];
+    float rz = x * m[2] + y * m[6] + z * m[10];
+    if (mode != TRANSFORM_DIRECTION) {
+      rx += m[12];
+      ry += m[13];
+      rz += m[14];
+    }
+    if (mode == TRANSFORM_PROJECT) {
+      //Same division as the vector body, on ARMv7 NEON an estimate
+      const float rw = x * m[3] + y * m[7] + z * m[11] + m[15];
+      float f[4];
+      simd::Store(f, simd::Div(simd::Set(rx, ry, rz, rw), simd::Splat(rw)));
+      rx = f[0];
+      ry = f[1];
+      rz = f[2];
+    }
+    out_x[i] = rx;
+    out_y[i] = ry;
+    out_z[i] = rz;
+  }
+}
+
+} //namespace
+
+//Batch transforms address Vec3/Vec4 arrays as packed floats
+static_assert(sizeof(Vec3) == sizeof(float) * 3, "Vec3 must be packed");
+static_assert(sizeof(Vec4) == sizeof(float) * 4, "Vec4 must be packed");
+
+void Mat4::TransformPoints(const Vec3 *in, Vec3 *out,
+                           const int32_t count) const {
+  TransformXYZ<TRANSFORM_POINT>(f_, &in->x_, &out->x_, count);
+}
+
+void Mat4::TransformPoints(const Vec4 *in, Vec4 *out,
+                           const int32_t count) const {
+  const simd::float4 c0 = simd::Load(f_);
+  const simd::float4 c1 = simd::Load(f_ + 4);
+  const simd::float4 c2 = simd::Load(f_ + 8);
+  const simd::float4 c3 = simd::Load(f_ + 12);
+  for (int32_t i = 0; i < count; ++i) {
+    simd::float4 v = simd::Load(&in[i].x_);
+    simd::float4 r = simd::Mul(c0, simd::SplatLane<0>(v));
+    r = simd::MulAdd(r, c1, simd::SplatLane<1>(v));
+    r = simd::MulAdd(r, c2, simd::SplatLane<2>(v));
+    r = simd::MulAdd(r, c3, simd::SplatLane<3>(v));
+    simd::Store(&out[i].x_, r);
+  }
+}
+
+void Mat4::TransformDirections(const Vec3 *in, Vec3 *out,
+                               const int32_t count) const {
+  TransformXYZ<TRANSFORM_DIRECTION>(f_, &in->x_, &out->x_, count);
+}
+
+void Mat4::TransformAndProject(const Vec3 *in, Vec3 *out,
+                               const int32_t count) const {
+  TransformXYZ<TRANSFORM_PROJECT>(f_, &in->x_, &out->x_, count);
+}
+
+void Mat4::TransformPoints(const float *in_x, const float *in_y,
+                           const float *in_z, float *out_x, float *out_y,
+                           float *out_z, const int32_t count) const {
+  TransformStreams<TRANSFORM_POINT>(f_, in_x, in_y, in_z, out_x, out_y, out_z,
+                                    count);
+}
+
+void Mat4::TransformDirections(const float *in_x, const float *in_y,
+                               const float *in_z, float *out_x, float *out_y,
+                               float *out_z, const int32_t count) const {
+  TransformStreams<TRANSFORM_DIRECTION>(f_, in_x, in_y, in_z, out_x, out_y,
+                                        out_z, count);
+}
+
+void Mat4::TransformAndProject(const float *in_x, const float *in_y,
+                               const float *in_z, float *out_x, float *out_y,
+                               float *out_z, const int32_t count) const {
+  TransformStreams<TRANSFORM_PROJECT>(f_, in_x, in_y, in_z, out_x, out_y,
+                                      out_z, count);
+}
+
 Mat4 Mat4::Inverse() {
   Mat4 ret;
   float det_1;
@@ -195,7 +395,7 @@ Mat4 Mat4::Inverse() {
 // Misc
 //--------------------------------------------------------------------------------
 Mat4 Mat4::RotationX(const float fAngle) {
-  Mat4 ret;
+  Mat4 ret(MAT4_UNINITIALIZED);
   float fCosine, fSine;
 
   fCosine = cosf(fAngle);
@@ -221,7 +421,7 @@ Mat4 Mat4::RotationX(const float fAngle) {
 }
 
 Mat4 Mat4::RotationY(const float fAngle) {
-  Mat4 ret;
+  Mat4 ret(MAT4_UNINITIALIZED);
   float fCosine, fSine;
 
   fCosine = cosf(fAngle);
@@ -248,7 +448,7 @@ Mat4 Mat4::RotationY(const float fAngle) {
 }
 
 Mat4 Mat4::RotationZ(const float fAngle) {
-  Mat4 ret;
+  Mat4 ret(MAT4_UNINITIALIZED);
   float fCosine, fSine;
 
   fCosine = cosf(fAngle);
@@ -273,116 +473,6 @@ Mat4 Mat4::RotationZ(const float fAngle) {
   return ret;
 }
 
-Mat4 Mat4::Scale(const float scaleX, const float scaleY, const float scaleZ) {
-  Mat4 ret;
-  ret.f_[0] = scaleX;
-  ret.f_[5] = scaleY;
-  ret.f_[10] = scaleZ;
-  ret.f_[1] = ret.f_[2] = ret.f_[3] = ret.f_[4] = ret.f_[6] = ret.f_[7] =
-      ret.f_[8] = ret.f_[9] = ret.f_[11] = ret.f_[12] = ret.f_[13] =
-          ret.f_[14] = 0.f;
-  ret.f_[15] = 1.0f;
-  return ret;
-}
-
-Mat4 Mat4::Translation(const float fX, const float fY, const float fZ) {
-  Mat4 ret;
-  ret.f_[0] = 1.0f;
-  ret.f_[4] = 0.0f;
-  ret.f_[8] = 0.0f;
-  ret.f_[12] = fX;
-  ret.f_[1] = 0.0f;
-  ret.f_[5] = 1.0f;
-  ret.f_[9] = 0.0f;
-  ret.f_[13] = fY;
-  ret.f_[2] = 0.0f;
-  ret.f_[6] = 0.0f;
-  ret.f_[10] = 1.0f;
-  ret.f_[14] = fZ;
-  ret.f_[3] = 0.0f;
-  ret.f_[7] = 0.0f;
-  ret.f_[11] = 0.0f;
-  ret.f_[15] = 1.0f;
-  return ret;
-}
-
-Mat4 Mat4::Translation(const Vec3 vec) {
-  Mat4 ret;
-  ret.f_[0] = 1.0f;
-  ret.f_[4] = 0.0f;
-  ret.f_[8] = 0.0f;
-  ret.f_[12] = vec.x_;
-  ret.f_[1] = 0.0f;
-  ret.f_[5] = 1.0f;
-  ret.f_[9] = 0.0f;
-  ret.f_[13] = vec.y_;
-  ret.f_[2] = 0.0f;
-  ret.f_[6] = 0.0f;
-  ret.f_[10] = 1.0f;
-  ret.f_[14] = vec.z_;
-  ret.f_[3] = 0.0f;
-  ret.f_[7] = 0.0f;
-  ret.f_[11] = 0.0f;
-  ret.f_[15] = 1.0f;
-  return ret;
-}
-
-Mat4 Mat4::Perspective(float width, float height, float nearPlane,
-                       float farPlane) {
-  float n2 = 2.0f * nearPlane;
-  float rcpnmf = 1.f / (nearPlane - farPlane);
-
-  Mat4 result;
-  result.f_[0] = n2 / width;
-  result.f_[4] = 0;
-  result.f_[8] = 0;
-  result.f_[12] = 0;
-  result.f_[1] = 0;
-  result.f_[5] = n2 / height;
-  result.f_[9] = 0;
-  result.f_[13] = 0;
-  result.f_[2] = 0;
-  result.f_[6] = 0;
-  result.f_[10] = (farPlane + nearPlane) * rcpnmf;
-  result.f_[14] = farPlane * rcpnmf * n2;
-  result.f_[3] = 0;
-  result.f_[7] = 0;
-  result.f_[11] = -1.0;
-  result.f_[15] = 0;
-
-  return result;
-}
-
-Mat4 Mat4::Ortho2D(float left, float top, float right, float bottom) {
-  const float zNear = -1.0f;
-  const float zFar = 1.0f;
-  const float inv_z = 1.0f / (zFar - zNear);
-  const float inv_y = 1.0f / (-top + bottom);
-  const float inv_x = 1.0f / (right - left);
-
-  Mat4 result;
-  result.f_[0] = 2.0f * inv_x;
-  result.f_[1] = 0.0f;
-  result.f_[2] = 0.0f;
-  result.f_[3] = 0.0f;
-
-  result.f_[4] = 0.0f;
-  result.f_[5] = 2.0 * inv_y;
-  result.f_[6] = 0.0f;
-  result.f_[7] = 0.0f;
-
-  result.f_[8] = 0.0f;
-  result.f_[9] = 0.0f;
-  result.f_[10] = -2.0f * inv_z;
-  result.f_[11] = 0.0f;
-
-  result.f_[12] = -(right + left) * inv_x;
-  result.f_[13] = (top + bottom) * inv_y;
-  result.f_[14] = -(zFar + zNear) * inv_z;
-  result.f_[15] = 1.0f;
-  return result;
-}
-
 Mat4 Mat4::LookAt(const Vec3 &vec_eye, const Vec3 &vec_at, const Vec3 &vec_up) {
   Vec3 vec_forward, vec_up_norm, vec_side;
   Mat4 result;
@@ -418,4 +508,490 @@ Mat4 Mat4::LookAt(const Vec3 &vec_eye, const Vec3 &vec_at, const Vec3 &vec_up) {
   return result;
 }
 
+//--------------------------------------------------------------------------------
+// AffineTransform
+//--------------------------------------------------------------------------------
+AffineTransform::AffineTransform(const Mat4 &mat) {
+  for (int32_t row = 0; row < 3; ++row) {
+    r_[row * 4] = mat.f_[row];
+    r_[row * 4 + 1] = mat.f_[row + 4];
+    r_[row * 4 + 2] = mat.f_[row + 8];
+    r_[row * 4 + 3] = mat.f_[row + 12];
+  }
+}
+
+AffineTransform::AffineTransform(const Quaternion &rotation,
+                                 const Vec3 &translation) {
+  const float x = rotation.x_;
+  const float y = rotation.y_;
+  const float z = rotation.z_;
+  const float w = rotation.w_;
+  float x2 = x * x * 2.0f;
+  float y2 = y * y * 2.0f;
+  float z2 = z * z * 2.0f;
+  float xy = x * y * 2.0f;
+  float yz = y * z * 2.0f;
+  float zx = z * x * 2.0f;
+  float xw = x * w * 2.0f;
+  float yw = y * w * 2.0f;
+  float zw = z * w * 2.0f;
+
+  //Same terms as Quaternion::ToMatrix(), stored row by row
+  r_[0] = 1.0f - y2 - z2;
+  r_[1] = xy - zw;
+  r_[2] = zx + yw;
+  r_[3] = translation.x_;
+  r_[4] = xy + zw;
+  r_[5] = 1.0f - z2 - x2;
+  r_[6] = yz - xw;
+  r_[7] = translation.y_;
+  r_[8] = zx - yw;
+  r_[9] = yz + xw;
+  r_[10] = 1.0f - x2 - y2;
+  r_[11] = translation.z_;
+}
+
+AffineTransform AffineTransform::operator*(const AffineTransform &rhs) const {
+  AffineTransform ret;
+  //Row i of the result is sum_k lhs[i][k] * rhs.row(k), the implicit 4th row
+  //of rhs only contributes lhs translation
+  const simd::float4 b0 = simd::Load(rhs.r_);
+  const simd::float4 b1 = simd::Load(rhs.r_ + 4);
+  const simd::float4 b2 = simd::Load(rhs.r_ + 8);
+  const simd::float4 b3 = simd::Set(0.f, 0.f, 0.f, 1.f);
+  for (int32_t i = 0; i < 12; i += 4) {
+    simd::float4 r = simd::Mul(b0, simd::Splat(r_[i]));
+    r = simd::MulAdd(r, b1, simd::Splat(r_[i + 1]));
+    r = simd::MulAdd(r, b2, simd::Splat(r_[i + 2]));
+    r = simd::MulAdd(r, b3, simd::Splat(r_[i + 3]));
+    simd::Store(ret.r_ + i, r);
+  }
+  return ret;
+}
+
+AffineTransform AffineTransform::Inverse() {
+  const float c00 = r_[5] * r_[10] - r_[6] * r_[9];
+  const float c01 = r_[6] * r_[8] - r_[4] * r_[10];
+  const float c02 = r_[4] * r_[9] - r_[5] * r_[8];
+  float det = r_[0] * c00 + r_[1] * c01 + r_[2] * c02;
+  if (det == 0.0f) {
+    //Error, same as Mat4::Inverse() leave the transform as is
+    return *this;
+  }
+
+  AffineTransform ret;
+  const float det_1 = 1.0f / det;
+  ret.r_[0] = c00 * det_1;
+  ret.r_[1] = (r_[2] * r_[9] - r_[1] * r_[10]) * det_1;
+  ret.r_[2] = (r_[1] * r_[6] - r_[2] * r_[5]) * det_1;
+  ret.r_[4] = c01 * det_1;
+  ret.r_[5] = (r_[0] * r_[10] - r_[2] * r_[8]) * det_1;
+  ret.r_[6] = (r_[2] * r_[4] - r_[0] * r_[6]) * det_1;
+  ret.r_[8] = c02 * det_1;
+  ret.r_[9] = (r_[1] * r_[8] - r_[0] * r_[9]) * det_1;
+  ret.r_[10] = (r_[0] * r_[5] - r_[1] * r_[4]) * det_1;
+
+  //-inverse(A) * t
+  ret.r_[3] = -(ret.r_[0] * r_[3] + ret.r_[1] * r_[7] + ret.r_[2] * r_[11]);
+  ret.r_[7] = -(ret.r_[4] * r_[3] + ret.r_[5] * r_[7] + ret.r_[6] * r_[11]);
+  ret.r_[11] = -(ret.r_[8] * r_[3] + ret.r_[9] * r_[7] + ret.r_[10] * r_[11]);
+
+  *this = ret;
+  return *this;
+}
+
+AffineTransform AffineTransform::InverseOrthonormal() {
+  simd::float4 r0 = simd::Load(r_);
+  simd::float4 r1 = simd::Load(r_ + 4);
+  simd::float4 r2 = simd::Load(r_ + 8);
+
+  //-transpose(R) * t in lanes x, y, z
+  simd::float4 t = simd::Mul(r0, simd::SplatLane<3>(r0));
+  t = simd::MulAdd(t, r1, simd::SplatLane<3>(r1));
+  t = simd::MulAdd(t, r2, simd::SplatLane<3>(r2));
+  simd::float4 r3 = simd::Sub(simd::Splat(0.f), t);
+
+  //Rows of the inverse are the columns of R, transposing r3 along moves the
+  //new translation into the last column
+  simd::Transpose(r0, r1, r2, r3);
+  simd::Store(r_, r0);
+  simd::Store(r_ + 4, r1);
+  simd::Store(r_ + 8, r2);
+  return *this;
+}
+
+Mat4 AffineTransform::ToMat4() const {
+  return Mat4(r_[0], r_[4], r_[8], 0.f, r_[1], r_[5], r_[9], 0.f, r_[2], r_[6],
+              r_[10], 0.f, r_[3], r_[7], r_[11], 1.f);
+}
+
+Quaternion AffineTransform::ToQuaternion() const {
+  const float trace = r_[0] + r_[5] + r_[10];
+  if (trace > 0.f) {
+    const float s = 0.5f / sqrtf(trace + 1.0f);
+    return Quaternion((r_[9] - r_[6]) * s, (r_[2] - r_[8]) * s,
+                      (r_[4] - r_[1]) * s, 0.25f / s);
+  } else if (r_[0] > r_[5] && r_[0] > r_[10]) {
+    const float s = 2.0f * sqrtf(1.0f + r_[0] - r_[5] - r_[10]);
+    return Quaternion(0.25f * s, (r_[1] + r_[4]) / s, (r_[2] + r_[8]) / s,
+                      (r_[9] - r_[6]) / s);
+  } else if (r_[5] > r_[10]) {
+    const float s = 2.0f * sqrtf(1.0f + r_[5] - r_[0] - r_[10]);
+    return Quaternion((r_[1] + r_[4]) / s, 0.25f * s, (r_[6] + r_[9]) / s,
+                      (r_[2] - r_[8]) / s);
+  } else {
+    const float s = 2.0f * sqrtf(1.0f + r_[10] - r_[0] - r_[5]);
+    return Quaternion((r_[2] + r_[8]) / s, (r_[6] + r_[9]) / s, 0.25f * s,
+                      (r_[4] - r_[1]) / s);
+  }
+}
+
+//--------------------------------------------------------------------------------
+// Quaternion
+//--------------------------------------------------------------------------------
+namespace {
+
+//Above this cosine (angle below ~1.8 degrees) slerp and nlerp only differ by
+//rounding, and slerp would divide by a vanishing sin(theta)
+const float SLERP_NLERP_THRESHOLD = 0.9995f;
+
+//acos(x) for x in [0, 1], Abramowitz & Stegun 4.4.46, |error| <= 2e-8
+simd::float4 AcosUnit(const simd::float4 x) {
+  simd::float4 p = simd::Splat(-0.0012624911f);
+  p = simd::MulAdd(simd::Splat(0.0066700901f), p, x);
+  p = simd::MulAdd(simd::Splat(-0.0170881256f), p, x);
+  p = simd::MulAdd(simd::Splat(0.0308918810f), p, x);
+  p = simd::MulAdd(simd::Splat(-0.0501743046f), p, x);
+  p = simd::MulAdd(simd::Splat(0.0889789874f), p, x);
+  p = simd::MulAdd(simd::Splat(-0.2145988016f), p, x);
+  p = simd::MulAdd(simd::Splat(1.5707963050f), p, x);
+  return simd::Mul(simd::Sqrt(simd::Sub(simd::Splat(1.f), x)), p);
+}
+
+//sin(x) for x in [0, pi/2], Taylor series up to x^11, |error| < 6e-8
+simd::float4 SinQuadrant(const simd::float4 x) {
+  simd::float4 x2 = simd::Mul(x, x);
+  simd::float4 p = simd::Splat(-1.f / 39916800.f);
+  p = simd::MulAdd(simd::Splat(1.f / 362880.f), p, x2);
+  p = simd::MulAdd(simd::Splat(-1.f / 5040.f), p, x2);
+  p = simd::MulAdd(simd::Splat(1.f / 120.f), p, x2);
+  p = simd::MulAdd(simd::Splat(-1.f / 6.f), p, x2);
+  p = simd::MulAdd(simd::Splat(1.f), p, x2);
+  return simd::Mul(x, p);
+}
+
+/*
+ * Interpolates count quaternion pairs, 4 per step (transposed to x, y, z, w
+ * lanes). t points to a single value, or to count values when t_per_pair.
+ * The scalar float4 backend runs the same code, so batch results do not
+ * depend on the SIMD backend beyond rounding of sqrt/divide on ARMv7.
+ */
+template <bool SLERP>
+void InterpolateQuaternions(const float *from, const float *to,
+                            const float *t, const bool t_per_pair, float *out,
+                            const int32_t count) {
+  const simd::float4 zero = simd::Splat(0.f);
+  const simd::float4 one = simd::Splat(1.f);
+  for (int32_t i = 0; i < count; i += 4) {
+    const float *a = from + i * 4;
+    const float *b = to + i * 4;
+    const float *pt = t_per_pair ? t + i : t;
+    float *r = out + i * 4;
+
+    //The last partial block goes through copies padded with identities
+    const int32_t n = count - i < 4 ? count - i : 4;
+    float from_block[16], to_block[16], t_block[4], out_block[16];
+    if (n < 4) {
+      for (int32_t j = 0; j < 16; ++j) {
+        from_block[j] = j < n * 4 ? a[j] : ((j & 3) == 3 ? 1.f : 0.f);
+        to_block[j] = j < n * 4 ? b[j] : ((j & 3) == 3 ? 1.f : 0.f);
+      }
+      if (t_per_pair) {
+        for (int32_t j = 0; j < 4; ++j)
+          t_block[j] = j < n ? pt[j] : 0.f;
+        pt = t_block;
+      }
+      a = from_block;
+      b = to_block;
+      r = out_block;
+    }
+
+    simd::float4 ax = simd::Load(a);
+    simd::float4 ay = simd::Load(a + 4);
+    simd::float4 az = simd::Load(a + 8);
+    simd::float4 aw = simd::Load(a + 12);
+    simd::Transpose(ax, ay, az, aw);
+    simd::float4 bx = simd::Load(b);
+    simd::float4 by = simd::Load(b + 4);
+    simd::float4 bz = simd::Load(b + 8);
+    simd::float4 bw = simd::Load(b + 12);
+    simd::Transpose(bx, by, bz, bw);
+    simd::float4 s1 = t_per_pair ? simd::Load(pt) : simd::Splat(*pt);
+    simd::float4 s0 = simd::Sub(one, s1);
+
+    //Shortest path: flip to where dot(from, to) >= 0
+    simd::float4 dot = simd::Mul(ax, bx);
+    dot = simd::MulAdd(dot, ay, by);
+    dot = simd::MulAdd(dot, az, bz);
+    dot = simd::MulAdd(dot, aw, bw);
+    simd::float4 flip = simd::CmpLt(dot, zero);
+    bx = simd::Select(flip, simd::Sub(zero, bx), bx);
+    by = simd::Select(flip, simd::Sub(zero, by), by);
+    bz = simd::Select(flip, simd::Sub(zero, bz), bz);
+    bw = simd::Select(flip, simd::Sub(zero, bw), bw);
+    dot = simd::Abs(dot);
+
+    if (SLERP) {
+      //Lanes with nearly equal quaternions keep the nlerp weights, the
+      //trigonometry is skipped when all of them do
+      simd::float4 nearly_equal =
+          simd::CmpLt(simd::Splat(SLERP_NLERP_THRESHOLD), dot);
+      if (simd::SignMask(nearly_equal) != 0xf) {
+        simd::float4 theta = AcosUnit(simd::Min(dot, one));
+        simd::float4 inv_sin = simd::Div(one, SinQuadrant(theta));
+        s0 = simd::Select(
+            nearly_equal, s0,
+            simd::Mul(SinQuadrant(simd::Mul(s0, theta)), inv_sin));
+        s1 = simd::Select(
+            nearly_equal, s1,
+            simd::Mul(SinQuadrant(simd::Mul(s1, theta)), inv_sin));
+      }
+    }
+
+    simd::float4 rx = simd::MulAdd(simd::Mul(ax, s0), bx, s1);
+    simd::float4 ry = simd::MulAdd(simd::Mul(ay, s0), by, s1);
+    simd::float4 rz = simd::MulAdd(simd::Mul(az, s0), bz, s1);
+    simd::float4 rw = simd::MulAdd(simd::Mul(aw, s0), bw, s1);
+
+    simd::float4 len2 = simd::Mul(rx, rx);
+    len2 = simd::MulAdd(len2, ry, ry);
+    len2 = simd::MulAdd(len2, rz, rz);
+    len2 = simd::MulAdd(len2, rw, rw);
+    simd::float4 inv_len = simd::Div(one, simd::Sqrt(len2));
+    rx = simd::Mul(rx, inv_len);
+    ry = simd::Mul(ry, inv_len);
+    rz = simd::Mul(rz, inv_len);
+    rw = simd::Mul(rw, inv_len);
+
+    simd::Transpose(rx, ry, rz, rw);
+    simd::Store(r, rx);
+    simd::Store(r + 4, ry);
+    simd::Store(r + 8, rz);
+    simd::Store(r + 12, rw);
+    if (n < 4) {
+      for (int32_t j = 0; j < n * 4; ++j)
+        out[i * 4 + j] = out_block[j];
+    }
+  }
+}
+
+} //namespace
+
+static_assert(sizeof(Quaternion) == sizeof(float) * 4,
+              "Quaternion must be 4 packed floats for the batch kernels");
+
+Quaternion Quaternion::Nlerp(const Quaternion &from, const Quaternion &to,
+                             const float t) {
+  float s0 = 1.f - t;
+  float s1 = from.Dot(to) < 0.f ? -t : t;
+  Quaternion ret(from.x_ * s0 + to.x_ * s1, from.y_ * s0 + to.y_ * s1,
+                 from.z_ * s0 + to.z_ * s1, from.w_ * s0 + to.w_ * s1);
+  return ret.Normalize();
+}
+
+Quaternion Quaternion::Slerp(const Quaternion &from, const Quaternion &to,
+                             const float t) {
+  float cos_theta = from.Dot(to);
+  if (fabsf(cos_theta) > SLERP_NLERP_THRESHOLD)
+    return Nlerp(from, to, t);
+
+  float sign = cos_theta < 0.f ? -1.f : 1.f;
+  float theta = acosf(cos_theta * sign);
+  float inv_sin = 1.f / sinf(theta);
+  float s0 = sinf((1.f - t) * theta) * inv_sin;
+  float s1 = sinf(t * theta) * inv_sin * sign;
+  return Quaternion(from.x_ * s0 + to.x_ * s1, from.y_ * s0 + to.y_ * s1,
+                    from.z_ * s0 + to.z_ * s1, from.w_ * s0 + to.w_ * s1);
+}
+
+void Quaternion::Nlerp(const Quaternion *from, const Quaternion *to,
+                       const float t, Quaternion *out, const int32_t count) {
+  InterpolateQuaternions<false>(&from->x_, &to->x_, &t, false, &out->x_,
+                                count);
+}
+
+void Quaternion::Nlerp(const Quaternion *from, const Quaternion *to,
+                       const float *t, Quaternion *out, const int32_t count) {
+  InterpolateQuaternions<false>(&from->x_, &to->x_, t, true, &out->x_, count);
+}
+
+void Quaternion::Slerp(const Quaternion *from, const Quaternion *to,
+                       const float t, Quaternion *out, const int32_t count) {
+  InterpolateQuaternions<true>(&from->x_, &to->x_, &t, false, &out->x_,
+                               count);
+}
+
+void Quaternion::Slerp(const Quaternion *from, const Quaternion *to,
+                       const float *t, Quaternion *out, const int32_t count) {
+  InterpolateQuaternions<true>(&from->x_, &to->x_, t, true, &out->x_, count);
+}
+
+//--------------------------------------------------------------------------------
+// DualQuaternion
+//--------------------------------------------------------------------------------
+DualQuaternion::DualQuaternion(const Quaternion &rotation,
+                               const Vec3 &translation)
+    : real_(rotation) {
+  //0.5 * (translation, 0) * rotation
+  const Quaternion &q = rotation;
+  const Vec3 &v = translation;
+  dual_.x_ = 0.5f * (v.x_ * q.w_ + v.y_ * q.z_ - v.z_ * q.y_);
+  dual_.y_ = 0.5f * (-v.x_ * q.z_ + v.y_ * q.w_ + v.z_ * q.x_);
+  dual_.z_ = 0.5f * (v.x_ * q.y_ - v.y_ * q.x_ + v.z_ * q.w_);
+  dual_.w_ = 0.5f * (-v.x_ * q.x_ - v.y_ * q.y_ - v.z_ * q.z_);
+}
+
+DualQuaternion DualQuaternion::operator*(const DualQuaternion &rhs) const {
+  Quaternion real = real_ * rhs.real_;
+  Quaternion dual_a = real_ * rhs.dual_;
+  Quaternion dual_b = dual_ * rhs.real_;
+  return DualQuaternion(real, Quaternion(dual_a.x_ + dual_b.x_,
+                                         dual_a.y_ + dual_b.y_,
+                                         dual_a.z_ + dual_b.z_,
+                                         dual_a.w_ + dual_b.w_));
+}
+
+Vec3 DualQuaternion::TransformDirection(const Vec3 &rhs) const {
+  //v + w * t + q x t, with t = 2 * (q x v)
+  Vec3 q(real_.x_, real_.y_, real_.z_);
+  Vec3 t = q.Cross(rhs) * 2.f;
+  return rhs + t * real_.w_ + q.Cross(t);
+}
+
+Vec3 DualQuaternion::operator*(const Vec3 &rhs) const {
+  return TransformDirection(rhs) + GetTranslation();
+}
+
+Vec3 DualQuaternion::GetTranslation() const {
+  //Vector part of 2 * dual * conjugate(real)
+  Quaternion t = dual_ * real_.Conjugated();
+  return Vec3(2.f * t.x_, 2.f * t.y_, 2.f * t.z_);
+}
+
+DualQuaternion DualQuaternion::Normalize() {
+  float inv_len = 1.f / sqrtf(real_.Dot(real_));
+  real_ = Quaternion(real_.x_ * inv_len, real_.y_ * inv_len,
+                     real_.z_ * inv_len, real_.w_ * inv_len);
+  dual_ = Quaternion(dual_.x_ * inv_len, dual_.y_ * inv_len,
+                     dual_.z_ * inv_len, dual_.w_ * inv_len);
+  //Remove the part of dual along real so that dot(real, dual) == 0 holds
+  float d = real_.Dot(dual_);
+  dual_ = Quaternion(dual_.x_ - real_.x_ * d, dual_.y_ - real_.y_ * d,
+                     dual_.z_ - real_.z_ * d, dual_.w_ - real_.w_ * d);
+  return *this;
+}
+
+DualQuaternion DualQuaternion::Inverse() {
+  real_ = real_.Conjugated();
+  dual_ = dual_.Conjugated();
+  return *this;
+}
+
+DualQuaternion DualQuaternion::Blend(const DualQuaternion *dqs,
+                                     const float *weights,
+                                     const int32_t count) {
+  float real[4] = { 0.f, 0.f, 0.f, 0.f };
+  float dual[4] = { 0.f, 0.f, 0.f, 0.f };
+  for (int32_t i = 0; i < count; ++i) {
+    const DualQuaternion &dq = dqs[i];
+    float w = dq.real_.Dot(dqs[0].real_) < 0.f ? -weights[i] : weights[i];
+    real[0] += dq.real_.x_ * w;
+    real[1] += dq.real_.y_ * w;
+    real[2] += dq.real_.z_ * w;
+    real[3] += dq.real_.w_ * w;
+    dual[0] += dq.dual_.x_ * w;
+    dual[1] += dq.dual_.y_ * w;
+    dual[2] += dq.dual_.z_ * w;
+    dual[3] += dq.dual_.w_ * w;
+  }
+  DualQuaternion ret((Quaternion(real)), Quaternion(dual));
+  return ret.Normalize();
+}
+
+DualQuaternion DualQuaternion::Blend(const DualQuaternion &from,
+                                     const DualQuaternion &to, const float t) {
+  const DualQuaternion dqs[2] = { from, to };
+  const float weights[2] = { 1.f - t, t };
+  return Blend(dqs, weights, 2);
+}
+
+AffineTransform DualQuaternion::ToAffineTransform() const {
+  return AffineTransform(real_, GetTranslation());
+}
+
+Mat4 DualQuaternion::ToMat4() const { return ToAffineTransform().ToMat4(); }
+
+//--------------------------------------------------------------------------------
+// Scalar reference kernels
+//--------------------------------------------------------------------------------
+namespace reference {
+
+void MultiplyMat4(const float *lhs, const float *rhs, float *out) {
+  out[0] = lhs[0] * rhs[0] + lhs[4] * rhs[1] + lhs[8] * rhs[2] +
+      lhs[12] * rhs[3];
+  out[1] = lhs[1] * rhs[0] + lhs[5] * rhs[1] + lhs[9] * rhs[2] +
+      lhs[13] * rhs[3];
+  out[2] = lhs[2] * rhs[0] + lhs[6] * rhs[1] + lhs[10] * rhs[2] +
+      lhs[14] * rhs[3];
+  out[3] = lhs[3] * rhs[0] + lhs[7] * rhs[1] + lhs[11] * rhs[2] +
+      lhs[15] * rhs[3];
+
+  out[4] = lhs[0] * rhs[4] + lhs[4] * rhs[5] + lhs[8] * rhs[6] +
+      lhs[12] * rhs[7];
+  out[5] = lhs[1] * rhs[4] + lhs[5] * rhs[5] + lhs[9] * rhs[6] +
+      lhs[13] * rhs[7];
+  out[6] = lhs[2] * rhs[4] + lhs[6] * rhs[5] + lhs[10] * rhs[6] +
+      lhs[14] * rhs[7];
+  out[7] = lhs[3] * rhs[4] + lhs[7] * rhs[5] + lhs[11] * rhs[6] +
+      lhs[15] * rhs[7];
+
+  out[8] = lhs[0] * rhs[8] + lhs[4] * rhs[9] + lhs[8] * rhs[10] +
+      lhs[12] * rhs[11];
+  out[9] = lhs[1] * rhs[8] + lhs[5] * rhs[9] + lhs[9] * rhs[10] +
+      lhs[13] * rhs[11];
+  out[10] = lhs[2] * rhs[8] + lhs[6] * rhs[9] + lhs[10] * rhs[10] +
+      lhs[14] * rhs[11];
+  out[11] = lhs[3] * rhs[8] + lhs[7] * rhs[9] + lhs[11] * rhs[10] +
+      lhs[15] * rhs[11];
+
+  out[12] = lhs[0] * rhs[12] + lhs[4] * rhs[13] + lhs[8] * rhs[14] +
+      lhs[12] * rhs[15];
+  out[13] = lhs[1] * rhs[12] + lhs[5] * rhs[13] + lhs[9] * rhs[14] +
+      lhs[13] * rhs[15];
+  out[14] = lhs[2] * rhs[12] + lhs[6] * rhs[13] + lhs[10] * rhs[14] +
+      lhs[14] * rhs[15];
+  out[15] = lhs[3] * rhs[12] + lhs[7] * rhs[13] + lhs[11] * rhs[14] +
+      lhs[15] * rhs[15];
+}
+
+void MultiplyMat4Vec4(const float *mat, const float *vec, float *out) {
+  out[0] = vec[0] * mat[0] + vec[1] * mat[4] + vec[2] * mat[8] + vec[3] * mat[12];
+  out[1] = vec[0] * mat[1] + vec[1] * mat[5] + vec[2] * mat[9] + vec[3] * mat[13];
+  out[2] =
+      vec[0] * mat[2] + vec[1] * mat[6] + vec[2] * mat[10] + vec[3] * mat[14];
+  out[3] =
+      vec[0] * mat[3] + vec[1] * mat[7] + vec[2] * mat[11] + vec[3] * mat[15];
+}
+
+void MultiplyVec4Mat4(const float *vec, const float *mat, float *out) {
+  out[0] = vec[0] * mat[0] + vec[1] * mat[1] + vec[2] * mat[2] + vec[3] * mat[3];
+  out[1] = vec[0] * mat[4] + vec[1] * mat[5] + vec[2] * mat[6] + vec[3] * mat[7];
+  out[2] =
+      vec[0] * mat[8] + vec[1] * mat[9] + vec[2] * mat[10] + vec[3] * mat[11];
+  out[3] =
+      vec[0] * mat[12] + vec[1] * mat[13] + vec[2] * mat[14] + vec[3] * mat[15];
+}
+
+} //namespace reference
+
 } //namespace ndkHelper
@@ -18,16 +18,31 @@
 #define VECMATH_H_
 
 #include <math.h>
+#include <stdint.h>
+
+#if defined(__ANDROID__)
 #include "JNIHelper.h"
+#else
+//Host side tools and benchmarks build vecmath without JNIHelper
+#include <stdio.h>
+#ifndef LOGI
+#define LOGI(...) (printf(__VA_ARGS__), printf("\n"))
+#endif
+#ifndef LOGW
+#define LOGW(...) (printf(__VA_ARGS__), printf("\n"))
+#endif
+#endif
 
 namespace ndk_helper {
 
 /******************************************************************
  * Helper class for vector math operations
- * Currently all implementations are in pure C++.
  * Each class is an opaque class so caller does not have a direct access
  * to each element. This is for an ease of future optimization to use vector
  * operations.
+ * Mat4 x Mat4, Mat4 x Vec4 and Vec4 x Mat4 products use NEON or SSE when the
+ * target supports them (see vecmath_simd.h), defining NDK_HELPER_DISABLE_SIMD
+ * falls back to the scalar reference code.
  *
  */
 
@@ -35,6 +50,8 @@ class Vec2;
 class Vec3;
 class Vec4;
 class Mat4;
+class Quaternion;
+class AffineTransform;
 
 /******************************************************************
  * 2 elements vector class
@@ -51,17 +68,11 @@ public:
   friend class Mat4;
   friend class Quaternion;
 
-  Vec2() { x_ = y_ = 0.f; }
+  constexpr Vec2() : x_(0.f), y_(0.f) {}
 
-  Vec2(const float fX, const float fY) {
-    x_ = fX;
-    y_ = fY;
-  }
+  constexpr Vec2(const float fX, const float fY) : x_(fX), y_(fY) {}
 
-  Vec2(const Vec2 &vec) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-  }
+  constexpr Vec2(const Vec2 &vec) : x_(vec.x_), y_(vec.y_) {}
 
   Vec2(const float *pVec) {
     x_ = (*pVec++);
@@ -216,20 +227,18 @@ public:
   friend class Vec4;
   friend class Mat4;
   friend class Quaternion;
+  friend class AffineTransform;
+  friend class DualQuaternion;
+  friend class BoundingBox;
+  friend class BoundingSphere;
+  friend class Frustum;
 
-  Vec3() { x_ = y_ = z_ = 0.f; }
+  constexpr Vec3() : x_(0.f), y_(0.f), z_(0.f) {}
 
-  Vec3(const float fX, const float fY, const float fZ) {
-    x_ = fX;
-    y_ = fY;
-    z_ = fZ;
-  }
+  constexpr Vec3(const float fX, const float fY, const float fZ)
+      : x_(fX), y_(fY), z_(fZ) {}
 
-  Vec3(const Vec3 &vec) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-    z_ = vec.z_;
-  }
+  constexpr Vec3(const Vec3 &vec) : x_(vec.x_), y_(vec.y_), z_(vec.z_) {}
 
   Vec3(const float *pVec) {
     x_ = (*pVec++);
@@ -237,13 +246,9 @@ public:
     z_ = *pVec;
   }
 
-  Vec3(const Vec2 &vec, float f) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-    z_ = f;
-  }
+  constexpr Vec3(const Vec2 &vec, float f) : x_(vec.x_), y_(vec.y_), z_(f) {}
 
-  Vec3(const Vec4 &vec);
+  constexpr Vec3(const Vec4 &vec);
 
   //Operators
   Vec3 operator*(const Vec3 &rhs) const {
@@ -380,14 +385,13 @@ public:
     return *this;
   }
 
-  float Dot(const Vec3 &rhs) { return x_ * rhs.x_ + y_ * rhs.y_ + z_ * rhs.z_; }
+  constexpr float Dot(const Vec3 &rhs) const {
+    return x_ * rhs.x_ + y_ * rhs.y_ + z_ * rhs.z_;
+  }
 
-  Vec3 Cross(const Vec3 &rhs) {
-    Vec3 ret;
-    ret.x_ = y_ * rhs.z_ - z_ * rhs.y_;
-    ret.y_ = z_ * rhs.x_ - x_ * rhs.z_;
-    ret.z_ = x_ * rhs.y_ - y_ * rhs.x_;
-    return ret;
+  constexpr Vec3 Cross(const Vec3 &rhs) const {
+    return Vec3(y_ * rhs.z_ - z_ * rhs.y_, z_ * rhs.x_ - x_ * rhs.z_,
+                x_ * rhs.y_ - y_ * rhs.x_);
   }
 
   bool Validate() {
@@ -418,28 +422,17 @@ public:
   friend class Mat4;
   friend class Quaternion;
 
-  Vec4() { x_ = y_ = z_ = w_ = 0.f; }
+  constexpr Vec4() : x_(0.f), y_(0.f), z_(0.f), w_(0.f) {}
 
-  Vec4(const float fX, const float fY, const float fZ, const float fW) {
-    x_ = fX;
-    y_ = fY;
-    z_ = fZ;
-    w_ = fW;
-  }
+  constexpr Vec4(const float fX, const float fY, const float fZ,
+                 const float fW)
+      : x_(fX), y_(fY), z_(fZ), w_(fW) {}
 
-  Vec4(const Vec4 &vec) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-    z_ = vec.z_;
-    w_ = vec.w_;
-  }
+  constexpr Vec4(const Vec4 &vec)
+      : x_(vec.x_), y_(vec.y_), z_(vec.z_), w_(vec.w_) {}
 
-  Vec4(const Vec3 &vec, const float fW) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-    z_ = vec.z_;
-    w_ = fW;
-  }
+  constexpr Vec4(const Vec3 &vec, const float fW)
+      : x_(vec.x_), y_(vec.y_), z_(vec.z_), w_(fW) {}
 
   Vec4(const float *pVec) {
     x_ = (*pVec++);
@@ -624,27 +617,95 @@ public:
   }
 };
 
+constexpr Vec3::Vec3(const Vec4 &vec) : x_(vec.x_), y_(vec.y_), z_(vec.z_) {}
+
+//Tag for a Mat4 whose elements are left uninitialized, for results that are
+//written in full right after construction
+enum MAT4_UNINITIALIZED_TAG {
+  MAT4_UNINITIALIZED
+};
+
 /******************************************************************
  * 4x4 matrix
+ * Elements are stored in column major order, as OpenGL expects them.
  *
+ * Constructors and the non trigonometric factories (Identity, Translation,
+ * Scale, Perspective, Ortho2D, Product) are constexpr, so constant transforms
+ * can be folded at compile time:
+ *   constexpr Mat4 kView = Mat4::Translation(0.f, 0.f, -700.f);
+ *
+ * Chains of products can be evaluated without temporaries with Multiply():
+ *   Mat4::Multiply(mat_mv, mat_view, mat_rotation, mat_model);
  */
 class Mat4 {
 private:
   float f_[16];
 
+  static constexpr float ProductTerm(const Mat4 &lhs, const Mat4 &rhs,
+                                     const int32_t row, const int32_t col) {
+    return lhs.f_[row] * rhs.f_[col * 4] +
+           lhs.f_[row + 4] * rhs.f_[col * 4 + 1] +
+           lhs.f_[row + 8] * rhs.f_[col * 4 + 2] +
+           lhs.f_[row + 12] * rhs.f_[col * 4 + 3];
+  }
+
+  static constexpr Mat4 PerspectiveFromTerms(float width, float height,
+                                             float n2, float rcpnmf,
+                                             float nearPlane, float farPlane) {
+    return Mat4(n2 / width, 0, 0, 0, 0, n2 / height, 0, 0, 0, 0,
+                (farPlane + nearPlane) * rcpnmf, -1.0, 0, 0,
+                farPlane * rcpnmf * n2, 0);
+  }
+
+  static constexpr Mat4 Ortho2DFromTerms(float left, float top, float right,
+                                         float bottom, float inv_z,
+                                         float inv_y, float inv_x) {
+    return Mat4(2.0f * inv_x, 0.0f, 0.0f, 0.0f, 0.0f, 2.0 * inv_y, 0.0f, 0.0f,
+                0.0f, 0.0f, -2.0f * inv_z, 0.0f, -(right + left) * inv_x,
+                (top + bottom) * inv_y, -(1.0f + -1.0f) * inv_z, 1.0f);
+  }
+
 public:
   friend class Vec3;
   friend class Vec4;
   friend class Quaternion;
+  friend class AffineTransform;
+  friend class BoundingBox;
+  friend class Frustum;
 
-  Mat4();
+  constexpr Mat4()
+      : f_{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f,
+            0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f } {}
   Mat4(const float *);
 
+  explicit Mat4(MAT4_UNINITIALIZED_TAG) {}
+
+  //Elements in column major order
+  constexpr Mat4(const float f0, const float f1, const float f2,
+                 const float f3, const float f4, const float f5,
+                 const float f6, const float f7, const float f8,
+                 const float f9, const float f10, const float f11,
+                 const float f12, const float f13, const float f14,
+                 const float f15)
+      : f_{ f0, f1, f2, f3, f4, f5, f6, f7,
+            f8, f9, f10, f11, f12, f13, f14, f15 } {}
+
   Mat4 operator*(const Mat4 &rhs) const;
   Vec4 operator*(const Vec4 &rhs) const;
 
+  /*
+   * Fused products, out = a * b [* c [* d]]
+   * Evaluated left to right like the operator* chain, with the same rounding,
+   * but intermediate products never leave registers. out may be one of the
+   * operands.
+   */
+  static void Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b);
+  static void Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b, const Mat4 &c);
+  static void Multiply(Mat4 &out, const Mat4 &a, const Mat4 &b, const Mat4 &c,
+                       const Mat4 &d);
+
   Mat4 operator+(const Mat4 &rhs) const {
-    Mat4 ret;
+    Mat4 ret(MAT4_UNINITIALIZED);
     for (int32_t i = 0; i < 16; ++i) {
       ret.f_[i] = f_[i] + rhs.f_[i];
     }
@@ -652,7 +713,7 @@ public:
   }
 
   Mat4 operator-(const Mat4 &rhs) const {
-    Mat4 ret;
+    Mat4 ret(MAT4_UNINITIALIZED);
     for (int32_t i = 0; i < 16; ++i) {
       ret.f_[i] = f_[i] - rhs.f_[i];
     }
@@ -674,49 +735,12 @@ public:
   }
 
   Mat4 &operator*=(const Mat4 &rhs) {
-    Mat4 ret;
-    ret.f_[0] = f_[0] * rhs.f_[0] + f_[4] * rhs.f_[1] + f_[8] * rhs.f_[2] +
-                f_[12] * rhs.f_[3];
-    ret.f_[1] = f_[1] * rhs.f_[0] + f_[5] * rhs.f_[1] + f_[9] * rhs.f_[2] +
-                f_[13] * rhs.f_[3];
-    ret.f_[2] = f_[2] * rhs.f_[0] + f_[6] * rhs.f_[1] + f_[10] * rhs.f_[2] +
-                f_[14] * rhs.f_[3];
-    ret.f_[3] = f_[3] * rhs.f_[0] + f_[7] * rhs.f_[1] + f_[11] * rhs.f_[2] +
-                f_[15] * rhs.f_[3];
-
-    ret.f_[4] = f_[0] * rhs.f_[4] + f_[4] * rhs.f_[5] + f_[8] * rhs.f_[6] +
-                f_[12] * rhs.f_[7];
-    ret.f_[5] = f_[1] * rhs.f_[4] + f_[5] * rhs.f_[5] + f_[9] * rhs.f_[6] +
-                f_[13] * rhs.f_[7];
-    ret.f_[6] = f_[2] * rhs.f_[4] + f_[6] * rhs.f_[5] + f_[10] * rhs.f_[6] +
-                f_[14] * rhs.f_[7];
-    ret.f_[7] = f_[3] * rhs.f_[4] + f_[7] * rhs.f_[5] + f_[11] * rhs.f_[6] +
-                f_[15] * rhs.f_[7];
-
-    ret.f_[8] = f_[0] * rhs.f_[8] + f_[4] * rhs.f_[9] + f_[8] * rhs.f_[10] +
-                f_[12] * rhs.f_[11];
-    ret.f_[9] = f_[1] * rhs.f_[8] + f_[5] * rhs.f_[9] + f_[9] * rhs.f_[10] +
-                f_[13] * rhs.f_[11];
-    ret.f_[10] = f_[2] * rhs.f_[8] + f_[6] * rhs.f_[9] + f_[10] * rhs.f_[10] +
-                 f_[14] * rhs.f_[11];
-    ret.f_[11] = f_[3] * rhs.f_[8] + f_[7] * rhs.f_[9] + f_[11] * rhs.f_[10] +
-                 f_[15] * rhs.f_[11];
-
-    ret.f_[12] = f_[0] * rhs.f_[12] + f_[4] * rhs.f_[13] + f_[8] * rhs.f_[14] +
-                 f_[12] * rhs.f_[15];
-    ret.f_[13] = f_[1] * rhs.f_[12] + f_[5] * rhs.f_[13] + f_[9] * rhs.f_[14] +
-                 f_[13] * rhs.f_[15];
-    ret.f_[14] = f_[2] * rhs.f_[12] + f_[6] * rhs.f_[13] + f_[10] * rhs.f_[14] +
-                 f_[14] * rhs.f_[15];
-    ret.f_[15] = f_[3] * rhs.f_[12] + f_[7] * rhs.f_[13] + f_[11] * rhs.f_[14] +
-                 f_[15] * rhs.f_[15];
-
-    *this = ret;
+    *this = *this * rhs;
     return *this;
   }
 
   Mat4 operator*(const float rhs) {
-    Mat4 ret;
+    Mat4 ret(MAT4_UNINITIALIZED);
     for (int32_t i = 0; i < 16; ++i) {
       ret.f_[i] = f_[i] * rhs;
     }
@@ -740,7 +764,7 @@ public:
   Mat4 Inverse();
 
   Mat4 Transpose() {
-    Mat4 ret;
+    Mat4 ret(MAT4_UNINITIALIZED);
     ret.f_[0] = f_[0];
     ret.f_[1] = f_[4];
     ret.f_[2] = f_[8];
@@ -770,18 +794,60 @@ public:
   }
 
   float *Ptr() { return f_; }
+  const float *Ptr() const { return f_; }
+
+  //--------------------------------------------------------------------------------
+  // Batch transforms
+  // Transform count elements from in to out, in and out may be the same array.
+  // TransformPoints() treats Vec3 inputs as (x, y, z, 1), TransformDirections()
+  // as (x, y, z, 0), and TransformAndProject() divides the result by w.
+  // Structure of arrays variants take separate x/y/z streams and process 4
+  // elements per iteration. Results match Mat4 * Vec4 bit for bit, except
+  // that on ARMv7 NEON the division is a refined reciprocal estimate, which
+  // may change the last bit of the projection.
+  //--------------------------------------------------------------------------------
+  void TransformPoints(const Vec3 *in, Vec3 *out, const int32_t count) const;
+  void TransformPoints(const Vec4 *in, Vec4 *out, const int32_t count) const;
+  void TransformDirections(const Vec3 *in, Vec3 *out,
+                           const int32_t count) const;
+  void TransformAndProject(const Vec3 *in, Vec3 *out,
+                           const int32_t count) const;
+
+  void TransformPoints(const float *in_x, const float *in_y, const float *in_z,
+                       float *out_x, float *out_y, float *out_z,
+                       const int32_t count) const;
+  void TransformDirections(const float *in_x, const float *in_y,
+                           const float *in_z, float *out_x, float *out_y,
+                           float *out_z, const int32_t count) const;
+  void TransformAndProject(const float *in_x, const float *in_y,
+                           const float *in_z, float *out_x, float *out_y,
+                           float *out_z, const int32_t count) const;
 
   //--------------------------------------------------------------------------------
   // Misc
   //--------------------------------------------------------------------------------
-  static Mat4 Perspective(float width, float height, float nearPlane,
-                          float farPlane);
-  static Mat4 Ortho2D(float left, float top, float right, float bottom);
+  static constexpr Mat4 Perspective(float width, float height,
+                                    float nearPlane, float farPlane) {
+    return PerspectiveFromTerms(width, height, 2.0f * nearPlane,
+                                1.f / (nearPlane - farPlane), nearPlane,
+                                farPlane);
+  }
+  static constexpr Mat4 Ortho2D(float left, float top, float right,
+                                float bottom) {
+    return Ortho2DFromTerms(left, top, right, bottom, 1.0f / (1.0f - -1.0f),
+                            1.0f / (-top + bottom), 1.0f / (right - left));
+  }
 
   static Mat4 LookAt(const Vec3 &vEye, const Vec3 &vAt, const Vec3 &vUp);
 
-  static Mat4 Translation(const float fX, const float fY, const float fZ);
-  static Mat4 Translation(const Vec3 vec);
+  static constexpr Mat4 Translation(const float fX, const float fY,
+                                    const float fZ) {
+    return Mat4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, fX, fY, fZ, 1.0f);
+  }
+  static constexpr Mat4 Translation(const Vec3 vec) {
+    return Translation(vec.x_, vec.y_, vec.z_);
+  }
 
   static Mat4 RotationX(const float angle);
 
@@ -789,27 +855,27 @@ public:
 
   static Mat4 RotationZ(const float angle);
 
-  static Mat4 Scale(const float scaleX, const float scaleY, const float scaleZ);
-
-  static Mat4 Identity() {
-    Mat4 ret;
-    ret.f_[0] = 1.f;
-    ret.f_[1] = 0;
-    ret.f_[2] = 0;
-    ret.f_[3] = 0;
-    ret.f_[4] = 0;
-    ret.f_[5] = 1.f;
-    ret.f_[6] = 0;
-    ret.f_[7] = 0;
-    ret.f_[8] = 0;
-    ret.f_[9] = 0;
-    ret.f_[10] = 1.f;
-    ret.f_[11] = 0;
-    ret.f_[12] = 0;
-    ret.f_[13] = 0;
-    ret.f_[14] = 0;
-    ret.f_[15] = 1.f;
-    return ret;
+  static constexpr Mat4 Scale(const float scaleX, const float scaleY,
+                              const float scaleZ) {
+    return Mat4(scaleX, 0.f, 0.f, 0.f, 0.f, scaleY, 0.f, 0.f, 0.f, 0.f,
+                scaleZ, 0.f, 0.f, 0.f, 0.f, 1.0f);
+  }
+
+  static constexpr Mat4 Identity() { return Mat4(); }
+
+  /*
+   * Compile time lhs * rhs, e.g. to fold a constant model matrix.
+   * At runtime prefer operator*, which uses SIMD.
+   */
+  static constexpr Mat4 Product(const Mat4 &lhs, const Mat4 &rhs) {
+    return Mat4(ProductTerm(lhs, rhs, 0, 0), ProductTerm(lhs, rhs, 1, 0),
+                ProductTerm(lhs, rhs, 2, 0), ProductTerm(lhs, rhs, 3, 0),
+                ProductTerm(lhs, rhs, 0, 1), ProductTerm(lhs, rhs, 1, 1),
+                ProductTerm(lhs, rhs, 2, 1), ProductTerm(lhs, rhs, 3, 1),
+                ProductTerm(lhs, rhs, 0, 2), ProductTerm(lhs, rhs, 1, 2),
+                ProductTerm(lhs, rhs, 2, 2), ProductTerm(lhs, rhs, 3, 2),
+                ProductTerm(lhs, rhs, 0, 3), ProductTerm(lhs, rhs, 1, 3),
+                ProductTerm(lhs, rhs, 2, 3), ProductTerm(lhs, rhs, 3, 3));
   }
 
   void Dump() {
@@ -832,27 +898,17 @@ public:
   friend class Vec3;
   friend class Vec4;
   friend class Mat4;
+  friend class AffineTransform;
+  friend class DualQuaternion;
 
-  Quaternion() {
-    x_ = 0.f;
-    y_ = 0.f;
-    z_ = 0.f;
-    w_ = 1.f;
-  }
+  constexpr Quaternion() : x_(0.f), y_(0.f), z_(0.f), w_(1.f) {}
 
-  Quaternion(const float fX, const float fY, const float fZ, const float fW) {
-    x_ = fX;
-    y_ = fY;
-    z_ = fZ;
-    w_ = fW;
-  }
+  constexpr Quaternion(const float fX, const float fY, const float fZ,
+                       const float fW)
+      : x_(fX), y_(fY), z_(fZ), w_(fW) {}
 
-  Quaternion(const Vec3 vec, const float fW) {
-    x_ = vec.x_;
-    y_ = vec.y_;
-    z_ = vec.z_;
-    w_ = fW;
-  }
+  constexpr Quaternion(const Vec3 vec, const float fW)
+      : x_(vec.x_), y_(vec.y_), z_(vec.z_), w_(fW) {}
 
   Quaternion(const float *p) {
     x_ = *p++;
@@ -861,7 +917,7 @@ public:
     w_ = *p++;
   }
 
-  Quaternion operator*(const Quaternion rhs) {
+  Quaternion operator*(const Quaternion rhs) const {
     Quaternion ret;
     ret.x_ = x_ * rhs.w_ + y_ * rhs.z_ - z_ * rhs.y_ + w_ * rhs.x_;
     ret.y_ = -x_ * rhs.z_ + y_ * rhs.w_ + z_ * rhs.x_ + w_ * rhs.y_;
@@ -888,7 +944,7 @@ public:
   }
 
   //Non destuctive version
-  Quaternion Conjugated() {
+  Quaternion Conjugated() const {
     Quaternion ret;
     ret.x_ = -x_;
     ret.y_ = -y_;
@@ -948,6 +1004,44 @@ public:
     mat.f_[15] = 1.0f;
   }
 
+  float Dot(const Quaternion &rhs) const {
+    return x_ * rhs.x_ + y_ * rhs.y_ + z_ * rhs.z_ + w_ * rhs.w_;
+  }
+
+  Quaternion Normalize() {
+    float len = sqrtf(Dot(*this));
+    x_ = x_ / len;
+    y_ = y_ / len;
+    z_ = z_ / len;
+    w_ = w_ / len;
+    return *this;
+  }
+
+  /*
+   * Interpolation between unit quaternions along the shortest path.
+   * Nlerp() is a normalized linear blend, cheaper but not constant speed.
+   * Slerp() falls back to Nlerp() when the quaternions are nearly equal.
+   */
+  static Quaternion Nlerp(const Quaternion &from, const Quaternion &to,
+                          const float t);
+  static Quaternion Slerp(const Quaternion &from, const Quaternion &to,
+                          const float t);
+
+  /*
+   * Batch versions, 4 quaternions per SIMD step, with either one t for all
+   * pairs or one t per pair. out may alias from or to.
+   * The batch Slerp() uses polynomial acos/sin approximations, results are
+   * within ~1e-6 of the single value version.
+   */
+  static void Nlerp(const Quaternion *from, const Quaternion *to,
+                    const float t, Quaternion *out, const int32_t count);
+  static void Nlerp(const Quaternion *from, const Quaternion *to,
+                    const float *t, Quaternion *out, const int32_t count);
+  static void Slerp(const Quaternion *from, const Quaternion *to,
+                    const float t, Quaternion *out, const int32_t count);
+  static void Slerp(const Quaternion *from, const Quaternion *to,
+                    const float *t, Quaternion *out, const int32_t count);
+
   static Quaternion RotationAxis(const Vec3 axis, const float angle) {
     Quaternion ret;
     float s = sinf(angle / 2);
@@ -966,5 +1060,137 @@ public:
   }
 };
 
+/******************************************************************
+ * Affine transform class
+ * 3x4 matrix holding the upper three rows of an affine Mat4 (the last row is
+ * always 0, 0, 0, 1 and is not stored or computed).
+ * Elements are stored row by row, [ r00 r01 r02 tx | r10 ... | r20 ... tz ],
+ * which is also the layout of a GLSL mat3x4 multiplied as vec4(p, 1.0) * m.
+ *
+ * Composition needs 3/4 of the arithmetic of Mat4::operator*, and rigid
+ * transforms (rotation + translation) can be inverted with a transpose via
+ * InverseOrthonormal() instead of a general cofactor inverse.
+ */
+class AffineTransform {
+private:
+  float r_[12];
+
+public:
+  constexpr AffineTransform()
+      : r_{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f } {}
+
+  //Drops the last row of mat, which is expected to be 0, 0, 0, 1
+  explicit AffineTransform(const Mat4 &mat);
+
+  //Rotation by a unit quaternion followed by a translation
+  AffineTransform(const Quaternion &rotation, const Vec3 &translation);
+
+  AffineTransform operator*(const AffineTransform &rhs) const;
+  AffineTransform &operator*=(const AffineTransform &rhs) {
+    *this = *this * rhs;
+    return *this;
+  }
+
+  //Transform a point (w = 1)
+  Vec3 operator*(const Vec3 &rhs) const {
+    return Vec3(r_[0] * rhs.x_ + r_[1] * rhs.y_ + r_[2] * rhs.z_ + r_[3],
+                r_[4] * rhs.x_ + r_[5] * rhs.y_ + r_[6] * rhs.z_ + r_[7],
+                r_[8] * rhs.x_ + r_[9] * rhs.y_ + r_[10] * rhs.z_ + r_[11]);
+  }
+
+  //Transform a direction (w = 0), translation is ignored
+  Vec3 TransformDirection(const Vec3 &rhs) const {
+    return Vec3(r_[0] * rhs.x_ + r_[1] * rhs.y_ + r_[2] * rhs.z_,
+                r_[4] * rhs.x_ + r_[5] * rhs.y_ + r_[6] * rhs.z_,
+                r_[8] * rhs.x_ + r_[9] * rhs.y_ + r_[10] * rhs.z_);
+  }
+
+  /*
+   * Inverse() works for any invertible affine transform, InverseOrthonormal()
+   * is only valid when the 3x3 part is a pure rotation.
+   * As Mat4::Inverse(), both update this transform and return it.
+   */
+  AffineTransform Inverse();
+  AffineTransform InverseOrthonormal();
+
+  Mat4 ToMat4() const;
+  //Rotation part as a unit quaternion, the 3x3 part must be orthonormal
+  Quaternion ToQuaternion() const;
+  Vec3 GetTranslation() const { return Vec3(r_[3], r_[7], r_[11]); }
+
+  float *Ptr() { return r_; }
+
+  static constexpr AffineTransform Identity() { return AffineTransform(); }
+
+  void Dump() {
+    LOGI("%f %f %f %f", r_[0], r_[1], r_[2], r_[3]);
+    LOGI("%f %f %f %f", r_[4], r_[5], r_[6], r_[7]);
+    LOGI("%f %f %f %f", r_[8], r_[9], r_[10], r_[11]);
+  }
+};
+
+/******************************************************************
+ * Dual quaternion class
+ * Unit dual quaternions represent rigid transforms (rotation followed by a
+ * translation) as real + dual * e, with dual = 0.5 * translation * real.
+ * Unlike matrices they can be blended linearly (Blend()) without shearing,
+ * which makes them a good fit for skinning and rigid animation blending.
+ */
+class DualQuaternion {
+private:
+  Quaternion real_;
+  Quaternion dual_;
+
+public:
+  constexpr DualQuaternion()
+      : real_(0.f, 0.f, 0.f, 1.f), dual_(0.f, 0.f, 0.f, 0.f) {}
+
+  constexpr DualQuaternion(const Quaternion &real, const Quaternion &dual)
+      : real_(real), dual_(dual) {}
+
+  //Rotation by a unit quaternion followed by a translation
+  DualQuaternion(const Quaternion &rotation, const Vec3 &translation);
+
+  //Applies rhs first, like Mat4 products
+  DualQuaternion operator*(const DualQuaternion &rhs) const;
+  DualQuaternion &operator*=(const DualQuaternion &rhs) {
+    *this = *this * rhs;
+    return *this;
+  }
+
+  //Transform a point (rotation then translation)
+  Vec3 operator*(const Vec3 &rhs) const;
+  //Transform a direction, translation is ignored
+  Vec3 TransformDirection(const Vec3 &rhs) const;
+
+  //Scales back to a unit dual quaternion, updates and returns this
+  DualQuaternion Normalize();
+  //Inverse of a unit dual quaternion, updates and returns this
+  DualQuaternion Inverse();
+
+  /*
+   * Dual quaternion linear blending: weighted sum of count transforms,
+   * flipped to the hemisphere of the first one and normalized.
+   * Weights do not need to add up to 1.
+   */
+  static DualQuaternion Blend(const DualQuaternion *dqs, const float *weights,
+                              const int32_t count);
+  static DualQuaternion Blend(const DualQuaternion &from,
+                              const DualQuaternion &to, const float t);
+
+  const Quaternion &GetRotation() const { return real_; }
+  Vec3 GetTranslation() const;
+
+  AffineTransform ToAffineTransform() const;
+  Mat4 ToMat4() const;
+
+  static constexpr DualQuaternion Identity() { return DualQuaternion(); }
+
+  void Dump() {
+    LOGI("real %f %f %f %f", real_.x_, real_.y_, real_.z_, real_.w_);
+    LOGI("dual %f %f %f %f", dual_.x_, dual_.y_, dual_.z_, dual_.w_);
+  }
+};
+
 }      //namespace ndk_helper
 #endif /* VECMATH_H_ */
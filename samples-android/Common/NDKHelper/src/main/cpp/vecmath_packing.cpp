@@ -0,0 +1,348 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// vecmath_packing.cpp
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <string.h>
+
+#include "vecmath_packing.h"
+#include "vecmath_simd.h"
+
+#if defined(NDK_HELPER_SIMD_SSE) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ndk_helper {
+
+namespace packing {
+
+namespace {
+
+const float SNORM16_SCALE = 32767.f;
+const float SNORM8_SCALE = 127.f;
+
+//Adding and subtracting 1.5 * 2^23 rounds to the nearest integer, ties to
+//even, for |f| < 2^22. This gives the same rounding on every SIMD backend
+//(ARMv7 NEON only has a truncating float to int conversion).
+const float ROUND_MAGIC = 12582912.f;
+
+inline uint32_t FloatBits(const float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float BitsFloat(const uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+//Clamped to [-1, 1], scaled and rounded, same operation order as the scalar
+//RoundSnorm()
+inline simd::float4 RoundSnorm(const simd::float4 v, const float scale) {
+  simd::float4 c =
+      simd::Max(simd::Min(v, simd::Splat(1.f)), simd::Splat(-1.f));
+  simd::float4 magic = simd::Splat(ROUND_MAGIC);
+  return simd::Sub(simd::MulAdd(magic, c, simd::Splat(scale)), magic);
+}
+
+inline float RoundSnorm(const float f, const float scale) {
+  float c = f < 1.f ? f : 1.f;
+  c = c > -1.f ? c : -1.f;
+  return (ROUND_MAGIC + c * scale) - ROUND_MAGIC;
+}
+
+//Stores 4 lanes holding integral values
+inline void StoreSnorm16(int16_t *out, const simd::float4 v) {
+#if defined(NDK_HELPER_SIMD_NEON)
+  vst1_s16(out, vmovn_s32(vcvtq_s32_f32(v)));
+#elif defined(NDK_HELPER_SIMD_SSE) && defined(__SSE2__)
+  __m128i i = _mm_cvttps_epi32(v);
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packs_epi32(i, i));
+#else
+  float f[4];
+  simd::Store(f, v);
+  for (int32_t i = 0; i < 4; ++i)
+    out[i] = (int16_t)f[i];
+#endif
+}
+
+inline void StoreSnorm8(int8_t *out, const simd::float4 v) {
+#if defined(NDK_HELPER_SIMD_NEON)
+  int16x4_t s = vmovn_s32(vcvtq_s32_f32(v));
+  int8x8_t b = vmovn_s16(vcombine_s16(s, s));
+  int32_t packed = vget_lane_s32(vreinterpret_s32_s8(b), 0);
+  memcpy(out, &packed, sizeof(packed));
+#elif defined(NDK_HELPER_SIMD_SSE) && defined(__SSE2__)
+  __m128i i = _mm_cvttps_epi32(v);
+  __m128i s = _mm_packs_epi32(i, i);
+  int32_t packed = _mm_cvtsi128_si32(_mm_packs_epi16(s, s));
+  memcpy(out, &packed, sizeof(packed));
+#else
+  float f[4];
+  simd::Store(f, v);
+  for (int32_t i = 0; i < 4; ++i)
+    out[i] = (int8_t)f[i];
+#endif
+}
+
+#if defined(NDK_HELPER_SIMD_SSE) && defined(__SSE2__)
+//Same bit manipulation as the scalar FloatToHalf(), 4 lanes at a time.
+//Returns the halves in the low 16 bits of each lane, sign extended
+__m128i FloatToHalfSSE2(const __m128 f) {
+  const __m128i sign_mask = _mm_set1_epi32(0x80000000u);
+  const __m128i f16_max = _mm_set1_epi32((127 + 16) << 23);
+  const __m128i f16_min_normal = _mm_set1_epi32((127 - 14) << 23);
+  const __m128i denorm_magic =
+      _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+  __m128 sign = _mm_and_ps(_mm_castsi128_ps(sign_mask), f);
+  __m128 abs_f = _mm_xor_ps(f, sign);
+  __m128i abs_bits = _mm_castps_si128(abs_f);
+
+  //Inf or NaN
+  __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(abs_f, abs_f));
+  __m128i special = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)),
+                                 _mm_set1_epi32(0x7c00));
+  __m128i is_regular = _mm_cmpgt_epi32(f16_max, abs_bits);
+
+  //Subnormal results, rounded by the float addition
+  __m128i is_subnormal = _mm_cmpgt_epi32(f16_min_normal, abs_bits);
+  __m128i subnormal = _mm_sub_epi32(
+      _mm_castps_si128(_mm_add_ps(abs_f, _mm_castsi128_ps(denorm_magic))),
+      denorm_magic);
+
+  //Normal results, round to nearest even
+  __m128i mantissa_odd = _mm_srai_epi32(_mm_slli_epi32(abs_bits, 31 - 13), 31);
+  __m128i normal = _mm_srli_epi32(
+      _mm_sub_epi32(_mm_add_epi32(abs_bits, normal_bias), mantissa_odd), 13);
+
+  __m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal),
+                                _mm_andnot_si128(is_subnormal, normal));
+  __m128i result = _mm_or_si128(_mm_and_si128(is_regular, finite),
+                                _mm_andnot_si128(is_regular, special));
+  return _mm_or_si128(result, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+//Octahedral projection of 4 normals, same operation order as the scalar
+//EncodeOctahedral()
+void EncodeOctahedral4(const float *normals, simd::float4 &out_x,
+                       simd::float4 &out_y) {
+  const float *n = normals;
+  simd::float4 x = simd::Set(n[0], n[3], n[6], n[9]);
+  simd::float4 y = simd::Set(n[1], n[4], n[7], n[10]);
+  simd::float4 z = simd::Set(n[2], n[5], n[8], n[11]);
+  const simd::float4 zero = simd::Splat(0.f);
+  const simd::float4 one = simd::Splat(1.f);
+  const simd::float4 minus_one = simd::Splat(-1.f);
+
+  simd::float4 l1 =
+      simd::Add(simd::Add(simd::Abs(x), simd::Abs(y)), simd::Abs(z));
+  simd::float4 inv_l1 = simd::Div(one, l1);
+  simd::float4 px = simd::Mul(x, inv_l1);
+  simd::float4 py = simd::Mul(y, inv_l1);
+
+  simd::float4 sign_x = simd::Select(simd::CmpLt(px, zero), minus_one, one);
+  simd::float4 sign_y = simd::Select(simd::CmpLt(py, zero), minus_one, one);
+  simd::float4 fold_x = simd::Mul(simd::Sub(one, simd::Abs(py)), sign_x);
+  simd::float4 fold_y = simd::Mul(simd::Sub(one, simd::Abs(px)), sign_y);
+  simd::float4 lower = simd::CmpLt(z, zero);
+  out_x = simd::Select(lower, fold_x, px);
+  out_y = simd::Select(lower, fold_y, py);
+}
+
+} //namespace
+
+//--------------------------------------------------------------------------------
+// Single values
+//--------------------------------------------------------------------------------
+uint16_t FloatToHalf(const float f) {
+  const uint32_t f16_max = (127 + 16) << 23;
+  const uint32_t f32_infinity = 255 << 23;
+  const uint32_t f16_min_normal = (127 - 14) << 23;
+  const uint32_t denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+  uint32_t bits = FloatBits(f);
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+
+  uint32_t ret;
+  if (bits >= f16_max) {
+    //Inf or NaN, NaN is returned as a quiet NaN
+    ret = bits > f32_infinity ? 0x7e00 : 0x7c00;
+  } else if (bits < f16_min_normal) {
+    //Subnormal or zero, the float addition rounds the mantissa
+    ret = FloatBits(BitsFloat(bits) + BitsFloat(denorm_magic)) - denorm_magic;
+  } else {
+    uint32_t mantissa_odd = (bits >> 13) & 1;
+    bits += ((uint32_t)(15 - 127) << 23) + 0xfff;
+    bits += mantissa_odd;
+    ret = bits >> 13;
+  }
+  return (uint16_t)(ret | (sign >> 16));
+}
+
+float HalfToFloat(const uint16_t h) {
+  const uint32_t shifted_exponent = 0x7c00 << 13;
+  uint32_t bits = (h & 0x7fff) << 13;
+  uint32_t exponent = bits & shifted_exponent;
+  bits += (127 - 15) << 23;
+
+  float ret;
+  if (exponent == shifted_exponent) {
+    //Inf or NaN
+    ret = BitsFloat(bits + ((128 - 16) << 23));
+  } else if (exponent == 0) {
+    //Zero or subnormal, renormalize
+    ret = BitsFloat(bits + (1 << 23)) - BitsFloat(113 << 23);
+  } else {
+    ret = BitsFloat(bits);
+  }
+  return BitsFloat(FloatBits(ret) | ((uint32_t)(h & 0x8000) << 16));
+}
+
+int16_t FloatToSnorm16(const float f) {
+  return (int16_t)RoundSnorm(f, SNORM16_SCALE);
+}
+
+int8_t FloatToSnorm8(const float f) {
+  return (int8_t)RoundSnorm(f, SNORM8_SCALE);
+}
+
+float Snorm16ToFloat(const int16_t s) {
+  float f = s / SNORM16_SCALE;
+  return f > -1.f ? f : -1.f;
+}
+
+float Snorm8ToFloat(const int8_t s) {
+  float f = s / SNORM8_SCALE;
+  return f > -1.f ? f : -1.f;
+}
+
+void EncodeOctahedral(const float *normal, float *encoded) {
+  float inv_l1 =
+      1.f / (fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]));
+  float px = normal[0] * inv_l1;
+  float py = normal[1] * inv_l1;
+  if (normal[2] < 0.f) {
+    float fold_x = (1.f - fabsf(py)) * (px < 0.f ? -1.f : 1.f);
+    float fold_y = (1.f - fabsf(px)) * (py < 0.f ? -1.f : 1.f);
+    px = fold_x;
+    py = fold_y;
+  }
+  encoded[0] = px;
+  encoded[1] = py;
+}
+
+void DecodeOctahedral(const float *encoded, float *normal) {
+  float x = encoded[0];
+  float y = encoded[1];
+  float z = 1.f - fabsf(x) - fabsf(y);
+  if (z < 0.f) {
+    float fold_x = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+    float fold_y = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+    x = fold_x;
+    y = fold_y;
+  }
+  float inv_len = 1.f / sqrtf(x * x + y * y + z * z);
+  normal[0] = x * inv_len;
+  normal[1] = y * inv_len;
+  normal[2] = z * inv_len;
+}
+
+//--------------------------------------------------------------------------------
+// Batches
+//--------------------------------------------------------------------------------
+void FloatToHalf(const float *in, uint16_t *out, const int32_t count) {
+  int32_t i = 0;
+#if defined(NDK_HELPER_SIMD_NEON) && defined(__aarch64__)
+  for (; i + 4 <= count; i += 4)
+    vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+#elif defined(NDK_HELPER_SIMD_SSE) && defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    __m128i h = FloatToHalfSSE2(_mm_loadu_ps(in + i));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packs_epi32(h, h));
+  }
+#endif
+  for (; i < count; ++i)
+    out[i] = FloatToHalf(in[i]);
+}
+
+void FloatToSnorm16(const float *in, int16_t *out, const int32_t count) {
+  int32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    StoreSnorm16(out + i, RoundSnorm(simd::Load(in + i), SNORM16_SCALE));
+  for (; i < count; ++i)
+    out[i] = FloatToSnorm16(in[i]);
+}
+
+void FloatToSnorm8(const float *in, int8_t *out, const int32_t count) {
+  int32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    StoreSnorm8(out + i, RoundSnorm(simd::Load(in + i), SNORM8_SCALE));
+  for (; i < count; ++i)
+    out[i] = FloatToSnorm8(in[i]);
+}
+
+void EncodeOctahedralSnorm16(const float *normals, int16_t *out,
+                             const int32_t count) {
+  int32_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x, y;
+    EncodeOctahedral4(normals + i * 3, x, y);
+    float xy[8];
+    simd::Store(xy, x);
+    simd::Store(xy + 4, y);
+    const float interleaved[8] = { xy[0], xy[4], xy[1], xy[5],
+                                   xy[2], xy[6], xy[3], xy[7] };
+    FloatToSnorm16(interleaved, out + i * 2, 8);
+  }
+  for (; i < count; ++i) {
+    float encoded[2];
+    EncodeOctahedral(normals + i * 3, encoded);
+    FloatToSnorm16(encoded, out + i * 2, 2);
+  }
+}
+
+void EncodeOctahedralSnorm8(const float *normals, int8_t *out,
+                            const int32_t count) {
+  int32_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::float4 x, y;
+    EncodeOctahedral4(normals + i * 3, x, y);
+    float xy[8];
+    simd::Store(xy, x);
+    simd::Store(xy + 4, y);
+    const float interleaved[8] = { xy[0], xy[4], xy[1], xy[5],
+                                   xy[2], xy[6], xy[3], xy[7] };
+    FloatToSnorm8(interleaved, out + i * 2, 8);
+  }
+  for (; i < count; ++i) {
+    float encoded[2];
+    EncodeOctahedral(normals + i * 3, encoded);
+    FloatToSnorm8(encoded, out + i * 2, 2);
+  }
+}
+
+} //namespace packing
+
+}      //namespace ndk_helper
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VECMATH_PACKING_H_
+#define VECMATH_PACKING_H_
+
+#include <stdint.h>
+
+namespace ndk_helper {
+
+namespace packing {
+
+/******************************************************************
+ * Packed vertex attribute conversion
+ * namespace: ndk_helper::packing
+ *
+ * Converts float data to the compact formats GLES can fetch directly:
+ * - half float (GL_HALF_FLOAT, GL_HALF_FLOAT_OES), round to nearest even,
+ *   out of range values become infinity
+ * - snorm16/snorm8 (GL_SHORT/GL_BYTE with normalized = GL_TRUE), clamped to
+ *   [-1, 1] and scaled by 32767/127, round to nearest even
+ * - octahedral unit normals, 2 snorm components instead of 3
+ *
+ * Batch versions convert count elements and use SIMD where the instruction
+ * set allows it; results are identical to the single value versions (NaN
+ * payloads aside, NaN inputs to the snorm conversions are unspecified).
+ */
+
+uint16_t FloatToHalf(const float f);
+float HalfToFloat(const uint16_t h);
+int16_t FloatToSnorm16(const float f);
+int8_t FloatToSnorm8(const float f);
+float Snorm16ToFloat(const int16_t s);
+float Snorm8ToFloat(const int8_t s);
+
+void FloatToHalf(const float *in, uint16_t *out, const int32_t count);
+void FloatToSnorm16(const float *in, int16_t *out, const int32_t count);
+void FloatToSnorm8(const float *in, int8_t *out, const int32_t count);
+
+/******************************************************************
+ * Octahedral normal encoding
+ * Projects a unit vector on the octahedron |x| + |y| + |z| = 1 and unfolds
+ * the lower half, giving 2 values in [-1, 1].
+ * GLSL ES decoding:
+ *   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+ *   if (n.z < 0.0)
+ *     n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0,
+ *                                     n.y >= 0.0 ? 1.0 : -1.0);
+ *   n = normalize(n);
+ *
+ * Decoded snorm16 pairs are within 0.004 degrees of the unit vector, snorm8
+ * pairs within 1 degree.
+ *
+ * Batch versions read count xyz triplets and write count pairs. On ARMv7
+ * NEON the division is a refined reciprocal estimate, which may change the
+ * last bit of the projection.
+ */
+void EncodeOctahedral(const float *normal, float *encoded);
+void DecodeOctahedral(const float *encoded, float *normal);
+
+void EncodeOctahedralSnorm16(const float *normals, int16_t *out,
+                             const int32_t count);
+void EncodeOctahedralSnorm8(const float *normals, int8_t *out,
+                            const int32_t count);
+
+} //namespace packing
+
+}      //namespace ndk_helper
+#endif /* VECMATH_PACKING_H_ */
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VECMATH_SIMD_H_
+#define VECMATH_SIMD_H_
+
+/******************************************************************
+ * Thin 4-wide float abstraction used by vecmath kernels
+ * The backend is picked at compile time:
+ * - NEON on armeabi-v7a/arm64-v8a
+ * - SSE on x86/x86_64
+ * - plain C++ otherwise, or when NDK_HELPER_DISABLE_SIMD is defined
+ *
+ * MulAdd() is always evaluated as a separate multiply and add (never a fused
+ * multiply-add). The Mat4/Vec4 products accumulate in the order of the scalar
+ * reference kernels below, which are built without contraction, so both
+ * round exactly alike: the host benchmark checks them to 0 ulp.
+ *
+ * This header is internal to NDKHelper, applications should use vecmath.h.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(NDK_HELPER_DISABLE_SIMD)
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NDK_HELPER_SIMD_NEON 1
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define NDK_HELPER_SIMD_SSE 1
+#endif
+#endif
+
+#if defined(NDK_HELPER_SIMD_NEON) || defined(NDK_HELPER_SIMD_SSE)
+#define NDK_HELPER_SIMD 1
+#endif
+
+namespace ndk_helper {
+
+namespace simd {
+
+#if defined(NDK_HELPER_SIMD_NEON)
+typedef float32x4_t float4;
+
+inline float4 Load(const float *p) { return vld1q_f32(p); }
+inline void Store(float *p, const float4 v) { vst1q_f32(p, v); }
+inline float4 Splat(const float f) { return vdupq_n_f32(f); }
+inline float4 Set(const float x, const float y, const float z,
+                  const float w) {
+  const float f[4] = { x, y, z, w };
+  return vld1q_f32(f);
+}
+inline float4 Add(const float4 a, const float4 b) { return vaddq_f32(a, b); }
+inline float4 Sub(const float4 a, const float4 b) { return vsubq_f32(a, b); }
+inline float4 Mul(const float4 a, const float4 b) { return vmulq_f32(a, b); }
+inline float4 MulAdd(const float4 acc, const float4 a, const float4 b) {
+  return vaddq_f32(acc, vmulq_f32(a, b));
+}
+#if defined(__aarch64__)
+inline float4 Div(const float4 a, const float4 b) { return vdivq_f32(a, b); }
+#else
+//ARMv7 NEON has no divide, refine the reciprocal estimate twice (~1 ulp)
+inline float4 Div(const float4 a, const float4 b) {
+  float32x4_t r = vrecpeq_f32(b);
+  r = vmulq_f32(vrecpsq_f32(b, r), r);
+  r = vmulq_f32(vrecpsq_f32(b, r), r);
+  return vmulq_f32(a, r);
+}
+#endif
+inline float4 Min(const float4 a, const float4 b) { return vminq_f32(a, b); }
+inline float4 Max(const float4 a, const float4 b) { return vmaxq_f32(a, b); }
+inline float4 Abs(const float4 v) { return vabsq_f32(v); }
+#if defined(__aarch64__)
+inline float4 Sqrt(const float4 v) { return vsqrtq_f32(v); }
+#else
+//v * 1/sqrt(v) with a twice refined estimate, 0 is special cased as the
+//estimate is infinite there
+inline float4 Sqrt(const float4 v) {
+  float32x4_t r = vrsqrteq_f32(v);
+  r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+  r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(v, r), r), r);
+  return vbslq_f32(vceqq_f32(v, vdupq_n_f32(0.f)), v, vmulq_f32(v, r));
+}
+#endif
+
+//Lane masks are all ones (true) or all zeros (false)
+inline float4 CmpLt(const float4 a, const float4 b) {
+  return vreinterpretq_f32_u32(vcltq_f32(a, b));
+}
+inline float4 Select(const float4 mask, const float4 a, const float4 b) {
+  return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+inline float4 Or(const float4 a, const float4 b) {
+  return vreinterpretq_f32_u32(
+      vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+template <int lane>
+inline float4 SplatLane(const float4 v) {
+  return vdupq_n_f32(vgetq_lane_f32(v, lane));
+}
+
+//Bit i set when the sign bit of lane i is set
+inline int32_t SignMask(const float4 v) {
+  const int32_t shift[4] = { 0, 1, 2, 3 };
+  uint32x4_t bits = vshlq_u32(vshrq_n_u32(vreinterpretq_u32_f32(v), 31),
+                              vld1q_s32(shift));
+#if defined(__aarch64__)
+  return vaddvq_u32(bits);
+#else
+  uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+  return vget_lane_u32(vpadd_u32(sum, sum), 0);
+#endif
+}
+
+inline void Transpose(float4 &r0, float4 &r1, float4 &r2, float4 &r3) {
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#elif defined(NDK_HELPER_SIMD_SSE)
+typedef __m128 float4;
+
+inline float4 Load(const float *p) { return _mm_loadu_ps(p); }
+inline void Store(float *p, const float4 v) { _mm_storeu_ps(p, v); }
+inline float4 Splat(const float f) { return _mm_set1_ps(f); }
+inline float4 Set(const float x, const float y, const float z,
+                  const float w) {
+  return _mm_setr_ps(x, y, z, w);
+}
+inline float4 Add(const float4 a, const float4 b) { return _mm_add_ps(a, b); }
+inline float4 Sub(const float4 a, const float4 b) { return _mm_sub_ps(a, b); }
+inline float4 Mul(const float4 a, const float4 b) { return _mm_mul_ps(a, b); }
+inline float4 MulAdd(const float4 acc, const float4 a, const float4 b) {
+  return _mm_add_ps(acc, _mm_mul_ps(a, b));
+}
+inline float4 Div(const float4 a, const float4 b) { return _mm_div_ps(a, b); }
+inline float4 Min(const float4 a, const float4 b) { return _mm_min_ps(a, b); }
+inline float4 Max(const float4 a, const float4 b) { return _mm_max_ps(a, b); }
+inline float4 Abs(const float4 v) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+}
+inline float4 Sqrt(const float4 v) { return _mm_sqrt_ps(v); }
+
+//Lane masks are all ones (true) or all zeros (false)
+inline float4 CmpLt(const float4 a, const float4 b) {
+  return _mm_cmplt_ps(a, b);
+}
+inline float4 Select(const float4 mask, const float4 a, const float4 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline float4 Or(const float4 a, const float4 b) { return _mm_or_ps(a, b); }
+
+template <int lane>
+inline float4 SplatLane(const float4 v) {
+  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane));
+}
+
+//Bit i set when the sign bit of lane i is set
+inline int32_t SignMask(const float4 v) { return _mm_movemask_ps(v); }
+
+inline void Transpose(float4 &r0, float4 &r1, float4 &r2, float4 &r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+#else
+struct float4 {
+  float f[4];
+};
+
+inline float4 Load(const float *p) {
+  float4 r = { { p[0], p[1], p[2], p[3] } };
+  return r;
+}
+inline void Store(float *p, const float4 v) {
+  p[0] = v.f[0];
+  p[1] = v.f[1];
+  p[2] = v.f[2];
+  p[3] = v.f[3];
+}
+inline float4 Splat(const float f) {
+  float4 r = { { f, f, f, f } };
+  return r;
+}
+inline float4 Set(const float x, const float y, const float z,
+                  const float w) {
+  float4 r = { { x, y, z, w } };
+  return r;
+}
+inline float4 Add(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2],
+                 a.f[3] + b.f[3] } };
+  return r;
+}
+inline float4 Sub(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2],
+                 a.f[3] - b.f[3] } };
+  return r;
+}
+inline float4 Mul(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2],
+                 a.f[3] * b.f[3] } };
+  return r;
+}
+inline float4 MulAdd(const float4 acc, const float4 a, const float4 b) {
+  return Add(acc, Mul(a, b));
+}
+inline float4 Div(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] / b.f[0], a.f[1] / b.f[1], a.f[2] / b.f[2],
+                 a.f[3] / b.f[3] } };
+  return r;
+}
+inline float4 Min(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] < b.f[0] ? a.f[0] : b.f[0],
+                 a.f[1] < b.f[1] ? a.f[1] : b.f[1],
+                 a.f[2] < b.f[2] ? a.f[2] : b.f[2],
+                 a.f[3] < b.f[3] ? a.f[3] : b.f[3] } };
+  return r;
+}
+inline float4 Max(const float4 a, const float4 b) {
+  float4 r = { { a.f[0] > b.f[0] ? a.f[0] : b.f[0],
+                 a.f[1] > b.f[1] ? a.f[1] : b.f[1],
+                 a.f[2] > b.f[2] ? a.f[2] : b.f[2],
+                 a.f[3] > b.f[3] ? a.f[3] : b.f[3] } };
+  return r;
+}
+inline float4 Abs(const float4 v) {
+  float4 r = { { fabsf(v.f[0]), fabsf(v.f[1]), fabsf(v.f[2]), fabsf(v.f[3]) } };
+  return r;
+}
+inline float4 Sqrt(const float4 v) {
+  float4 r = { { sqrtf(v.f[0]), sqrtf(v.f[1]), sqrtf(v.f[2]), sqrtf(v.f[3]) } };
+  return r;
+}
+
+//Lane masks are all ones (true) or all zeros (false)
+inline float MaskLane(const bool b) {
+  const uint32_t bits = b ? 0xffffffffu : 0u;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+inline bool MaskLaneSet(const float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits != 0;
+}
+inline float4 CmpLt(const float4 a, const float4 b) {
+  float4 r = { { MaskLane(a.f[0] < b.f[0]), MaskLane(a.f[1] < b.f[1]),
+                 MaskLane(a.f[2] < b.f[2]), MaskLane(a.f[3] < b.f[3]) } };
+  return r;
+}
+inline float4 Select(const float4 mask, const float4 a, const float4 b) {
+  float4 r = { { MaskLaneSet(mask.f[0]) ? a.f[0] : b.f[0],
+                 MaskLaneSet(mask.f[1]) ? a.f[1] : b.f[1],
+                 MaskLaneSet(mask.f[2]) ? a.f[2] : b.f[2],
+                 MaskLaneSet(mask.f[3]) ? a.f[3] : b.f[3] } };
+  return r;
+}
+inline float4 Or(const float4 a, const float4 b) {
+  float4 r;
+  for (int32_t i = 0; i < 4; ++i) {
+    uint32_t bits[2];
+    memcpy(&bits[0], &a.f[i], sizeof(float));
+    memcpy(&bits[1], &b.f[i], sizeof(float));
+    bits[0] |= bits[1];
+    memcpy(&r.f[i], &bits[0], sizeof(float));
+  }
+  return r;
+}
+
+template <int lane>
+inline float4 SplatLane(const float4 v) {
+  return Splat(v.f[lane]);
+}
+
+//Bit i set when the sign bit of lane i is set
+inline int32_t SignMask(const float4 v) {
+  return (signbit(v.f[0]) ? 1 : 0) | (signbit(v.f[1]) ? 2 : 0) |
+         (signbit(v.f[2]) ? 4 : 0) | (signbit(v.f[3]) ? 8 : 0);
+}
+
+inline void Transpose(float4 &r0, float4 &r1, float4 &r2, float4 &r3) {
+  float4 t0 = { { r0.f[0], r1.f[0], r2.f[0], r3.f[0] } };
+  float4 t1 = { { r0.f[1], r1.f[1], r2.f[1], r3.f[1] } };
+  float4 t2 = { { r0.f[2], r1.f[2], r2.f[2], r3.f[2] } };
+  float4 t3 = { { r0.f[3], r1.f[3], r2.f[3], r3.f[3] } };
+  r0 = t0;
+  r1 = t1;
+  r2 = t2;
+  r3 = t3;
+}
+#endif
+
+} //namespace simd
+
+/******************************************************************
+ * Scalar reference kernels
+ * These are the original unrolled implementations of the Mat4/Vec4 products.
+ * They are used directly when no SIMD backend is available, and the host
+ * benchmark (vecmath_benchmark.cpp) checks the SIMD products against them.
+ * Matrices are column major float[16], vectors are float[4].
+ */
+namespace reference {
+
+void MultiplyMat4(const float *lhs, const float *rhs, float *out);
+void MultiplyMat4Vec4(const float *mat, const float *vec, float *out);
+void MultiplyVec4Mat4(const float *vec, const float *mat, float *out);
+
+} //namespace reference
+
+}      //namespace ndk_helper
+#endif /* VECMATH_SIMD_H_ */
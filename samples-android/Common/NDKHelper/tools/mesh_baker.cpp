@@ -0,0 +1,496 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh_baker.cpp
+// Converts .inl headers (like teapot.inl) and Wavefront OBJ files to the
+// binary mesh format in mesh.h
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mesh.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "vecmath_packing.h"
+
+namespace {
+
+using namespace ndk_helper;
+
+//De-indexed source data, xyz triplets
+struct SourceMesh {
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<uint32_t> indices;
+  std::vector<MeshLod> lods; //Ranges of indices, lods[0] is the full mesh
+};
+
+bool ReadText(const char *file_name, std::string *text) {
+  std::ifstream f(file_name, std::ios::binary);
+  if (!f) {
+    printf("Can not open a file:%s\n", file_name);
+    return false;
+  }
+  std::stringstream ss;
+  ss << f.rdbuf();
+  *text = ss.str();
+  return true;
+}
+
+bool EndsWith(const std::string &str, const char *suffix) {
+  size_t len = strlen(suffix);
+  return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+}
+
+//Numbers of the array initializer whose name ends with suffix, e.g.
+//"float teapotPositions[] = { ... };"
+bool ParseInlArray(const std::string &text, const char *suffix,
+                   std::vector<float> *values) {
+  size_t pos = 0;
+  while ((pos = text.find("[]", pos)) != std::string::npos) {
+    size_t name_end = pos;
+    size_t name_start = name_end;
+    while (name_start > 0 && (isalnum((unsigned char)text[name_start - 1]) ||
+                              text[name_start - 1] == '_'))
+      --name_start;
+    pos += 2;
+    if (!EndsWith(text.substr(name_start, name_end - name_start), suffix))
+      continue;
+
+    size_t begin = text.find('{', pos);
+    size_t end = text.find('}', begin);
+    if (begin == std::string::npos || end == std::string::npos)
+      return false;
+    const char *p = text.c_str() + begin + 1;
+    const char *last = text.c_str() + end;
+    values->clear();
+    while (p < last) {
+      char *next;
+      float value = strtof(p, &next);
+      if (next == p) {
+        ++p; //Separator
+        continue;
+      }
+      values->push_back(value);
+      p = next;
+    }
+    return true;
+  }
+  printf("No *%s[] array\n", suffix);
+  return false;
+}
+
+bool LoadInl(const char *file_name, SourceMesh *mesh) {
+  std::string text;
+  std::vector<float> indices;
+  if (!ReadText(file_name, &text) ||
+      !ParseInlArray(text, "Positions", &mesh->positions) ||
+      !ParseInlArray(text, "Normals", &mesh->normals) ||
+      !ParseInlArray(text, "Indices", &indices))
+    return false;
+  mesh->indices.assign(indices.begin(), indices.end());
+  return true;
+}
+
+//1 based, negative values count from the end
+int32_t ObjIndex(const char *str, const size_t count) {
+  int32_t index = atoi(str);
+  return index < 0 ? (int32_t)count + index : index - 1;
+}
+
+void ComputeNormals(SourceMesh *mesh) {
+  //Area weighted face normals accumulated per vertex
+  mesh->normals.assign(mesh->positions.size(), 0.f);
+  for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3) {
+    const float *p0 = &mesh->positions[mesh->indices[i] * 3];
+    const float *p1 = &mesh->positions[mesh->indices[i + 1] * 3];
+    const float *p2 = &mesh->positions[mesh->indices[i + 2] * 3];
+    Vec3 n = (Vec3(p1) - Vec3(p0)).Cross(Vec3(p2) - Vec3(p0));
+    float x, y, z;
+    n.Value(x, y, z);
+    for (int32_t j = 0; j < 3; ++j) {
+      float *normal = &mesh->normals[mesh->indices[i + j] * 3];
+      normal[0] += x;
+      normal[1] += y;
+      normal[2] += z;
+    }
+  }
+  for (size_t i = 0; i < mesh->normals.size(); i += 3) {
+    float *n = &mesh->normals[i];
+    float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (len > 0.f) {
+      n[0] /= len;
+      n[1] /= len;
+      n[2] /= len;
+    } else {
+      n[2] = 1.f;
+    }
+  }
+}
+
+//v, vn and f records, other records are ignored. Polygons are fanned, vertices
+//are unique position/normal pairs
+bool LoadObj(const char *file_name, SourceMesh *mesh) {
+  std::string text;
+  if (!ReadText(file_name, &text))
+    return false;
+
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::map<std::pair<int32_t, int32_t>, uint32_t> vertices;
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    std::istringstream ss(line);
+    std::string type;
+    ss >> type;
+    if (type == "v" || type == "vn") {
+      float x = 0.f, y = 0.f, z = 0.f;
+      ss >> x >> y >> z;
+      std::vector<float> &v = type == "v" ? positions : normals;
+      v.push_back(x);
+      v.push_back(y);
+      v.push_back(z);
+    } else if (type == "f") {
+      std::vector<uint32_t> polygon;
+      std::string corner;
+      while (ss >> corner) {
+        int32_t position = ObjIndex(corner.c_str(), positions.size() / 3);
+        int32_t normal = -1;
+        size_t slash = corner.rfind('/');
+        if (slash != std::string::npos && slash + 1 < corner.size() &&
+            corner.find('/') != slash)
+          normal = ObjIndex(corner.c_str() + slash + 1, normals.size() / 3);
+        if (position < 0 || position >= (int32_t)positions.size() / 3 ||
+            normal >= (int32_t)normals.size() / 3) {
+          printf("Invalid face:%s\n", line.c_str());
+          return false;
+        }
+
+        std::pair<int32_t, int32_t> key(position, normal);
+        std::map<std::pair<int32_t, int32_t>, uint32_t>::iterator it =
+            vertices.find(key);
+        if (it == vertices.end()) {
+          it = vertices.insert(
+              std::make_pair(key, (uint32_t)mesh->positions.size() / 3)).first;
+          mesh->positions.insert(mesh->positions.end(), &positions[position * 3],
+                                 &positions[position * 3] + 3);
+          if (normal >= 0)
+            mesh->normals.insert(mesh->normals.end(), &normals[normal * 3],
+                                 &normals[normal * 3] + 3);
+        }
+        polygon.push_back(it->second);
+      }
+      for (size_t i = 2; i < polygon.size(); ++i) {
+        mesh->indices.push_back(polygon[0]);
+        mesh->indices.push_back(polygon[i - 1]);
+        mesh->indices.push_back(polygon[i]);
+      }
+    }
+  }
+
+  if (mesh->normals.empty()) {
+    ComputeNormals(mesh);
+  } else if (mesh->normals.size() != mesh->positions.size()) {
+    printf("Either all or no face vertices need a normal\n");
+    return false;
+  }
+  return true;
+}
+
+bool Validate(const SourceMesh &source) {
+  uint32_t num_vertices = (uint32_t)source.positions.size() / 3;
+  if (!num_vertices || source.normals.size() != source.positions.size() ||
+      source.indices.empty() || source.indices.size() % 3) {
+    printf("Invalid mesh\n");
+    return false;
+  }
+  for (size_t i = 0; i < source.indices.size(); ++i) {
+    if (source.indices[i] >= num_vertices) {
+      printf("Index %u out of range\n", source.indices[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+enum OPTIMIZATION {
+  OPTIMIZATION_NONE,
+  OPTIMIZATION_FORSYTH,
+  OPTIMIZATION_TIPSIFY,
+  OPTIMIZATION_OVERDRAW, //Tipsify, then overdraw cluster order
+};
+
+//Allowed vertex cache loss of the overdraw cluster order
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+void PrintCacheStatistics(const char *label, const SourceMesh &mesh) {
+  uint32_t num_vertices = (uint32_t)mesh.positions.size() / 3;
+  const uint32_t *indices = &mesh.indices[mesh.lods[0].first_index];
+  mesh_optimizer::CacheStatistics fifo16 = mesh_optimizer::AnalyzeVertexCache(
+      indices, mesh.lods[0].num_indices, num_vertices, 16);
+  mesh_optimizer::CacheStatistics fifo32 = mesh_optimizer::AnalyzeVertexCache(
+      indices, mesh.lods[0].num_indices, num_vertices, 32);
+  printf("%-7s ACMR %.3f/%.3f ATVR %.3f/%.3f (FIFO 16/32)\n", label,
+         fifo16.acmr, fifo32.acmr, fifo16.atvr, fifo32.atvr);
+}
+
+//Triangle order of one LOD for the post transform cache
+void OptimizeTriangles(const SourceMesh &mesh, const MeshLod &lod,
+                       const OPTIMIZATION optimization, uint32_t *out) {
+  uint32_t num_vertices = (uint32_t)mesh.positions.size() / 3;
+  size_t num_indices = lod.num_indices;
+  const uint32_t *in = &mesh.indices[lod.first_index];
+
+  std::vector<uint32_t> indices(num_indices);
+  if (optimization == OPTIMIZATION_FORSYTH) {
+    mesh_optimizer::OptimizeVertexCacheForsyth(&indices[0], in, num_indices,
+                                               num_vertices);
+  } else {
+    mesh_optimizer::OptimizeVertexCacheTipsify(
+        &indices[0], in, num_indices, num_vertices,
+        mesh_optimizer::DEFAULT_CACHE_SIZE);
+  }
+
+  //Authoring order of regular meshes (patches, grids) can already be optimal
+  float input_acmr = mesh_optimizer::AnalyzeVertexCache(
+      in, num_indices, num_vertices, mesh_optimizer::DEFAULT_CACHE_SIZE).acmr;
+  float optimized_acmr = mesh_optimizer::AnalyzeVertexCache(
+      &indices[0], num_indices, num_vertices,
+      mesh_optimizer::DEFAULT_CACHE_SIZE).acmr;
+  if (optimized_acmr >= input_acmr) {
+    printf("input triangle order kept, its ACMR is lower\n");
+    indices.assign(in, in + num_indices);
+  }
+
+  if (optimization == OPTIMIZATION_OVERDRAW) {
+    mesh_optimizer::OptimizeOverdraw(
+        out, &indices[0], num_indices, &mesh.positions[0], 3, num_vertices,
+        mesh_optimizer::DEFAULT_CACHE_SIZE, OVERDRAW_THRESHOLD);
+  } else {
+    memcpy(out, &indices[0], num_indices * sizeof(uint32_t));
+  }
+}
+
+//Triangle order of every LOD, then vertex order for fetches, numbered by
+//first use in lods[0]
+void Optimize(SourceMesh *mesh, const OPTIMIZATION optimization) {
+  uint32_t num_vertices = (uint32_t)mesh->positions.size() / 3;
+  size_t num_indices = mesh->indices.size();
+  PrintCacheStatistics("before", *mesh);
+
+  std::vector<uint32_t> indices(num_indices);
+  for (size_t i = 0; i < mesh->lods.size(); ++i) {
+    OptimizeTriangles(*mesh, mesh->lods[i], optimization,
+                      &indices[mesh->lods[i].first_index]);
+  }
+  mesh->indices.swap(indices);
+
+  std::vector<uint32_t> remap(num_vertices);
+  uint32_t num_used = mesh_optimizer::BuildVertexFetchRemap(
+      &remap[0], &mesh->indices[0], num_indices, num_vertices);
+  mesh_optimizer::RemapIndices(&mesh->indices[0], num_indices, &remap[0]);
+  std::vector<float> positions(num_used * 3);
+  std::vector<float> normals(num_used * 3);
+  mesh_optimizer::RemapVertices(&positions[0], &mesh->positions[0],
+                                num_vertices, 3 * sizeof(float), &remap[0]);
+  mesh_optimizer::RemapVertices(&normals[0], &mesh->normals[0], num_vertices,
+                                3 * sizeof(float), &remap[0]);
+  mesh->positions.swap(positions);
+  mesh->normals.swap(normals);
+
+  PrintCacheStatistics("after", *mesh);
+  if (num_used < num_vertices)
+    printf("removed %u unused vertices\n", num_vertices - num_used);
+}
+
+//Each LOD has about half the triangles of the previous one
+void GenerateLods(SourceMesh *mesh, const int32_t num_lods) {
+  MeshSimplifier simplifier(&mesh->positions[0], 3,
+                            (uint32_t)mesh->positions.size() / 3,
+                            &mesh->indices[0], mesh->indices.size());
+  for (int32_t i = 1; i < num_lods; ++i) {
+    uint32_t previous = mesh->lods.back().num_indices;
+    size_t num_indices = simplifier.Simplify(previous / 6 * 3);
+    if (num_indices == 0 || num_indices > previous * 0.9f) {
+      printf("no further simplification possible, %d LODs\n", i);
+      break;
+    }
+
+    MeshLod lod = { (uint32_t)mesh->indices.size(), (uint32_t)num_indices,
+                    simplifier.GetError() };
+    mesh->indices.insert(mesh->indices.end(), simplifier.GetIndices().begin(),
+                         simplifier.GetIndices().end());
+    mesh->lods.push_back(lod);
+    printf("LOD %d: %u triangles, error %f\n", i, lod.num_indices / 3,
+           lod.error);
+  }
+}
+
+bool Bake(const SourceMesh &source, const bool packed, const char *file_name) {
+  uint32_t num_vertices = (uint32_t)source.positions.size() / 3;
+  MeshHeader header = {};
+  header.num_vertices = num_vertices;
+  header.num_indices = (uint32_t)source.indices.size();
+  header.num_attributes = 2;
+  header.attributes[0].semantic = MESH_SEMANTIC_POSITION;
+  header.attributes[1].semantic = MESH_SEMANTIC_NORMAL;
+  header.num_lods = (uint32_t)source.lods.size();
+  std::copy(source.lods.begin(), source.lods.end(), header.lods);
+
+  BoundingBox bounds =
+      BoundingBox::FromPoints(&source.positions[0], 3, num_vertices);
+  Vec3 center = bounds.GetCenter();
+  Vec3 extent = bounds.GetExtent();
+  center.Value(header.bounds_center[0], header.bounds_center[1],
+               header.bounds_center[2]);
+  extent.Value(header.bounds_extent[0], header.bounds_extent[1],
+               header.bounds_extent[2]);
+
+  std::vector<uint8_t> vertices;
+  if (packed) {
+    //Half float xyz1 + octahedral snorm16 normal, 12 bytes
+    header.vertex_stride = 12;
+    header.attributes[0].format = MESH_FORMAT_HALF4;
+    header.attributes[1].format = MESH_FORMAT_SNORM16_2;
+    header.attributes[1].offset = 8;
+
+    std::vector<uint16_t> positions(num_vertices * 3);
+    std::vector<int16_t> normals(num_vertices * 2);
+    packing::FloatToHalf(&source.positions[0], &positions[0],
+                         num_vertices * 3);
+    packing::EncodeOctahedralSnorm16(&source.normals[0], &normals[0],
+                                     num_vertices);
+    const uint16_t ONE = packing::FloatToHalf(1.f);
+    vertices.resize(num_vertices * header.vertex_stride);
+    for (uint32_t i = 0; i < num_vertices; ++i) {
+      uint16_t pos[4] = { positions[i * 3], positions[i * 3 + 1],
+                          positions[i * 3 + 2], ONE };
+      uint8_t *vertex = &vertices[i * header.vertex_stride];
+      memcpy(vertex, pos, sizeof(pos));
+      memcpy(vertex + 8, &normals[i * 2], 2 * sizeof(int16_t));
+    }
+  } else {
+    header.vertex_stride = 24;
+    header.attributes[0].format = MESH_FORMAT_FLOAT3;
+    header.attributes[1].format = MESH_FORMAT_FLOAT3;
+    header.attributes[1].offset = 12;
+
+    vertices.resize(num_vertices * header.vertex_stride);
+    for (uint32_t i = 0; i < num_vertices; ++i) {
+      uint8_t *vertex = &vertices[i * header.vertex_stride];
+      memcpy(vertex, &source.positions[i * 3], 3 * sizeof(float));
+      memcpy(vertex + 12, &source.normals[i * 3], 3 * sizeof(float));
+    }
+  }
+
+  //16 bit indices whenever they fit
+  std::vector<uint16_t> indices16;
+  const void *indices = &source.indices[0];
+  header.index_type = MESH_INDEX_TYPE_UINT32;
+  if (num_vertices <= 0x10000) {
+    indices16.assign(source.indices.begin(), source.indices.end());
+    indices = &indices16[0];
+    header.index_type = MESH_INDEX_TYPE_UINT16;
+  }
+
+  if (!Mesh::Write(file_name, header, &vertices[0], indices))
+    return false;
+
+  //Read it back through the runtime loader
+  Mesh mesh;
+  if (!mesh.Open(file_name))
+    return false;
+  printf("%s: %u vertices, %u triangles, %u bytes\n", file_name,
+         mesh.GetHeader().num_vertices, mesh.GetHeader().num_indices / 3,
+         mesh.GetHeader().file_size);
+  return true;
+}
+
+void PrintUsage(const char *name) {
+  printf("usage: %s [--packed] [--lods=N] [--no-optimize|--tipsify|--overdraw] "
+         "INPUT.{inl,obj} OUTPUT.mesh\n",
+         name);
+  printf("  --packed       half float position, octahedral normal\n");
+  printf("  --lods=N       simplified LODs, up to %d including the full mesh\n",
+         MESH_MAX_LODS);
+  printf("  --no-optimize  keep the input triangle and vertex order\n");
+  printf("  --tipsify      Tipsify instead of Forsyth triangle order\n");
+  printf("  --overdraw     Tipsify, then clusters sorted for less overdraw\n");
+}
+
+} //namespace
+
+int main(int argc, char *argv[]) {
+  bool packed = false;
+  OPTIMIZATION optimization = OPTIMIZATION_FORSYTH;
+  int32_t num_lods = 1;
+  const char *input = NULL;
+  const char *output = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--packed") == 0) {
+      packed = true;
+    } else if (strncmp(argv[i], "--lods=", 7) == 0) {
+      num_lods = atoi(argv[i] + 7);
+      if (num_lods < 1 || num_lods > MESH_MAX_LODS) {
+        PrintUsage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--no-optimize") == 0) {
+      optimization = OPTIMIZATION_NONE;
+    } else if (strcmp(argv[i], "--tipsify") == 0) {
+      optimization = OPTIMIZATION_TIPSIFY;
+    } else if (strcmp(argv[i], "--overdraw") == 0) {
+      optimization = OPTIMIZATION_OVERDRAW;
+    } else if (input == NULL) {
+      input = argv[i];
+    } else if (output == NULL) {
+      output = argv[i];
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (output == NULL) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  SourceMesh source;
+  std::string name(input);
+  bool loaded = EndsWith(name, ".obj") ? LoadObj(input, &source)
+                                       : LoadInl(input, &source);
+  if (!loaded || !Validate(source))
+    return 1;
+  MeshLod lod = { 0, (uint32_t)source.indices.size(), 0.f };
+  source.lods.push_back(lod);
+  if (num_lods > 1)
+    GenerateLods(&source, num_lods);
+  if (optimization != OPTIMIZATION_NONE)
+    Optimize(&source, optimization);
+  if (!Bake(source, packed, output))
+    return 1;
+  return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh_optimizer.cpp
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "mesh_optimizer.h"
+
+namespace ndk_helper {
+
+namespace mesh_optimizer {
+
+namespace {
+
+const uint32_t NO_TRIANGLE = 0xffffffff;
+
+//Triangles using each vertex, triangles of vertex v are
+//triangles[offsets[v]] .. triangles[offsets[v] + counts[v] - 1]
+struct Adjacency {
+  std::vector<uint32_t> counts;
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(const uint32_t *indices, const size_t num_indices,
+            const uint32_t num_vertices)
+      : counts(num_vertices, 0), offsets(num_vertices + 1, 0),
+        triangles(num_indices) {
+    for (size_t i = 0; i < num_indices; ++i)
+      ++counts[indices[i]];
+    for (uint32_t v = 0; v < num_vertices; ++v)
+      offsets[v + 1] = offsets[v] + counts[v];
+
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < num_indices; ++i)
+      triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+  }
+
+  //Removes triangle from the live list of vertex, order isn't kept
+  void Remove(const uint32_t vertex, const uint32_t triangle) {
+    uint32_t *list = &triangles[offsets[vertex]];
+    for (uint32_t i = 0; i < counts[vertex]; ++i) {
+      if (list[i] == triangle) {
+        list[i] = list[--counts[vertex]];
+        return;
+      }
+    }
+  }
+};
+
+//FIFO cache model shared by the analyzer and the cluster splitting
+class FifoCache {
+  std::vector<uint32_t> timestamps_;
+  uint32_t time_;
+  int32_t size_;
+
+public:
+  FifoCache(const uint32_t num_vertices, const int32_t size)
+      : timestamps_(num_vertices, 0), time_(size + 1), size_(size) {}
+
+  //Returns 1 on a miss
+  int32_t Access(const uint32_t vertex) {
+    if (time_ - timestamps_[vertex] > (uint32_t)size_) {
+      timestamps_[vertex] = time_++;
+      return 1;
+    }
+    return 0;
+  }
+
+  void Flush() { time_ += size_ + 1; }
+};
+
+//Forsyth's scoring, tuned for an LRU cache of 32 entries
+const int32_t FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+float ForsythVertexScore(const int32_t cache_position,
+                         const uint32_t live_triangles) {
+  if (live_triangles == 0)
+    return -1.f; //Nothing left to draw with this vertex
+
+  float score = 0.f;
+  if (cache_position >= 3) {
+    float scale = 1.f / (FORSYTH_CACHE_SIZE - 3);
+    score = powf(1.f - (cache_position - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+  } else if (cache_position >= 0) {
+    //Used by the last triangle, fixed score to avoid ping-ponging strips
+    score = FORSYTH_LAST_TRIANGLE_SCORE;
+  }
+  //Favor vertices with few triangles left, finishing them avoids re-loads
+  return score + FORSYTH_VALENCE_BOOST_SCALE *
+                     powf((float)live_triangles, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+} //namespace
+
+CacheStatistics AnalyzeVertexCache(const uint32_t *indices,
+                                   const size_t num_indices,
+                                   const uint32_t num_vertices,
+                                   const int32_t cache_size) {
+  FifoCache cache(num_vertices, cache_size);
+  std::vector<bool> used(num_vertices, false);
+  uint32_t misses = 0;
+  uint32_t num_used = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    misses += cache.Access(indices[i]);
+    if (!used[indices[i]]) {
+      used[indices[i]] = true;
+      ++num_used;
+    }
+  }
+
+  CacheStatistics statistics = { 0.f, 0.f };
+  if (num_indices)
+    statistics.acmr = misses * 3.f / num_indices;
+  if (num_used)
+    statistics.atvr = (float)misses / num_used;
+  return statistics;
+}
+
+void OptimizeVertexCacheForsyth(uint32_t *out, const uint32_t *in,
+                                const size_t num_indices,
+                                const uint32_t num_vertices) {
+  const uint32_t num_triangles = (uint32_t)(num_indices / 3);
+  Adjacency adjacency(in, num_indices, num_vertices);
+
+  std::vector<int32_t> cache_positions(num_vertices, -1);
+  std::vector<float> vertex_scores(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; ++v)
+    vertex_scores[v] = ForsythVertexScore(-1, adjacency.counts[v]);
+
+  std::vector<float> triangle_scores(num_triangles);
+  std::vector<bool> emitted(num_triangles, false);
+  uint32_t best = NO_TRIANGLE;
+  float best_score = -1.f;
+  for (uint32_t t = 0; t < num_triangles; ++t) {
+    triangle_scores[t] = vertex_scores[in[t * 3]] +
+                         vertex_scores[in[t * 3 + 1]] +
+                         vertex_scores[in[t * 3 + 2]];
+    if (triangle_scores[t] > best_score) {
+      best = t;
+      best_score = triangle_scores[t];
+    }
+  }
+
+  //LRU cache plus room for the 3 vertices a triangle pushes out
+  uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+  uint32_t new_cache[FORSYTH_CACHE_SIZE + 3];
+  int32_t cache_count = 0;
+  uint32_t cursor = 0;
+
+  for (uint32_t i = 0; i < num_triangles; ++i) {
+    if (best == NO_TRIANGLE) {
+      //Nothing in the cache has triangles left, continue at the next one in
+      //input order
+      while (emitted[cursor])
+        ++cursor;
+      best = cursor;
+    }
+
+    const uint32_t *triangle = &in[best * 3];
+    memcpy(&out[i * 3], triangle, 3 * sizeof(uint32_t));
+    emitted[best] = true;
+    for (int32_t j = 0; j < 3; ++j)
+      adjacency.Remove(triangle[j], best);
+
+    //Triangle vertices move to the front, the rest keep their order
+    int32_t new_count = 0;
+    for (int32_t j = 0; j < 3; ++j) {
+      if (std::find(new_cache, new_cache + new_count, triangle[j]) ==
+          new_cache + new_count)
+        new_cache[new_count++] = triangle[j];
+    }
+    for (int32_t j = 0; j < cache_count; ++j) {
+      if (std::find(new_cache, new_cache + new_count, cache[j]) ==
+          new_cache + new_count)
+        new_cache[new_count++] = cache[j];
+    }
+
+    //Rescore vertices that moved, including the evicted ones, then the
+    //triangles using them
+    for (int32_t j = 0; j < new_count; ++j) {
+      uint32_t v = new_cache[j];
+      cache_positions[v] = j < FORSYTH_CACHE_SIZE ? j : -1;
+      vertex_scores[v] =
+          ForsythVertexScore(cache_positions[v], adjacency.counts[v]);
+    }
+    best = NO_TRIANGLE;
+    best_score = -1.f;
+    for (int32_t j = 0; j < new_count; ++j) {
+      uint32_t v = new_cache[j];
+      const uint32_t *list = &adjacency.triangles[adjacency.offsets[v]];
+      for (uint32_t k = 0; k < adjacency.counts[v]; ++k) {
+        uint32_t t = list[k];
+        triangle_scores[t] = vertex_scores[in[t * 3]] +
+                             vertex_scores[in[t * 3 + 1]] +
+                             vertex_scores[in[t * 3 + 2]];
+        if (triangle_scores[t] > best_score) {
+          best = t;
+          best_score = triangle_scores[t];
+        }
+      }
+    }
+
+    cache_count = std::min(new_count, FORSYTH_CACHE_SIZE);
+    memcpy(cache, new_cache, cache_count * sizeof(uint32_t));
+  }
+}
+
+void OptimizeVertexCacheTipsify(uint32_t *out, const uint32_t *in,
+                                const size_t num_indices,
+                                const uint32_t num_vertices,
+                                const int32_t cache_size) {
+  const uint32_t num_triangles = (uint32_t)(num_indices / 3);
+  Adjacency adjacency(in, num_indices, num_vertices);
+
+  std::vector<uint32_t> timestamps(num_vertices, 0);
+  std::vector<bool> emitted(num_triangles, false);
+  std::vector<uint32_t> dead_ends;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> fan_triangles;
+  uint32_t time = cache_size + 1;
+  uint32_t cursor = 0;
+  uint32_t num_emitted = 0;
+
+  //Start at the first vertex with triangles
+  while (cursor < num_vertices && adjacency.counts[cursor] == 0)
+    ++cursor;
+  uint32_t fan = cursor;
+
+  while (fan < num_vertices) {
+    //Emit all remaining triangles around the fanning vertex
+    candidates.clear();
+    const uint32_t *list = &adjacency.triangles[adjacency.offsets[fan]];
+    fan_triangles.assign(list, list + adjacency.counts[fan]);
+    for (size_t i = 0; i < fan_triangles.size(); ++i) {
+      uint32_t t = fan_triangles[i];
+      if (emitted[t])
+        continue;
+      emitted[t] = true;
+      for (int32_t j = 0; j < 3; ++j) {
+        uint32_t v = in[t * 3 + j];
+        out[num_emitted * 3 + j] = v;
+        dead_ends.push_back(v);
+        candidates.push_back(v);
+        adjacency.Remove(v, t);
+        if (time - timestamps[v] > (uint32_t)cache_size)
+          timestamps[v] = time++;
+      }
+      ++num_emitted;
+    }
+
+    //Next fanning vertex: the 1-ring vertex that stays in the cache the
+    //longest while its triangles are emitted
+    uint32_t next = num_vertices;
+    int32_t best_priority = -1;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      uint32_t v = candidates[i];
+      if (adjacency.counts[v] == 0)
+        continue;
+      int32_t priority = 0;
+      if (time - timestamps[v] + 2 * adjacency.counts[v] <= (uint32_t)cache_size)
+        priority = time - timestamps[v];
+      if (priority > best_priority) {
+        best_priority = priority;
+        next = v;
+      }
+    }
+
+    if (next == num_vertices) {
+      //Dead end, back up to a recently used vertex, else the next vertex in
+      //input order
+      while (!dead_ends.empty() && next == num_vertices) {
+        uint32_t v = dead_ends.back();
+        dead_ends.pop_back();
+        if (adjacency.counts[v])
+          next = v;
+      }
+      while (next == num_vertices && cursor < num_vertices) {
+        if (adjacency.counts[cursor])
+          next = cursor;
+        else
+          ++cursor;
+      }
+    }
+    fan = next;
+  }
+}
+
+void OptimizeOverdraw(uint32_t *out, const uint32_t *in,
+                      const size_t num_indices, const float *positions,
+                      const size_t position_stride,
+                      const uint32_t num_vertices, const int32_t cache_size,
+                      const float threshold) {
+  const uint32_t num_triangles = (uint32_t)(num_indices / 3);
+  //Hard boundaries, the cache is cold there anyway so moving the cluster
+  //costs nothing
+  std::vector<uint32_t> clusters;
+  FifoCache cache(num_vertices, cache_size);
+  for (uint32_t t = 0; t < num_triangles; ++t) {
+    int32_t misses = cache.Access(in[t * 3]) + cache.Access(in[t * 3 + 1]) +
+                     cache.Access(in[t * 3 + 2]);
+    if (t == 0 || misses == 3)
+      clusters.push_back(t);
+  }
+
+  //Soft boundaries, wherever a cluster started cold has reached the miss
+  //ratio of its hard cluster times threshold
+  std::vector<uint32_t> splits;
+  for (size_t c = 0; c < clusters.size(); ++c) {
+    uint32_t begin = clusters[c];
+    uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : num_triangles;
+    uint32_t misses = 0;
+    cache.Flush();
+    for (uint32_t t = begin; t < end; ++t) {
+      for (int32_t j = 0; j < 3; ++j)
+        misses += cache.Access(in[t * 3 + j]);
+    }
+    float cluster_threshold = threshold * misses / (end - begin);
+
+    splits.push_back(begin);
+    uint32_t start = begin;
+    misses = 0;
+    cache.Flush();
+    for (uint32_t t = begin; t < end; ++t) {
+      for (int32_t j = 0; j < 3; ++j)
+        misses += cache.Access(in[t * 3 + j]);
+      if (misses <= cluster_threshold * (t - start + 1)) {
+        start = t + 1;
+        misses = 0;
+        splits.push_back(start);
+        cache.Flush();
+      }
+    }
+    //The remainder didn't reach the target, it stays with the previous split
+    if (splits.back() != begin)
+      splits.pop_back();
+  }
+  //Area weighted centroid and normal of the mesh and each cluster
+  struct Cluster {
+    uint32_t begin;
+    uint32_t end;
+    float sort_key;
+  };
+  std::vector<Cluster> sorted(splits.size());
+  std::vector<float> centroids(splits.size() * 3, 0.f);
+  std::vector<float> normals(splits.size() * 3, 0.f);
+  float mesh_centroid[3] = { 0.f, 0.f, 0.f };
+  float mesh_area = 0.f;
+  for (size_t c = 0; c < splits.size(); ++c) {
+    sorted[c].begin = splits[c];
+    sorted[c].end = c + 1 < splits.size() ? splits[c + 1] : num_triangles;
+    float area = 0.f;
+    for (uint32_t t = sorted[c].begin; t < sorted[c].end; ++t) {
+      const float *p0 = &positions[in[t * 3] * position_stride];
+      const float *p1 = &positions[in[t * 3 + 1] * position_stride];
+      const float *p2 = &positions[in[t * 3 + 2] * position_stride];
+      float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      float n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                     e1[2] * e2[0] - e1[0] * e2[2],
+                     e1[0] * e2[1] - e1[1] * e2[0] };
+      float a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int32_t j = 0; j < 3; ++j) {
+        centroids[c * 3 + j] += (p0[j] + p1[j] + p2[j]) * a / 3.f;
+        normals[c * 3 + j] += n[j];
+      }
+      area += a;
+    }
+    for (int32_t j = 0; j < 3; ++j) {
+      mesh_centroid[j] += centroids[c * 3 + j];
+      if (area > 0.f)
+        centroids[c * 3 + j] /= area;
+    }
+    mesh_area += area;
+  }
+  for (int32_t j = 0; j < 3; ++j) {
+    if (mesh_area > 0.f)
+      mesh_centroid[j] /= mesh_area;
+  }
+
+  //Clusters far out along their normal occlude the rest from most views
+  for (size_t c = 0; c < sorted.size(); ++c) {
+    const float *n = &normals[c * 3];
+    float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    float key = 0.f;
+    for (int32_t j = 0; j < 3; ++j)
+      key += (centroids[c * 3 + j] - mesh_centroid[j]) * n[j];
+    sorted[c].sort_key = len > 0.f ? key / len : 0.f;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Cluster &a, const Cluster &b) {
+    return a.sort_key > b.sort_key;
+  });
+
+  uint32_t *p = out;
+  for (size_t c = 0; c < sorted.size(); ++c) {
+    size_t count = (sorted[c].end - sorted[c].begin) * 3;
+    memcpy(p, &in[sorted[c].begin * 3], count * sizeof(uint32_t));
+    p += count;
+  }
+}
+
+uint32_t BuildVertexFetchRemap(uint32_t *remap, const uint32_t *indices,
+                               const size_t num_indices,
+                               const uint32_t num_vertices) {
+  std::fill(remap, remap + num_vertices, NO_VERTEX);
+  uint32_t next = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    if (remap[indices[i]] == NO_VERTEX)
+      remap[indices[i]] = next++;
+  }
+  return next;
+}
+
+void RemapIndices(uint32_t *indices, const size_t num_indices,
+                  const uint32_t *remap) {
+  for (size_t i = 0; i < num_indices; ++i)
+    indices[i] = remap[indices[i]];
+}
+
+void RemapVertices(void *out, const void *in, const uint32_t num_vertices,
+                   const size_t vertex_size, const uint32_t *remap) {
+  const uint8_t *src = static_cast<const uint8_t *>(in);
+  uint8_t *dst = static_cast<uint8_t *>(out);
+  for (uint32_t v = 0; v < num_vertices; ++v) {
+    if (remap[v] != NO_VERTEX)
+      memcpy(dst + remap[v] * vertex_size, src + v * vertex_size, vertex_size);
+  }
+}
+
+} //namespace mesh_optimizer
+
+}      //namespace ndk_helper
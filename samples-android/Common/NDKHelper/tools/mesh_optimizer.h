@@ -0,0 +1,107 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ndk_helper {
+
+namespace mesh_optimizer {
+
+/******************************************************************
+ * Offline index/vertex buffer optimisation for triangle lists
+ * namespace: ndk_helper::mesh_optimizer
+ *
+ * Typical order:
+ *   OptimizeVertexCacheForsyth() or OptimizeVertexCacheTipsify()
+ *   OptimizeOverdraw() (optional)
+ *   BuildVertexFetchRemap(), RemapIndices(), RemapVertices()
+ *
+ * Reordering functions write to out, which must not alias in.
+ */
+
+//Post transform cache size most mobile GPUs behave like, in vertices
+const int32_t DEFAULT_CACHE_SIZE = 16;
+
+struct CacheStatistics {
+  float acmr; //Average cache miss ratio, transformed vertices per triangle
+  float atvr; //Average transform to vertex ratio, 1.0 is optimal
+};
+
+//Simulates a FIFO post transform cache of cache_size vertices
+CacheStatistics AnalyzeVertexCache(const uint32_t *indices,
+                                   const size_t num_indices,
+                                   const uint32_t num_vertices,
+                                   const int32_t cache_size);
+
+/******************************************************************
+ * Forsyth, "Linear-Speed Vertex Cache Optimisation"
+ * Greedy triangle order from an LRU cache scoring model; good results over a
+ * wide range of cache sizes, so the output doesn't depend on a cache size.
+ */
+void OptimizeVertexCacheForsyth(uint32_t *out, const uint32_t *in,
+                                const size_t num_indices,
+                                const uint32_t num_vertices);
+
+/******************************************************************
+ * Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and
+ * Reduced Overdraw" (Tipsify)
+ * Fans triangles around vertices, tuned for a FIFO cache of cache_size.
+ */
+void OptimizeVertexCacheTipsify(uint32_t *out, const uint32_t *in,
+                                const size_t num_indices,
+                                const uint32_t num_vertices,
+                                const int32_t cache_size);
+
+/******************************************************************
+ * Cluster order for less overdraw, from the same paper
+ * in is cut into clusters where the simulated cache runs cold (all 3 vertices
+ * of a triangle miss), and further where the miss ratio of a cluster stays
+ * within threshold times the one of the whole mesh (1.05 gives up 5%).
+ * Clusters facing away from the mesh center, which tend to occlude the others
+ * from any view point, are then drawn first.
+ * in should already be in vertex cache order, ideally Tipsify's.
+ * positions are xyz triplets, position_stride floats apart.
+ */
+void OptimizeOverdraw(uint32_t *out, const uint32_t *in,
+                      const size_t num_indices, const float *positions,
+                      const size_t position_stride,
+                      const uint32_t num_vertices, const int32_t cache_size,
+                      const float threshold);
+
+/******************************************************************
+ * Vertex fetch order
+ * Numbers vertices in order of first use so vertex fetches walk memory
+ * linearly. remap[old] receives the new index, or NO_VERTEX for vertices no
+ * triangle uses, which are dropped. Returns the number of vertices left.
+ */
+const uint32_t NO_VERTEX = 0xffffffff;
+
+uint32_t BuildVertexFetchRemap(uint32_t *remap, const uint32_t *indices,
+                               const size_t num_indices,
+                               const uint32_t num_vertices);
+void RemapIndices(uint32_t *indices, const size_t num_indices,
+                  const uint32_t *remap);
+void RemapVertices(void *out, const void *in, const uint32_t num_vertices,
+                   const size_t vertex_size, const uint32_t *remap);
+
+} //namespace mesh_optimizer
+
+}      //namespace ndk_helper
+#endif /* MESH_OPTIMIZER_H_ */
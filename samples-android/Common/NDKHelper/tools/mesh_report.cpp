@@ -0,0 +1,141 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh_report.cpp
+// Vertex cache statistics of baked meshes, as stored and after each triangle
+// order mesh_baker can apply
+//--------------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "mesh.h"
+#include "mesh_optimizer.h"
+#include "vecmath_packing.h"
+
+namespace {
+
+using namespace ndk_helper;
+
+const int32_t CACHE_SIZES[] = { 8, 16, 24, 32 };
+const int32_t NUM_CACHE_SIZES = sizeof(CACHE_SIZES) / sizeof(CACHE_SIZES[0]);
+
+void PrintRow(const char *label, const std::vector<uint32_t> &indices,
+              const uint32_t num_vertices) {
+  printf("  %-10s", label);
+  for (int32_t i = 0; i < NUM_CACHE_SIZES; ++i) {
+    mesh_optimizer::CacheStatistics statistics =
+        mesh_optimizer::AnalyzeVertexCache(&indices[0], indices.size(),
+                                           num_vertices, CACHE_SIZES[i]);
+    printf("  %5.3f %5.3f", statistics.acmr, statistics.atvr);
+  }
+  printf("\n");
+}
+
+//Positions as floats, whatever the mesh stores
+bool ReadPositions(const Mesh &mesh, std::vector<float> *positions) {
+  const MeshAttribute *attribute = mesh.FindAttribute(MESH_SEMANTIC_POSITION);
+  if (attribute == NULL)
+    return false;
+
+  const MeshHeader &header = mesh.GetHeader();
+  const uint8_t *vertices = static_cast<const uint8_t *>(mesh.GetVertexData());
+  positions->resize(header.num_vertices * 3);
+  for (uint32_t v = 0; v < header.num_vertices; ++v) {
+    const uint8_t *p = vertices + v * header.vertex_stride + attribute->offset;
+    for (int32_t j = 0; j < 3; ++j) {
+      if (attribute->format == MESH_FORMAT_FLOAT3) {
+        memcpy(&(*positions)[v * 3 + j], p + j * sizeof(float), sizeof(float));
+      } else if (attribute->format == MESH_FORMAT_HALF4) {
+        uint16_t h;
+        memcpy(&h, p + j * sizeof(uint16_t), sizeof(uint16_t));
+        (*positions)[v * 3 + j] = packing::HalfToFloat(h);
+      } else {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool Report(const char *file_name) {
+  Mesh mesh;
+  if (!mesh.Open(file_name))
+    return false;
+
+  const MeshHeader &header = mesh.GetHeader();
+  const MeshLod &lod = header.lods[0];
+  std::vector<uint32_t> indices(lod.num_indices);
+  if (header.index_type == MESH_INDEX_TYPE_UINT16) {
+    const uint16_t *data = static_cast<const uint16_t *>(mesh.GetIndexData());
+    indices.assign(data + lod.first_index,
+                   data + lod.first_index + lod.num_indices);
+  } else {
+    const uint32_t *data = static_cast<const uint32_t *>(mesh.GetIndexData());
+    indices.assign(data + lod.first_index,
+                   data + lod.first_index + lod.num_indices);
+  }
+  if (indices.empty())
+    return false;
+  const uint32_t num_vertices = header.num_vertices;
+
+  printf("%s: %u vertices, %u triangles\n", file_name, num_vertices,
+         (uint32_t)indices.size() / 3);
+  printf("  %-10s", "FIFO size");
+  for (int32_t i = 0; i < NUM_CACHE_SIZES; ++i)
+    printf("  %2d ACMR ATVR ", CACHE_SIZES[i]);
+  printf("\n");
+  PrintRow("as stored", indices, num_vertices);
+
+  std::vector<uint32_t> forsyth(indices.size());
+  mesh_optimizer::OptimizeVertexCacheForsyth(&forsyth[0], &indices[0],
+                                             indices.size(), num_vertices);
+  PrintRow("forsyth", forsyth, num_vertices);
+
+  std::vector<uint32_t> tipsify(indices.size());
+  mesh_optimizer::OptimizeVertexCacheTipsify(
+      &tipsify[0], &indices[0], indices.size(), num_vertices,
+      mesh_optimizer::DEFAULT_CACHE_SIZE);
+  PrintRow("tipsify", tipsify, num_vertices);
+
+  std::vector<float> positions;
+  if (ReadPositions(mesh, &positions)) {
+    std::vector<uint32_t> overdraw(indices.size());
+    mesh_optimizer::OptimizeOverdraw(&overdraw[0], &tipsify[0], indices.size(),
+                                     &positions[0], 3, num_vertices,
+                                     mesh_optimizer::DEFAULT_CACHE_SIZE, 1.05f);
+    PrintRow("overdraw", overdraw, num_vertices);
+  }
+  return true;
+}
+
+} //namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printf("usage: %s MESH...\n", argv[0]);
+    return 1;
+  }
+
+  int ret = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (!Report(argv[i]))
+      ret = 1;
+  }
+  return ret;
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//--------------------------------------------------------------------------------
+// mesh_simplifier.cpp
+//--------------------------------------------------------------------------------
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "mesh_simplifier.h"
+
+namespace ndk_helper {
+
+namespace {
+
+//Border constraint planes weigh this much more than surface planes, so open
+//borders stay where they are
+const double BORDER_WEIGHT = 10.0;
+
+//A pass only applies collapses up to this factor above the error of the one
+//that would reach the target, later ones are re-evaluated in the next pass
+const float PASS_ERROR_SLACK = 1.5f;
+
+uint64_t EdgeKey(const uint32_t a, const uint32_t b) {
+  return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+void Cross(const float *a, const float *b, const float *c, double *n) {
+  double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1],
+                   (double)b[2] - a[2] };
+  double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1],
+                   (double)c[2] - a[2] };
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+double Length(const double *v) {
+  return sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+} //namespace
+
+void MeshSimplifier::Quadric::Clear() { memset(a, 0, sizeof(a)); }
+
+void MeshSimplifier::Quadric::AddPlane(const double *plane,
+                                       const double weight) {
+  //Outer product of (a, b, c, d) with itself
+  int32_t k = 0;
+  for (int32_t i = 0; i < 4; ++i) {
+    for (int32_t j = i; j < 4; ++j)
+      a[k++] += plane[i] * plane[j] * weight;
+  }
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric &rhs) {
+  for (int32_t i = 0; i < 10; ++i)
+    a[i] += rhs.a[i];
+}
+
+double MeshSimplifier::Quadric::Evaluate(const float *p) const {
+  //v^T Q v with v = (x, y, z, 1)
+  double x = p[0], y = p[1], z = p[2];
+  return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z +
+         2.0 * a[3] * x + a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y +
+         a[7] * z * z + 2.0 * a[8] * z + a[9];
+}
+
+MeshSimplifier::MeshSimplifier(const float *positions,
+                               const size_t position_stride,
+                               const uint32_t num_vertices,
+                               const uint32_t *indices,
+                               const size_t num_indices)
+    : positions_(positions), position_stride_(position_stride),
+      quadrics_(num_vertices), weights_(num_vertices, 0.0),
+      border_(num_vertices, false), error_(0.f) {
+  //Weld vertices at the same position onto the first of them
+  std::vector<uint32_t> order(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; ++v)
+    order[v] = v;
+  std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    int32_t c = memcmp(GetPosition(a), GetPosition(b), 3 * sizeof(float));
+    return c < 0 || (c == 0 && a < b);
+  });
+  std::vector<uint32_t> weld(num_vertices);
+  for (uint32_t i = 0; i < num_vertices; ++i) {
+    uint32_t v = order[i];
+    bool same = i > 0 && memcmp(GetPosition(v), GetPosition(order[i - 1]),
+                                3 * sizeof(float)) == 0;
+    weld[v] = same ? weld[order[i - 1]] : v;
+  }
+
+  indices_.reserve(num_indices);
+  for (size_t i = 0; i + 2 < num_indices; i += 3) {
+    uint32_t a = weld[indices[i]], b = weld[indices[i + 1]],
+             c = weld[indices[i + 2]];
+    if (a != b && b != c && c != a) {
+      indices_.push_back(a);
+      indices_.push_back(b);
+      indices_.push_back(c);
+    }
+  }
+
+  //Area weighted face planes
+  for (size_t i = 0; i < quadrics_.size(); ++i)
+    quadrics_[i].Clear();
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    const float *p0 = GetPosition(indices_[i]);
+    double n[3];
+    Cross(p0, GetPosition(indices_[i + 1]), GetPosition(indices_[i + 2]), n);
+    double len = Length(n);
+    if (len == 0.0)
+      continue;
+    double plane[4] = { n[0] / len, n[1] / len, n[2] / len, 0.0 };
+    plane[3] = -(plane[0] * p0[0] + plane[1] * p0[1] + plane[2] * p0[2]);
+    for (int32_t j = 0; j < 3; ++j) {
+      quadrics_[indices_[i + j]].AddPlane(plane, len * 0.5);
+      weights_[indices_[i + j]] += len * 0.5;
+    }
+  }
+
+  //Edges used by a single triangle are borders, constrain them with planes
+  //perpendicular to the face
+  std::vector<uint64_t> edges;
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    for (int32_t j = 0; j < 3; ++j)
+      edges.push_back(EdgeKey(indices_[i + j], indices_[i + (j + 1) % 3]));
+  }
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    double n[3];
+    Cross(GetPosition(indices_[i]), GetPosition(indices_[i + 1]),
+          GetPosition(indices_[i + 2]), n);
+    for (int32_t j = 0; j < 3; ++j) {
+      uint32_t a = indices_[i + j], b = indices_[i + (j + 1) % 3];
+      uint64_t key = EdgeKey(a, b);
+      if (std::upper_bound(edges.begin(), edges.end(), key) -
+              std::lower_bound(edges.begin(), edges.end(), key) != 1)
+        continue;
+
+      const float *pa = GetPosition(a);
+      const float *pb = GetPosition(b);
+      double e[3] = { (double)pb[0] - pa[0], (double)pb[1] - pa[1],
+                      (double)pb[2] - pa[2] };
+      double p[3] = { e[1] * n[2] - e[2] * n[1], e[2] * n[0] - e[0] * n[2],
+                      e[0] * n[1] - e[1] * n[0] };
+      double len = Length(p);
+      if (len == 0.0)
+        continue;
+      double plane[4] = { p[0] / len, p[1] / len, p[2] / len, 0.0 };
+      plane[3] = -(plane[0] * pa[0] + plane[1] * pa[1] + plane[2] * pa[2]);
+      double weight = BORDER_WEIGHT * Length(e) * Length(e);
+      quadrics_[a].AddPlane(plane, weight);
+      quadrics_[b].AddPlane(plane, weight);
+      border_[a] = border_[b] = true;
+    }
+  }
+}
+
+float MeshSimplifier::CollapseError(const uint32_t from,
+                                    const uint32_t to) const {
+  Quadric q = quadrics_[from];
+  q.Add(quadrics_[to]);
+  double weight = weights_[from] + weights_[to];
+  double cost = std::max(q.Evaluate(GetPosition(to)), 0.0);
+  return weight > 0.0 ? (float)sqrt(cost / weight) : 0.f;
+}
+
+bool MeshSimplifier::Flips(const uint32_t from, const uint32_t to,
+                           const std::vector<uint32_t> &offsets,
+                           const std::vector<uint32_t> &triangles) const {
+  for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+    const uint32_t *triangle = &indices_[triangles[i] * 3];
+    if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+      continue; //Removed by the collapse
+
+    const float *p[3];
+    const float *q[3];
+    for (int32_t j = 0; j < 3; ++j) {
+      p[j] = GetPosition(triangle[j]);
+      q[j] = GetPosition(triangle[j] == from ? to : triangle[j]);
+    }
+    double n0[3], n1[3];
+    Cross(p[0], p[1], p[2], n0);
+    Cross(q[0], q[1], q[2], n1);
+    if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0)
+      return true;
+  }
+  return false;
+}
+
+size_t MeshSimplifier::CollapsePass(const size_t target_indices) {
+  const uint32_t num_vertices = (uint32_t)quadrics_.size();
+
+  //Cheapest direction of every edge. Border vertices only move along borders
+  std::vector<uint64_t> edges;
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    for (int32_t j = 0; j < 3; ++j)
+      edges.push_back(EdgeKey(indices_[i + j], indices_[i + (j + 1) % 3]));
+  }
+  std::sort(edges.begin(), edges.end());
+  std::vector<Collapse> collapses;
+  for (size_t i = 0; i < edges.size();) {
+    size_t count = 1;
+    while (i + count < edges.size() && edges[i + count] == edges[i])
+      ++count;
+    uint32_t a = (uint32_t)(edges[i] >> 32);
+    uint32_t b = (uint32_t)edges[i];
+    bool border_edge = count == 1;
+    i += count;
+
+    Collapse collapse = { a, b, 0.f };
+    bool a_to_b = !border_[a] || (border_edge && border_[b]);
+    bool b_to_a = !border_[b] || (border_edge && border_[a]);
+    if (a_to_b && b_to_a) {
+      float ab = CollapseError(a, b);
+      float ba = CollapseError(b, a);
+      if (ba < ab) {
+        collapse.from = b;
+        collapse.to = a;
+      }
+      collapse.error = std::min(ab, ba);
+    } else if (a_to_b) {
+      collapse.error = CollapseError(a, b);
+    } else if (b_to_a) {
+      collapse.from = b;
+      collapse.to = a;
+      collapse.error = CollapseError(b, a);
+    } else {
+      continue;
+    }
+    collapses.push_back(collapse);
+  }
+  if (collapses.empty())
+    return 0;
+  std::sort(collapses.begin(), collapses.end());
+
+  //Each collapse removes about 2 triangles
+  size_t num_triangles = indices_.size() / 3;
+  size_t target_triangles = target_indices / 3;
+  size_t goal = std::min((num_triangles - target_triangles) / 2 + 1,
+                         collapses.size());
+  float error_limit = collapses[goal - 1].error * PASS_ERROR_SLACK;
+
+  //Triangles around each vertex
+  std::vector<uint32_t> offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < indices_.size(); ++i)
+    ++offsets[indices_[i] + 1];
+  for (uint32_t v = 0; v < num_vertices; ++v)
+    offsets[v + 1] += offsets[v];
+  std::vector<uint32_t> triangles(indices_.size());
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < indices_.size(); ++i)
+    triangles[fill[indices_[i]]++] = (uint32_t)(i / 3);
+
+  //Collapses in a pass must not touch each other's triangles, the flip
+  //test would use stale data
+  std::vector<uint32_t> remap(num_vertices);
+  for (uint32_t v = 0; v < num_vertices; ++v)
+    remap[v] = v;
+  std::vector<bool> locked(num_vertices, false);
+  size_t num_collapses = 0;
+  for (size_t i = 0; i < collapses.size(); ++i) {
+    const Collapse &collapse = collapses[i];
+    if (num_triangles <= target_triangles || collapse.error > error_limit)
+      break;
+    if (locked[collapse.from] || locked[collapse.to] ||
+        Flips(collapse.from, collapse.to, offsets, triangles))
+      continue;
+
+    for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1];
+         ++j) {
+      const uint32_t *triangle = &indices_[triangles[j] * 3];
+      if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+          triangle[2] == collapse.to)
+        --num_triangles;
+      for (int32_t k = 0; k < 3; ++k)
+        locked[triangle[k]] = true;
+    }
+    remap[collapse.from] = collapse.to;
+    quadrics_[collapse.to].Add(quadrics_[collapse.from]);
+    weights_[collapse.to] += weights_[collapse.from];
+    error_ = std::max(error_, collapse.error);
+    ++num_collapses;
+  }
+
+  //Drop the triangles that became degenerate
+  size_t out = 0;
+  for (size_t i = 0; i < indices_.size(); i += 3) {
+    uint32_t a = remap[indices_[i]], b = remap[indices_[i + 1]],
+             c = remap[indices_[i + 2]];
+    if (a != b && b != c && c != a) {
+      indices_[out++] = a;
+      indices_[out++] = b;
+      indices_[out++] = c;
+    }
+  }
+  indices_.resize(out);
+  return num_collapses;
+}
+
+size_t MeshSimplifier::Simplify(const size_t target_indices) {
+  while (indices_.size() > target_indices) {
+    if (CollapsePass(target_indices) == 0)
+      break;
+  }
+  return indices_.size();
+}
+
+}      //namespace ndk_helper
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace ndk_helper {
+
+/******************************************************************
+ * Quadric error metric simplification
+ * Garland, Heckbert, "Surface Simplification Using Quadric Error Metrics"
+ *
+ * Edges are collapsed onto one of their end points (half edge collapses), so
+ * every level of detail indexes the original vertex buffer and a LOD chain
+ * only costs index data. Vertices at the same position are welded first so
+ * attribute seams don't open up; coarse levels use the attributes of the
+ * first vertex at each position. Open borders are kept in place by
+ * constraint planes and may only collapse along the border.
+ *
+ * Simplify() can be called repeatedly with decreasing targets, each call
+ * continues from the previous result and keeps its quadrics, which gives a
+ * consistent LOD chain.
+ */
+class MeshSimplifier {
+private:
+  struct Quadric {
+    double a[10]; //Upper triangle of the symmetric 4x4 matrix
+
+    void Clear();
+    void AddPlane(const double *plane, const double weight);
+    void Add(const Quadric &rhs);
+    double Evaluate(const float *p) const;
+  };
+
+  struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float error;
+
+    bool operator<(const Collapse &rhs) const { return error < rhs.error; }
+  };
+
+  const float *positions_;
+  size_t position_stride_;
+  std::vector<uint32_t> indices_;
+  std::vector<Quadric> quadrics_;
+  std::vector<double> weights_;
+  std::vector<bool> border_;
+  float error_;
+
+  const float *GetPosition(const uint32_t v) const {
+    return positions_ + v * position_stride_;
+  }
+  float CollapseError(const uint32_t from, const uint32_t to) const;
+  bool Flips(const uint32_t from, const uint32_t to,
+             const std::vector<uint32_t> &offsets,
+             const std::vector<uint32_t> &triangles) const;
+  size_t CollapsePass(const size_t target_indices);
+
+public:
+  //positions are xyz triplets, position_stride floats apart, and must stay
+  //valid while the simplifier is used
+  MeshSimplifier(const float *positions, const size_t position_stride,
+                 const uint32_t num_vertices, const uint32_t *indices,
+                 const size_t num_indices);
+
+  //Collapses edges until no more than target_indices indices are left or no
+  //edge can be collapsed without flipping triangles. Returns the index count
+  size_t Simplify(const size_t target_indices);
+
+  const std::vector<uint32_t> &GetIndices() const { return indices_; }
+
+  //Largest object space distance error of the collapses so far
+  float GetError() const { return error_; }
+};
+
+}      //namespace ndk_helper
+#endif /* MESH_SIMPLIFIER_H_ */
@@ -21,19 +21,86 @@
 //--------------------------------------------------------------------------------
 // Include files
 //--------------------------------------------------------------------------------
+#include <string.h>
+
+#include <algorithm>
+
 #include "TeapotRenderer.h"
 
 //--------------------------------------------------------------------------------
-// Teapot model data
+// Constant transforms, folded at compile time
 //--------------------------------------------------------------------------------
-#include "teapot.inl"
+namespace
+{
+constexpr float CAM_X = 0.f;
+constexpr float CAM_Y = 0.f;
+constexpr float CAM_Z = 700.f;
+
+//Same as Mat4::LookAt( Vec3( CAM_X, CAM_Y, CAM_Z ), Vec3( 0.f, 0.f, 0.f ),
+//Vec3( 0.f, 1.f, 0.f ) ), the camera looks down -Z so only the translation is left
+constexpr ndk_helper::Mat4 MAT_CAMERA_VIEW = ndk_helper::Mat4::Translation( -CAM_X,
+        -CAM_Y, -CAM_Z );
+
+//Stress mode teapots sit on a cubic grid around the original one
+const float INSTANCE_SPACING = 100.f;
+
+const float CAM_NEAR = 5.f;
+const float CAM_FAR = 10000.f;
+
+//A LOD is used while its simplification error covers less than a pixel. A
+//coarser LOD is only picked once its error is below LOD_HYSTERESIS times that,
+//so teapots near a threshold don't flip between LODs every frame
+const float LOD_PIXEL_ERROR = 1.f;
+const float LOD_HYSTERESIS = 0.75f;
+
+const TEAPOT_MATERIALS MATERIAL = { { 1.0f, 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 10.f }, {
+        0.1f, 0.1f, 0.1f }, };
+
+//Teapot programs of the ShaderLibrary, indexed by TEAPOT_SHADER_OPTIONS bits,
+//SHADER_ATTRIBUTES, SHADER_UNIFORMS and UNIFORM_BINDINGS
+const char* const SHADER_OPTION_NAMES[] = { "OCTAHEDRAL_NORMAL", "INSTANCING" };
+const ndk_helper::ProgramAttribute SHADER_ATTRIBUTE_NAMES[] = {
+        { ATTRIB_VERTEX, "myVertex" },
+        { ATTRIB_NORMAL, "myNormal" },
+        { ATTRIB_UV, "myUV" },
+        { ATTRIB_INSTANCE_MODEL, "myInstanceModel" },
+        { ATTRIB_INSTANCE_DIFFUSE, "myInstanceDiffuse" } };
+const char* const SHADER_UNIFORM_NAMES[UNIFORM_COUNT] = { "uPMatrix", "uMVMatrix", "vLight0",
+        "vMaterialDiffuse", "vMaterialAmbient", "vMaterialSpecular" };
+const char* const UNIFORM_BLOCK_NAMES[UNIFORM_BINDING_COUNT] = { "FrameConstants",
+        "ObjectConstants", "MaterialConstants" };
+
+const int32_t NUM_SHADER_OPTIONS = sizeof(SHADER_OPTION_NAMES) / sizeof(SHADER_OPTION_NAMES[0]);
+const int32_t NUM_SHADER_ATTRIBUTES = sizeof(SHADER_ATTRIBUTE_NAMES)
+        / sizeof(SHADER_ATTRIBUTE_NAMES[0]);
+
+//ES2 with glUniform calls
+const ndk_helper::ShaderProgramDesc PROGRAM_PLAIN = { "Shaders/VS_ShaderPlain.vsh",
+        "Shaders/ShaderPlain.fsh", SHADER_OPTION_NAMES, NUM_SHADER_OPTIONS,
+        SHADER_ATTRIBUTE_NAMES, NUM_SHADER_ATTRIBUTES, SHADER_UNIFORM_NAMES, UNIFORM_COUNT,
+        NULL, 0 };
+//ES3 with uniform blocks
+const ndk_helper::ShaderProgramDesc PROGRAM_PLAIN_ES3 = { "Shaders/VS_ShaderPlainES3.vsh",
+        "Shaders/ShaderPlainES3.fsh", SHADER_OPTION_NAMES, NUM_SHADER_OPTIONS,
+        SHADER_ATTRIBUTE_NAMES, NUM_SHADER_ATTRIBUTES, SHADER_UNIFORM_NAMES, UNIFORM_COUNT,
+        UNIFORM_BLOCK_NAMES, UNIFORM_BINDING_COUNT };
+}
 
 //--------------------------------------------------------------------------------
 // Ctor
 //--------------------------------------------------------------------------------
-TeapotRenderer::TeapotRenderer()
+TeapotRenderer::TeapotRenderer() :
+                ibo_( 0 ),
+                vbo_( 0 ),
+                lod_( 0 ),
+                lod_scale_( 0.f ),
+                instance_vbo_( 0 ),
+                num_triangles_( 0 ),
+                state_( NULL ),
+                uniform_buffers_( false ),
+                camera_( NULL )
 {
-
+    shader_ = ndk_helper::SHADER_HANDLE_INVALID;
 }
 
 //--------------------------------------------------------------------------------
@@ -44,45 +111,106 @@ TeapotRenderer::~TeapotRenderer()
     Unload();
 }
 
-void TeapotRenderer::Init()
+void TeapotRenderer::Init( const TEAPOT_VERTEX_LAYOUT layout, const int32_t num_instances,
+        const bool instancing )
 {
     //Settings
-    glFrontFace( GL_CCW );
-
-    //Load shader
-    LoadShaders( &shader_param_, "Shaders/VS_ShaderPlain.vsh",
-            "Shaders/ShaderPlain.fsh" );
-
-    //Create Index buffer
-    num_indices_ = sizeof(teapotIndices) / sizeof(teapotIndices[0]);
+    ndk_helper::GLContext* context = ndk_helper::GLContext::GetInstance();
+    state_ = context->GetState();
+    state_->FrontFace( GL_CCW );
+
+    //Half float attributes are core in ES3, an extension in ES2
+    half_float_type_ = GL_FLOAT;
+    if( context->GetGLVersion() >= 3.0f )
+        half_float_type_ = GL_HALF_FLOAT;
+    else if( context->CheckExtension( "GL_OES_vertex_half_float" ) )
+        half_float_type_ = GL_HALF_FLOAT_OES;
+
+    //Load the baked mesh, mapped from the APK without a copy. Triangles and
+    //vertices are already in vertex cache and overdraw order, see mesh_baker
+    const char* mesh_file = "Meshes/teapot.mesh";
+    if( layout == TEAPOT_VERTEX_LAYOUT_PACKED )
+    {
+        if( half_float_type_ != GL_FLOAT )
+            mesh_file = "Meshes/teapot_packed.mesh";
+        else
+            LOGI( "Half float vertices not supported, using the float layout" );
+    }
+    ndk_helper::Mesh mesh;
+    if( !mesh.Open( mesh_file ) || !GetAttribute( mesh, ndk_helper::MESH_SEMANTIC_POSITION,
+            &position_ ) || !GetAttribute( mesh, ndk_helper::MESH_SEMANTIC_NORMAL, &normal_ ) )
+    {
+        LOGI( "Failed to load %s", mesh_file );
+        return;
+    }
+    const ndk_helper::MeshHeader& header = mesh.GetHeader();
+
+    //Instanced drawing and uniform buffers are core in ES3, ES2 falls back to
+    //a draw call per teapot and glUniform calls
+    uniform_buffers_ = context->GetGLVersion() >= 3.0f;
+    const bool instanced = instancing && num_instances > 1 && uniform_buffers_;
+
+    //Load shader, octahedral normals need the decoding variant. It builds in
+    //the background, IsReady() tells when it can draw
+    uint32_t options = 0;
+    if( normal_.size == 2 )
+        options |= SHADER_OPTION_OCTAHEDRAL_NORMAL;
+    if( instanced )
+        options |= SHADER_OPTION_INSTANCING;
+    shaders_.Init( state_, context->GetProgramCache(),
+            context->IsParallelShaderCompileSupported() );
+    int32_t program = shaders_.AddProgram( uniform_buffers_ ? PROGRAM_PLAIN_ES3 : PROGRAM_PLAIN );
+    shader_ = shaders_.Request( program, options );
+
+    //Create Index buffer, 32 bit indices need ES3 or GL_OES_element_index_uint
+    index_type_ = header.index_type == ndk_helper::MESH_INDEX_TYPE_UINT32 ?
+            GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    index_size_ = ndk_helper::Mesh::GetIndexSize( header.index_type );
+    lods_.assign( header.lods, header.lods + header.num_lods );
+    lod_ = 0;
     glGenBuffers( 1, &ibo_ );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo_ );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof(teapotIndices), teapotIndices,
+    state_->BindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo_ );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, mesh.GetIndexDataSize(), mesh.GetIndexData(),
+            GL_STATIC_DRAW );
+
+    //Create VBO, the vertices are already interleaved in their GL layout
+    num_vertices_ = header.num_vertices;
+    vertex_stride_ = header.vertex_stride;
+    glGenBuffers( 1, &vbo_ );
+    state_->BindBuffer( GL_ARRAY_BUFFER, vbo_ );
+    glBufferData( GL_ARRAY_BUFFER, mesh.GetVertexDataSize(), mesh.GetVertexData(),
             GL_STATIC_DRAW );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
-
-    //Create VBO
-    num_vertices_ = sizeof(teapotPositions) / sizeof(teapotPositions[0]) / 3;
-    int32_t iStride = sizeof(TEAPOT_VERTEX);
-    int32_t iIndex = 0;
-    TEAPOT_VERTEX* p = new TEAPOT_VERTEX[num_vertices_];
-    for( int32_t i = 0; i < num_vertices_; ++i )
+
+    //Model space bounds, tested against the frustum every frame
+    bounds_ = mesh.GetBounds();
+
+    if( num_instances > 1 )
     {
-        p[i].pos[0] = teapotPositions[iIndex];
-        p[i].pos[1] = teapotPositions[iIndex + 1];
-        p[i].pos[2] = teapotPositions[iIndex + 2];
-
-        p[i].normal[0] = teapotNormals[iIndex];
-        p[i].normal[1] = teapotNormals[iIndex + 1];
-        p[i].normal[2] = teapotNormals[iIndex + 2];
-        iIndex += 3;
+        InitInstances( num_instances );
+        if( instanced )
+        {
+            //Refilled every frame with the visible instances, each LOD has a
+            //range big enough for all instances
+            glGenBuffers( 1, &instance_vbo_ );
+            state_->BindBuffer( GL_ARRAY_BUFFER, instance_vbo_ );
+            glBufferData( GL_ARRAY_BUFFER,
+                    sizeof(TEAPOT_INSTANCE) * lods_.size() * instances_.size(), NULL,
+                    GL_DYNAMIC_DRAW );
+        }
     }
-    glGenBuffers( 1, &vbo_ );
-    glBindBuffer( GL_ARRAY_BUFFER, vbo_ );
-    glBufferData( GL_ARRAY_BUFFER, iStride * num_vertices_, p, GL_STATIC_DRAW );
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    InitVertexArrays();
 
-    delete[] p;
+    if( uniform_buffers_ )
+    {
+        frame_constants_.Init( state_, sizeof(FRAME_CONSTANTS) );
+        material_constants_.Init( state_, sizeof(MATERIAL_CONSTANTS) );
+        //Instances carry their constants in the instance buffer, otherwise
+        //there is a block per visible teapot, or the one of the single teapot
+        if( num_instances > 1 && !instanced )
+            draw_constants_.Init( state_, sizeof(OBJECT_CONSTANTS), num_instances );
+        else if( !instanced )
+            object_constants_.Init( state_, sizeof(OBJECT_CONSTANTS) );
+    }
 
     UpdateViewport();
     mat_model_ = ndk_helper::Mat4::Translation( 0, 0, -15.f );
@@ -91,6 +219,123 @@ void TeapotRenderer::Init()
     mat_model_ = mat * mat_model_;
 }
 
+bool TeapotRenderer::GetAttribute( const ndk_helper::Mesh& mesh,
+        const ndk_helper::MESH_SEMANTIC semantic, VERTEX_ATTRIBUTE* attribute )
+{
+    const ndk_helper::MeshAttribute* mesh_attribute = mesh.FindAttribute( semantic );
+    if( mesh_attribute == NULL )
+        return false;
+
+    attribute->offset = mesh_attribute->offset;
+    attribute->normalized = GL_FALSE;
+    switch( mesh_attribute->format )
+    {
+    case ndk_helper::MESH_FORMAT_FLOAT2:
+        attribute->size = 2;
+        attribute->type = GL_FLOAT;
+        break;
+    case ndk_helper::MESH_FORMAT_FLOAT3:
+        attribute->size = 3;
+        attribute->type = GL_FLOAT;
+        break;
+    case ndk_helper::MESH_FORMAT_HALF4:
+        attribute->size = 4;
+        attribute->type = half_float_type_;
+        break;
+    case ndk_helper::MESH_FORMAT_SNORM16_2:
+        attribute->size = 2;
+        attribute->type = GL_SHORT;
+        attribute->normalized = GL_TRUE;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+void TeapotRenderer::InitInstances( const int32_t num_instances )
+{
+    //Smallest cube holding all instances, instance 0 is the original teapot
+    int32_t grid_size = 1;
+    while( grid_size * grid_size * grid_size < num_instances )
+        ++grid_size;
+
+    instances_.resize( num_instances );
+    instance_bounds_.resize( num_instances );
+    instance_lods_.assign( num_instances, 0 );
+    std::vector<float> corners( num_instances * 6 );
+    for( int32_t i = 0; i < num_instances; ++i )
+    {
+        //Grid coordinates ordered by distance from the center
+        int32_t x = i % grid_size;
+        int32_t y = ( i / grid_size ) % grid_size;
+        int32_t z = i / ( grid_size * grid_size );
+        x = ( x & 1 ) ? -( x + 1 ) / 2 : x / 2;
+        y = ( y & 1 ) ? -( y + 1 ) / 2 : y / 2;
+        z = ( z & 1 ) ? -( z + 1 ) / 2 : z / 2;
+
+        TEAPOT_INSTANCE& instance = instances_[i];
+        instance.model = ndk_helper::Mat4::Translation( x * INSTANCE_SPACING,
+                y * INSTANCE_SPACING, z * INSTANCE_SPACING );
+        instance.diffuse_color[0] = MATERIAL.diffuse_color[0];
+        instance.diffuse_color[1] = MATERIAL.diffuse_color[1] + ( i % 5 ) * 0.1f;
+        instance.diffuse_color[2] = MATERIAL.diffuse_color[2] + ( i % 3 ) * 0.2f;
+        instance.diffuse_color[3] = 1.f;
+
+        instance_bounds_[i] = bounds_.Transform( instance.model );
+        ndk_helper::Vec3 vec_min = instance_bounds_[i].GetCenter()
+                - instance_bounds_[i].GetExtent();
+        ndk_helper::Vec3 vec_max = instance_bounds_[i].GetCenter()
+                + instance_bounds_[i].GetExtent();
+        vec_min.Value( corners[i * 6], corners[i * 6 + 1], corners[i * 6 + 2] );
+        vec_max.Value( corners[i * 6 + 3], corners[i * 6 + 4], corners[i * 6 + 5] );
+    }
+    instances_bounds_ = ndk_helper::BoundingBox::FromPoints( &corners[0], 3,
+            num_instances * 2 );
+}
+
+void TeapotRenderer::InitVertexArrays()
+{
+    const int32_t num_vertex_arrays = instance_vbo_ ? (int32_t) lods_.size() : 1;
+    const int32_t iStride = sizeof(TEAPOT_INSTANCE);
+    for( int32_t lod = 0; lod < num_vertex_arrays; ++lod )
+    {
+        GLuint vertex_array = state_->GenVertexArray();
+        state_->BindVertexArray( vertex_array );
+        vertex_arrays_.push_back( vertex_array );
+
+        state_->BindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo_ );
+        state_->BindBuffer( GL_ARRAY_BUFFER, vbo_ );
+        state_->VertexAttribPointer( ATTRIB_VERTEX, position_.size, position_.type,
+                position_.normalized, vertex_stride_, BUFFER_OFFSET( position_.offset ) );
+        state_->VertexAttribPointer( ATTRIB_NORMAL, normal_.size, normal_.type,
+                normal_.normalized, vertex_stride_, BUFFER_OFFSET( normal_.offset ) );
+        state_->EnableVertexAttribArray( ATTRIB_VERTEX );
+        state_->EnableVertexAttribArray( ATTRIB_NORMAL );
+
+        if( !instance_vbo_ )
+            continue;
+
+        //Without base instance in ES3.0, each LOD's vertex array points the
+        //instance attributes at its range
+        state_->BindBuffer( GL_ARRAY_BUFFER, instance_vbo_ );
+        const size_t base = lod * instances_.size() * sizeof(TEAPOT_INSTANCE);
+        for( int32_t i = 0; i < 4; ++i )
+        {
+            state_->VertexAttribPointer( ATTRIB_INSTANCE_MODEL + i, 4, GL_FLOAT, GL_FALSE, iStride,
+                    BUFFER_OFFSET( base + i * 4 * sizeof(GLfloat) ) );
+        }
+        state_->VertexAttribPointer( ATTRIB_INSTANCE_DIFFUSE, 4, GL_FLOAT, GL_FALSE, iStride,
+                BUFFER_OFFSET( base + 16 * sizeof(GLfloat) ) );
+        for( int32_t i = ATTRIB_INSTANCE_MODEL; i <= ATTRIB_INSTANCE_DIFFUSE; ++i )
+        {
+            state_->EnableVertexAttribArray( i );
+            state_->VertexAttribDivisor( i, 1 );
+        }
+    }
+    state_->BindVertexArray( 0 );
+}
+
 void TeapotRenderer::UpdateViewport()
 {
     //Init Projection matrices
@@ -98,182 +343,362 @@ void TeapotRenderer::UpdateViewport()
     glGetIntegerv( GL_VIEWPORT, viewport );
     float fAspect = (float) viewport[2] / (float) viewport[3];
 
-    const float CAM_NEAR = 5.f;
-    const float CAM_FAR = 10000.f;
     mat_projection_ = ndk_helper::Mat4::Perspective( fAspect, 1.f, CAM_NEAR, CAM_FAR );
+
+    //Projected size of one unit at distance 1, clip space y spans the viewport
+    //height
+    lod_scale_ = mat_projection_.Ptr()[5] * viewport[3] * 0.5f;
+}
+
+int32_t TeapotRenderer::SelectLod( const ndk_helper::BoundingBox& bounds,
+        const int32_t current ) const
+{
+    //Distance to the closest point of the bounds' sphere, mat_view_ maps model
+    //space to view space
+    ndk_helper::Vec4 center = mat_view_ * ndk_helper::Vec4( bounds.GetCenter(), 1.f );
+    float x, y, z, w;
+    center.Value( x, y, z, w );
+    float distance = std::max( -z - bounds.GetExtent().Length(), CAM_NEAR );
+    float pixels_per_unit = lod_scale_ / distance;
+
+    int32_t lod = std::min( current, (int32_t) lods_.size() - 1 );
+    while( lod > 0 && lods_[lod].error * pixels_per_unit > LOD_PIXEL_ERROR )
+        --lod;
+    while( lod + 1 < (int32_t) lods_.size()
+            && lods_[lod + 1].error * pixels_per_unit < LOD_PIXEL_ERROR * LOD_HYSTERESIS )
+        ++lod;
+    return lod;
+}
+
+void TeapotRenderer::DrawLod( const int32_t lod, const int32_t num_instances )
+{
+    const ndk_helper::MeshLod& range = lods_[lod];
+    if( instance_vbo_ )
+        glDrawElementsInstanced( GL_TRIANGLES, range.num_indices, index_type_,
+                BUFFER_OFFSET( range.first_index * index_size_ ), num_instances );
+    else
+        glDrawElements( GL_TRIANGLES, range.num_indices, index_type_,
+                BUFFER_OFFSET( range.first_index * index_size_ ) );
+    num_triangles_ += range.num_indices / 3 * num_instances;
 }
 
 void TeapotRenderer::Unload()
 {
+    for( size_t i = 0; i < vertex_arrays_.size(); ++i )
+        state_->DeleteVertexArray( vertex_arrays_[i] );
+    vertex_arrays_.clear();
+
     if( vbo_ )
     {
-        glDeleteBuffers( 1, &vbo_ );
+        state_->DeleteBuffer( vbo_ );
         vbo_ = 0;
     }
 
     if( ibo_ )
     {
-        glDeleteBuffers( 1, &ibo_ );
+        state_->DeleteBuffer( ibo_ );
         ibo_ = 0;
     }
 
-    if( shader_param_.program_ )
+    if( instance_vbo_ )
     {
-        glDeleteProgram( shader_param_.program_ );
-        shader_param_.program_ = 0;
+        state_->DeleteBuffer( instance_vbo_ );
+        instance_vbo_ = 0;
     }
+    instances_.clear();
+    instance_bounds_.clear();
+    instance_lods_.clear();
+    frame_.instance_data.clear();
+    frame_.draws.clear();
+    lods_.clear();
+
+    //Deletes the programs, whether they were ready or not
+    shaders_.Unload();
+    shader_ = ndk_helper::SHADER_HANDLE_INVALID;
+
+    frame_constants_.Unload();
+    material_constants_.Unload();
+    object_constants_.Unload();
+    draw_constants_.Unload();
 }
 
 void TeapotRenderer::Update( const double time )
 {
-    const float CAM_X = 0.f;
-    const float CAM_Y = 0.f;
-    const float CAM_Z = 700.f;
-
-    mat_view_ = ndk_helper::Mat4::LookAt( ndk_helper::Vec3( CAM_X, CAM_Y, CAM_Z ),
-            ndk_helper::Vec3( 0.f, 0.f, 0.f ), ndk_helper::Vec3( 0.f, 1.f, 0.f ) );
+    mat_view_ = MAT_CAMERA_VIEW;
 
     if( camera_ )
     {
         camera_->Update( time );
-        mat_view_ = camera_->GetTransformMatrix() * mat_view_
-                * camera_->GetRotationMatrix() * mat_model_;
+        ndk_helper::Mat4::Multiply( mat_view_, camera_->GetTransformMatrix(), mat_view_,
+                camera_->GetRotationMatrix(), mat_model_ );
     }
     else
     {
-        mat_view_ = mat_view_ * mat_model_;
+        ndk_helper::Mat4::Multiply( mat_view_, mat_view_, mat_model_ );
     }
 }
 
-void TeapotRenderer::Render()
+void TeapotRenderer::Interpolate( const float alpha )
 {
-    //
-    // Feed Projection and Model View matrices to the shaders
-    ndk_helper::Mat4 mat_vp = mat_projection_ * mat_view_;
-
-    // Bind the VBO
-    glBindBuffer( GL_ARRAY_BUFFER, vbo_ );
+    mat_view_ = MAT_CAMERA_VIEW;
 
-    int32_t iStride = sizeof(TEAPOT_VERTEX);
-    // Pass the vertex data
-    glVertexAttribPointer( ATTRIB_VERTEX, 3, GL_FLOAT, GL_FALSE, iStride,
-            BUFFER_OFFSET( 0 ) );
-    glEnableVertexAttribArray( ATTRIB_VERTEX );
-
-    glVertexAttribPointer( ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, iStride,
-            BUFFER_OFFSET( 3 * sizeof(GLfloat) ) );
-    glEnableVertexAttribArray( ATTRIB_NORMAL );
-
-    // Bind the IB
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo_ );
-
-    glUseProgram( shader_param_.program_ );
-
-    TEAPOT_MATERIALS material = { { 1.0f, 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 10.f }, {
-            0.1f, 0.1f, 0.1f }, };
+    if( camera_ )
+    {
+        ndk_helper::Mat4 mat_rotation( ndk_helper::MAT4_UNINITIALIZED );
+        ndk_helper::Mat4 mat_transform( ndk_helper::MAT4_UNINITIALIZED );
+        camera_->Interpolate( alpha, &mat_rotation, &mat_transform );
+        ndk_helper::Mat4::Multiply( mat_view_, mat_transform, mat_view_, mat_rotation,
+                mat_model_ );
+    }
+    else
+    {
+        ndk_helper::Mat4::Multiply( mat_view_, mat_view_, mat_model_ );
+    }
+}
 
-    //Update uniforms
-    glUniform4f( shader_param_.material_diffuse_, material.diffuse_color[0],
-            material.diffuse_color[1], material.diffuse_color[2], 1.f );
+void TeapotRenderer::Render()
+{
+    Prepare( &frame_ );
+    Submit( frame_ );
+}
 
-    glUniform4f( shader_param_.material_specular_, material.specular_color[0],
-            material.specular_color[1], material.specular_color[2],
-            material.specular_color[3] );
-    //
-    //using glUniform3fv here was troublesome
+void TeapotRenderer::Prepare( TEAPOT_FRAME* frame )
+{
     //
-    glUniform3f( shader_param_.material_ambient_, material.ambient_color[0],
-            material.ambient_color[1], material.ambient_color[2] );
-
-    glUniformMatrix4fv( shader_param_.matrix_projection_, 1, GL_FALSE, mat_vp.Ptr() );
-    glUniformMatrix4fv( shader_param_.matrix_view_, 1, GL_FALSE, mat_view_.Ptr() );
-    glUniform3f( shader_param_.light0_, 100.f, -200.f, -600.f );
-
-    glDrawElements( GL_TRIANGLES, num_indices_, GL_UNSIGNED_SHORT, BUFFER_OFFSET(0) );
-
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    // Projection and Model View matrices of the shaders
+    ndk_helper::Mat4::Multiply( frame->mat_vp, mat_projection_, mat_view_ );
+    frame->mat_view = mat_view_;
+    frame->draws.clear();
+
+    //mat_view_ includes the model transform, so the frustum is in model space
+    ndk_helper::Frustum frustum( frame->mat_vp );
+    frame->visible = !vertex_arrays_.empty()
+            && frustum.IsVisible( instances_.empty() ? bounds_ : instances_bounds_ );
+    if( !frame->visible )
+        return;
+
+    if( instance_vbo_ )
+    {
+        PrepareInstances( frame, frustum );
+    }
+    else if( !instances_.empty() )
+    {
+        //One draw call per visible teapot, ES3 takes the model transform from
+        //the object block
+        for( size_t i = 0; i < instances_.size(); ++i )
+        {
+            if( !frustum.IsVisible( instance_bounds_[i] ) )
+                continue;
+
+            const TEAPOT_INSTANCE& instance = instances_[i];
+            frame->draws.push_back( TEAPOT_DRAW() );
+            TEAPOT_DRAW& draw = frame->draws.back();
+            if( !uniform_buffers_ )
+            {
+                ndk_helper::Mat4::Multiply( draw.mat_vp, frame->mat_vp, instance.model );
+                ndk_helper::Mat4::Multiply( draw.mat_view, mat_view_, instance.model );
+            }
+            memcpy( draw.diffuse_color, instance.diffuse_color, sizeof(draw.diffuse_color) );
+
+            instance_lods_[i] = SelectLod( instance_bounds_[i], instance_lods_[i] );
+            draw.lod = instance_lods_[i];
+            draw.instance = (int32_t) i;
+        }
+    }
+    else
+    {
+        lod_ = SelectLod( bounds_, lod_ );
+        frame->lod = lod_;
+    }
 }
 
-bool TeapotRenderer::LoadShaders( SHADER_PARAMS* params,
-        const char* strVsh,
-        const char* strFsh )
+void TeapotRenderer::PrepareInstances( TEAPOT_FRAME* frame, const ndk_helper::Frustum& frustum )
 {
-    GLuint program;
-    GLuint vert_shader, frag_shader;
-
-    // Create shader program
-    program = glCreateProgram();
-    LOGI( "Created Shader %d", program );
-
-    // Create and compile vertex shader
-    if( !ndk_helper::shader::CompileShader( &vert_shader, GL_VERTEX_SHADER, strVsh ) )
+    //Gather the visible instances into the range of their LOD, so each LOD
+    //takes one upload and one draw call
+    int32_t* lod_counts = frame->lod_counts;
+    memset( lod_counts, 0, sizeof(frame->lod_counts) );
+    for( size_t i = 0; i < instances_.size(); ++i )
     {
-        LOGI( "Failed to compile vertex shader" );
-        glDeleteProgram( program );
-        return false;
+        if( !frustum.IsVisible( instance_bounds_[i] ) )
+        {
+            instance_lods_[i] = -1;
+            continue;
+        }
+        int32_t lod = SelectLod( instance_bounds_[i], std::max( instance_lods_[i], 0 ) );
+        instance_lods_[i] = lod;
+        ++lod_counts[lod];
     }
 
-    // Create and compile fragment shader
-    if( !ndk_helper::shader::CompileShader( &frag_shader, GL_FRAGMENT_SHADER, strFsh ) )
+    //Each LOD has a range big enough for all instances
+    const size_t lod_capacity = instances_.size();
+    frame->instance_data.resize( lods_.size() * lod_capacity );
+    int32_t lod_ends[ndk_helper::MESH_MAX_LODS];
+    for( int32_t lod = 0; lod < ndk_helper::MESH_MAX_LODS; ++lod )
+        lod_ends[lod] = lod * lod_capacity;
+    for( size_t i = 0; i < instances_.size(); ++i )
     {
-        LOGI( "Failed to compile fragment shader" );
-        glDeleteProgram( program );
-        return false;
+        if( instance_lods_[i] >= 0 )
+            frame->instance_data[lod_ends[instance_lods_[i]]++] = instances_[i];
     }
+}
 
-    // Attach vertex shader to program
-    glAttachShader( program, vert_shader );
+void TeapotRenderer::Submit( const TEAPOT_FRAME& frame )
+{
+    num_triangles_ = 0;
+    if( !frame.visible || !IsReady() )
+        return;
 
-    // Attach fragment shader to program
-    glAttachShader( program, frag_shader );
+    //All state goes through the GL state cache, so whatever is unchanged since
+    //the last frame (usually all but the matrices) doesn't reach the driver.
+    //The vertex layout is a single vertex array bind, per LOD when instanced
+    if( !instance_vbo_ )
+        state_->BindVertexArray( vertex_arrays_[0] );
 
-    // Bind attribute locations
-    // this needs to be done prior to linking
-    glBindAttribLocation( program, ATTRIB_VERTEX, "myVertex" );
-    glBindAttribLocation( program, ATTRIB_NORMAL, "myNormal" );
-    glBindAttribLocation( program, ATTRIB_UV, "myUV" );
+    state_->UseProgram( shaders_.GetProgram( shader_ ) );
 
-    // Link program
-    if( !ndk_helper::shader::LinkProgram( program ) )
+    if( uniform_buffers_ )
     {
-        LOGI( "Failed to link program: %d", program );
-
-        if( vert_shader )
+        UpdateConstants( frame );
+        if( instance_vbo_ )
         {
-            glDeleteShader( vert_shader );
-            vert_shader = 0;
+            SubmitInstanced( frame );
         }
-        if( frag_shader )
+        else if( !instances_.empty() )
         {
-            glDeleteShader( frag_shader );
-            frag_shader = 0;
+            SubmitDraws( frame );
         }
-        if( program )
+        else
         {
-            glDeleteProgram( program );
+            //The transform of the teapot is in the frame block, so the object
+            //block is unchanged since Init and only compared
+            OBJECT_CONSTANTS object = { ndk_helper::Mat4::Identity(), {
+                    MATERIAL.diffuse_color[0], MATERIAL.diffuse_color[1],
+                    MATERIAL.diffuse_color[2], 1.f } };
+            object_constants_.Update( &object );
+            object_constants_.Bind( UNIFORM_BINDING_OBJECT );
+
+            DrawLod( frame.lod, 1 );
         }
+        return;
+    }
 
-        return false;
+    //Update uniforms, the locations were resolved once the program got ready
+    const GLint projection = shaders_.GetUniform( shader_, UNIFORM_PROJECTION );
+    const GLint view = shaders_.GetUniform( shader_, UNIFORM_VIEW );
+    const GLint light0 = shaders_.GetUniform( shader_, UNIFORM_LIGHT0 );
+    const GLint diffuse = shaders_.GetUniform( shader_, UNIFORM_MATERIAL_DIFFUSE );
+    const GLint ambient = shaders_.GetUniform( shader_, UNIFORM_MATERIAL_AMBIENT );
+    const GLint specular = shaders_.GetUniform( shader_, UNIFORM_MATERIAL_SPECULAR );
+    state_->Uniform4f( specular, MATERIAL.specular_color[0],
+            MATERIAL.specular_color[1], MATERIAL.specular_color[2],
+            MATERIAL.specular_color[3] );
+    //
+    //using glUniform3fv here was troublesome
+    //
+    state_->Uniform3f( ambient, MATERIAL.ambient_color[0],
+            MATERIAL.ambient_color[1], MATERIAL.ambient_color[2] );
+    state_->Uniform3f( light0, 100.f, -200.f, -600.f );
+
+    if( instance_vbo_ )
+    {
+        //Instanced, instance transforms and diffuse colors come from the
+        //instance buffer
+        state_->UniformMatrix4fv( projection, frame.mat_vp.Ptr() );
+        state_->UniformMatrix4fv( view, frame.mat_view.Ptr() );
+
+        SubmitInstanced( frame );
+    }
+    else if( !instances_.empty() )
+    {
+        //ES2, one draw call per visible teapot
+        for( size_t i = 0; i < frame.draws.size(); ++i )
+        {
+            const TEAPOT_DRAW& draw = frame.draws[i];
+            state_->Uniform4f( diffuse, draw.diffuse_color[0],
+                    draw.diffuse_color[1], draw.diffuse_color[2], draw.diffuse_color[3] );
+            state_->UniformMatrix4fv( projection, draw.mat_vp.Ptr() );
+            state_->UniformMatrix4fv( view, draw.mat_view.Ptr() );
+            DrawLod( draw.lod, 1 );
+        }
+    }
+    else
+    {
+        state_->Uniform4f( diffuse, MATERIAL.diffuse_color[0],
+                MATERIAL.diffuse_color[1], MATERIAL.diffuse_color[2], 1.f );
+        state_->UniformMatrix4fv( projection, frame.mat_vp.Ptr() );
+        state_->UniformMatrix4fv( view, frame.mat_view.Ptr() );
+
+        DrawLod( frame.lod, 1 );
+    }
+}
+
+void TeapotRenderer::UpdateConstants( const TEAPOT_FRAME& frame )
+{
+    FRAME_CONSTANTS constants = { frame.mat_vp, frame.mat_view, { 100.f, -200.f, -600.f,
+            0.f } };
+    frame_constants_.Update( &constants );
+    frame_constants_.Bind( UNIFORM_BINDING_FRAME );
+
+    //Unchanged since Init, so only compared
+    MATERIAL_CONSTANTS material = { { MATERIAL.specular_color[0], MATERIAL.specular_color[1],
+            MATERIAL.specular_color[2], MATERIAL.specular_color[3] }, {
+            MATERIAL.ambient_color[0], MATERIAL.ambient_color[1], MATERIAL.ambient_color[2],
+            1.f } };
+    material_constants_.Update( &material );
+    material_constants_.Bind( UNIFORM_BINDING_MATERIAL );
+}
+
+void TeapotRenderer::SubmitInstanced( const TEAPOT_FRAME& frame )
+{
+    //All uploads before the draws that read the buffer
+    const size_t lod_capacity = instances_.size();
+    state_->BindBuffer( GL_ARRAY_BUFFER, instance_vbo_ );
+    for( int32_t lod = 0; lod < (int32_t) lods_.size(); ++lod )
+    {
+        const size_t first = lod * lod_capacity;
+        if( frame.lod_counts[lod] )
+            glBufferSubData( GL_ARRAY_BUFFER, first * sizeof(TEAPOT_INSTANCE),
+                    sizeof(TEAPOT_INSTANCE) * frame.lod_counts[lod],
+                    &frame.instance_data[first] );
     }
 
-    // Get uniform locations
-    params->matrix_projection_ = (GLuint) glGetUniformLocation(program, "uPMatrix" );
-    params->matrix_view_ = (GLuint) glGetUniformLocation(program, "uMVMatrix" );
+    for( int32_t lod = 0; lod < (int32_t) lods_.size(); ++lod )
+    {
+        if( frame.lod_counts[lod] == 0 )
+            continue;
+        state_->BindVertexArray( vertex_arrays_[lod] );
+        DrawLod( lod, frame.lod_counts[lod] );
+    }
+}
 
-    params->light0_ = (GLuint) glGetUniformLocation(program, "vLight0" );
-    params->material_diffuse_ = (GLuint) glGetUniformLocation(program, "vMaterialDiffuse" );
-    params->material_ambient_ = (GLuint) glGetUniformLocation(program, "vMaterialAmbient" );
-    params->material_specular_ = (GLuint) glGetUniformLocation(program, "vMaterialSpecular" );
+void TeapotRenderer::SubmitDraws( const TEAPOT_FRAME& frame )
+{
+    //All blocks of the frame in one upload before the draws that read them
+    draw_offsets_.resize( frame.draws.size() );
+    draw_constants_.BeginFrame();
+    for( size_t i = 0; i < frame.draws.size(); ++i )
+    {
+        const TEAPOT_DRAW& draw = frame.draws[i];
+        OBJECT_CONSTANTS object;
+        object.model = instances_[draw.instance].model;
+        memcpy( object.diffuse_color, draw.diffuse_color, sizeof(object.diffuse_color) );
+        draw_offsets_[i] = draw_constants_.Allocate( &object );
+    }
+    draw_constants_.EndFrame();
 
-    // Release vertex and fragment shaders
-    if( vert_shader )
-        glDeleteShader( vert_shader );
-    if( frag_shader )
-        glDeleteShader( frag_shader );
+    for( size_t i = 0; i < frame.draws.size(); ++i )
+    {
+        if( draw_offsets_[i] < 0 )
+            continue;
+        draw_constants_.Bind( UNIFORM_BINDING_OBJECT, draw_offsets_[i] );
+        DrawLod( frame.draws[i].lod, 1 );
+    }
+}
 
-    params->program_ = program;
-    return true;
+bool TeapotRenderer::IsReady()
+{
+    return shaders_.GetStatus( shader_ ) == ndk_helper::PROGRAM_READY;
 }
 
 bool TeapotRenderer::Bind( ndk_helper::TapCamera* camera )
@@ -24,45 +24,139 @@
 //--------------------------------------------------------------------------------
 // Include files
 //--------------------------------------------------------------------------------
-#include <jni.h>
 #include <errno.h>
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include <EGL/egl.h>
 #include <GLES/gl.h>
 
+//Host builds record the renderer's GL calls, see glRecorder.h in NDKHelper
+#if defined(__ANDROID__)
+#include <jni.h>
 #include <android/sensor.h>
 #include <android/log.h>
 #include <android_native_app_glue.h>
 #include <android/native_window_jni.h>
 #include <cpu-features.h>
+#endif
 
 #include "NDKHelper.h"
+#include <GLES2/gl2ext.h>
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
-struct TEAPOT_VERTEX
+//Selects the baked mesh asset, see tools/mesh_baker in NDKHelper
+//FLOAT: Meshes/teapot.mesh, float position and normal, 24 bytes per vertex
+//PACKED: Meshes/teapot_packed.mesh, half float position and octahedral snorm16
+//normal, 12 bytes per vertex
+enum TEAPOT_VERTEX_LAYOUT
+{
+    TEAPOT_VERTEX_LAYOUT_FLOAT, TEAPOT_VERTEX_LAYOUT_PACKED,
+};
+
+//glVertexAttribPointer() arguments of a mesh attribute
+struct VERTEX_ATTRIBUTE
 {
-    float pos[3];
-    float normal[3];
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;
+};
+
+//Per instance data of the instanced path, a mat4 attribute takes 4 locations
+struct TEAPOT_INSTANCE
+{
+    ndk_helper::Mat4 model; //Instance to model space
+    float diffuse_color[4];
 };
 
 enum SHADER_ATTRIBUTES
 {
-    ATTRIB_VERTEX, ATTRIB_NORMAL, ATTRIB_UV,
+    ATTRIB_VERTEX,
+    ATTRIB_NORMAL,
+    ATTRIB_UV,
+    ATTRIB_INSTANCE_MODEL,
+    ATTRIB_INSTANCE_DIFFUSE = ATTRIB_INSTANCE_MODEL + 4,
+};
+
+//Stress mode without instancing, one teapot drawn with glUniform matrices on
+//ES2, with its object block of the ring buffer on ES3
+struct TEAPOT_DRAW
+{
+    ndk_helper::Mat4 mat_vp; //Projection * view * instance, ES2
+    ndk_helper::Mat4 mat_view; //View * instance, ES2
+    float diffuse_color[4];
+    int32_t lod;
+    int32_t instance; //Of the renderer's instances
+};
+
+//What Submit() draws, written by Prepare() without any GL call. Visible
+//teapots, their LODs and transforms, depending on the path:
+//- single teapot: lod
+//- instanced stress mode: lod_counts[lod] instances at instance_data[lod *
+//  number of teapots]
+//- stress mode without instancing: draws
+struct TEAPOT_FRAME
+{
+    ndk_helper::Mat4 mat_vp; //Projection * view
+    ndk_helper::Mat4 mat_view;
+    bool visible;
+    int32_t lod;
+    int32_t lod_counts[ndk_helper::MESH_MAX_LODS];
+    std::vector<TEAPOT_INSTANCE> instance_data;
+    std::vector<TEAPOT_DRAW> draws;
+
+    TEAPOT_FRAME() :
+                    visible( false ),
+                    lod( 0 )
+    {
+    }
 };
 
-struct SHADER_PARAMS
+//std140 uniform blocks of the ES3 shaders, see VS_ShaderPlainES3.vsh
+struct FRAME_CONSTANTS
 {
-    GLuint program_;
-    GLuint light0_;
-    GLuint material_diffuse_;
-    GLuint material_ambient_;
-    GLuint material_specular_;
-
-    GLuint matrix_projection_;
-    GLuint matrix_view_;
+    ndk_helper::Mat4 projection; //Projection * view
+    ndk_helper::Mat4 view;
+    float light0[4];
+};
+
+struct OBJECT_CONSTANTS
+{
+    ndk_helper::Mat4 model;
+    float diffuse_color[4];
+};
+
+struct MATERIAL_CONSTANTS
+{
+    float specular_color[4]; //w: power
+    float ambient_color[4];
+};
+
+enum UNIFORM_BINDINGS
+{
+    UNIFORM_BINDING_FRAME, UNIFORM_BINDING_OBJECT, UNIFORM_BINDING_MATERIAL, UNIFORM_BINDING_COUNT,
+};
+
+//Variant bits of the teapot program, see SHADER_OPTION_NAMES
+enum TEAPOT_SHADER_OPTIONS
+{
+    SHADER_OPTION_OCTAHEDRAL_NORMAL = 1 << 0, SHADER_OPTION_INSTANCING = 1 << 1,
+};
+
+//Uniforms of the ES2 shaders, indices of the ShaderLibrary's location table
+enum SHADER_UNIFORMS
+{
+    UNIFORM_PROJECTION,
+    UNIFORM_VIEW,
+    UNIFORM_LIGHT0,
+    UNIFORM_MATERIAL_DIFFUSE,
+    UNIFORM_MATERIAL_AMBIENT,
+    UNIFORM_MATERIAL_SPECULAR,
+    UNIFORM_COUNT,
 };
 
 struct TEAPOT_MATERIALS
@@ -74,13 +168,67 @@ struct TEAPOT_MATERIALS
 
 class TeapotRenderer
 {
-    int32_t num_indices_;
     int32_t num_vertices_;
+    ndk_helper::BoundingBox bounds_;
     GLuint ibo_;
     GLuint vbo_;
+    GLenum index_type_;
+    int32_t index_size_;
+    GLsizei vertex_stride_;
+    VERTEX_ATTRIBUTE position_;
+    VERTEX_ATTRIBUTE normal_;
+    GLenum half_float_type_;
+    bool GetAttribute( const ndk_helper::Mesh& mesh, const ndk_helper::MESH_SEMANTIC semantic,
+            VERTEX_ATTRIBUTE* attribute );
+
+    //Levels of detail, index ranges of the baked mesh. lod_ is the current
+    //level of the single teapot, instance_lods_ of each stress mode teapot
+    std::vector<ndk_helper::MeshLod> lods_;
+    int32_t lod_;
+    float lod_scale_; //Pixels per object space unit at distance 1
+    int32_t SelectLod( const ndk_helper::BoundingBox& bounds, const int32_t current ) const;
+    void DrawLod( const int32_t lod, const int32_t num_instances );
+
+    //Stress mode, more than one teapot. Drawn with one instanced draw call per
+    //LOD on ES3, one draw call per visible teapot on ES2 or without instancing
+    std::vector<TEAPOT_INSTANCE> instances_;
+    std::vector<ndk_helper::BoundingBox> instance_bounds_;
+    std::vector<int32_t> instance_lods_;
+    ndk_helper::BoundingBox instances_bounds_;
+    GLuint instance_vbo_;
+    void InitInstances( const int32_t num_instances );
+    void PrepareInstances( TEAPOT_FRAME* frame, const ndk_helper::Frustum& frustum );
+    void SubmitInstanced( const TEAPOT_FRAME& frame );
+
+    TEAPOT_FRAME frame_; //Of Render()
+
+    //Vertex layouts recorded once in Init, a draw only binds one. A single
+    //one, or one per LOD on the instanced path, each pointing the instance
+    //attributes at its LOD's range of the instance buffer
+    std::vector<GLuint> vertex_arrays_;
+    void InitVertexArrays();
 
-    SHADER_PARAMS shader_param_;
-    bool LoadShaders( SHADER_PARAMS* params, const char* strVsh, const char* strFsh );
+    int32_t num_triangles_; //Submitted by the last Render()
+
+    ndk_helper::GLState* state_; //State cache of the GLContext
+
+    //Teapot program variants, shader_ is the one drawn with
+    ndk_helper::ShaderLibrary shaders_;
+    ndk_helper::ShaderHandle shader_;
+
+    //ES3 constants in uniform buffers instead of glUniform calls: the frame
+    //block is written once per frame, the material block and the object block
+    //of the single teapot only when they change. Stress mode without
+    //instancing writes the object blocks of all draws to a ring buffer with
+    //one upload, each draw binds its range
+    bool uniform_buffers_;
+    ndk_helper::UniformBuffer frame_constants_;
+    ndk_helper::UniformBuffer material_constants_;
+    ndk_helper::UniformBuffer object_constants_;
+    ndk_helper::UniformRingBuffer draw_constants_;
+    std::vector<GLintptr> draw_offsets_; //Of the draws of a frame
+    void UpdateConstants( const TEAPOT_FRAME& frame );
+    void SubmitDraws( const TEAPOT_FRAME& frame );
 
     ndk_helper::Mat4 mat_projection_;
     ndk_helper::Mat4 mat_view_;
@@ -90,12 +238,35 @@ class TeapotRenderer
 public:
     TeapotRenderer();
     virtual ~TeapotRenderer();
-    void Init();
+    //instancing: ES3 stress mode draws one instanced draw call per LOD,
+    //otherwise one draw call per visible teapot like ES2
+    void Init( const TEAPOT_VERTEX_LAYOUT layout = TEAPOT_VERTEX_LAYOUT_FLOAT,
+            const int32_t num_instances = 1, const bool instancing = true );
     void Render();
     void Update( const double time );
+    //View matrix alpha of the way from the camera of the second last Update()
+    //to the last, for fixed timestep simulation, see ndk_helper::FixedTimestep.
+    //Update() leaves it at the last
+    void Interpolate( const float alpha );
+
+    //Render() in two steps. Update() and Prepare() only do CPU work (camera,
+    //culling, LOD selection, matrices) and may run on another thread than the
+    //GL context, e.g. one frame ahead while Submit() draws the previous frame
+    //from a second TEAPOT_FRAME. Init(), Unload() and UpdateViewport() must
+    //not overlap with either
+    void Prepare( TEAPOT_FRAME* frame );
+    void Submit( const TEAPOT_FRAME& frame );
+    //Whether the shaders are built, GL thread only. Submit() draws nothing
+    //until they are, so the app keeps presenting frames, e.g. a loading
+    //screen, while the driver compiles
+    bool IsReady();
     bool Bind( ndk_helper::TapCamera* camera );
     void Unload();
     void UpdateViewport();
+    int32_t GetNumTriangles() const
+    {
+        return num_triangles_;
+    }
 };
 
 #endif
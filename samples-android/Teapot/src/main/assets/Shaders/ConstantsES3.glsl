@@ -0,0 +1,20 @@
+//
+//  ConstantsES3.glsl
+//  Uniform blocks shared by VS_ShaderPlainES3.vsh and ShaderPlainES3.fsh,
+//  included by the shader preprocessor
+//
+
+//Written once per frame
+layout(std140) uniform FrameConstants
+{
+    highp mat4      uPMatrix;   //Projection * view
+    highp mat4      uMVMatrix;  //View
+    highp vec4      vLight0;    //xyz
+};
+
+//Uploaded when the material changes
+layout(std140) uniform MaterialConstants
+{
+    mediump vec4    vMaterialSpecular;  //w: power
+    lowp vec4       vMaterialAmbient;
+};
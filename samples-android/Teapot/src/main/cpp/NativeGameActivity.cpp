@@ -24,6 +24,8 @@
 #include <errno.h>
 #include <jni.h>
 
+#include <mutex>
+
 // For GPGS
 #include "gpg/android_platform_configuration.h"
 #include "gpg/android_initialization.h"
@@ -44,6 +46,16 @@
 #define JUIHELPER_CLASS_NAME "com.sample.helper.JUIHelper"
 // Share object name of helper function library
 #define HELPER_CLASS_SONAME "teapot"
+// Number of teapots drawn, raise it to stress test draw throughput. They are
+// instanced on ES3, drawn one by one on ES2
+#define NUM_TEAPOTS 1
+// Frames of state in the pipelined mode, 2: the simulation runs one frame ahead
+// of GL, 3: up to two frames
+#define NUM_FRAME_SLOTS 2
+// Simulation steps per second, independent of the frame rate. A frame runs at
+// most MAX_SIMULATION_STEPS, time beyond that is dropped
+#define SIMULATION_HZ 60
+#define MAX_SIMULATION_STEPS 4
 
 //------------------------------------------------------------------------------
 // Shared state for our app.
@@ -85,10 +97,21 @@ class Engine {
   jui_helper::JUITextView *status_text_;
 
   ndk_helper::TapCamera tap_camera_;
+  ndk_helper::FixedTimestep timestep_;
 
   android_app *app_;
   int current_score_ = 0;
 
+  // Pipelined mode on multi-core devices: camera, culling and LOD selection
+  // of the next frame run on a worker while this thread submits the current
+  // one to GL. The input handler moves the camera under camera_mutex_
+  ndk_helper::FramePipeline pipeline_;
+  TEAPOT_FRAME frames_[NUM_FRAME_SLOTS];
+  std::mutex camera_mutex_;
+  void StartPipeline();
+  void Simulate(TEAPOT_FRAME *frame);
+  void StepSimulation();
+
   void UpdateFPS(float fps);
   void ShowUI();
   void TransformPosition(ndk_helper::Vec2 *vec);
@@ -100,7 +123,8 @@ Engine g_engine;
 
 Engine::Engine()
     : initialized_resources_(false), has_focus_(false),
-      button_sign_in_(nullptr), status_text_(nullptr), app_(nullptr) {
+      button_sign_in_(nullptr), status_text_(nullptr),
+      timestep_(SIMULATION_HZ, MAX_SIMULATION_STEPS), app_(nullptr) {
   gl_context_ = ndk_helper::GLContext::GetInstance();
 }
 
@@ -264,7 +288,7 @@ void Engine::InitUI() {
 }
 
 void Engine::LoadResources() {
-  renderer_.Init();
+  renderer_.Init(TEAPOT_VERTEX_LAYOUT_PACKED, NUM_TEAPOTS);
   renderer_.Bind(&tap_camera_);
 }
 
@@ -272,8 +296,38 @@ void Engine::UnloadResources() {
   renderer_.Unload();
 }
 
+void Engine::StartPipeline() {
+  if (android_getCpuCount() < 2) {
+    return;
+  }
+  pipeline_.Start(NUM_FRAME_SLOTS, [this](int32_t slot) {
+    Simulate(&frames_[slot]);
+  });
+}
+
+// Worker thread of the pipeline, no GL calls
+void Engine::Simulate(TEAPOT_FRAME *frame) {
+  {
+    std::lock_guard<std::mutex> lock(camera_mutex_);
+    StepSimulation();
+  }
+  renderer_.Prepare(frame);
+}
+
+// Runs the fixed steps due since the last frame, then places the camera
+// between the last two
+void Engine::StepSimulation() {
+  int32_t steps = timestep_.Advance(ndk_helper::PerfMonitor::GetCurrentTime());
+  for (int32_t i = 0; i < steps; ++i) {
+    renderer_.Update(timestep_.GetStepTime(i));
+  }
+  renderer_.Interpolate(timestep_.GetAlpha());
+}
+
 // Initialize an EGL context for the current display.
 int Engine::InitDisplay(const int32_t cmd) {
+  // The simulation reads what is set up here
+  pipeline_.Stop();
   if (!initialized_resources_) {
     gl_context_->Init(app_->window);
     InitUI();
@@ -292,9 +346,10 @@ int Engine::InitDisplay(const int32_t cmd) {
   ShowUI();
 
   // Initialize GL state.
-  glEnable(GL_CULL_FACE);
-  glEnable(GL_DEPTH_TEST);
-  glDepthFunc(GL_LEQUAL);
+  ndk_helper::GLState *state = gl_context_->GetState();
+  state->Enable(GL_CULL_FACE);
+  state->Enable(GL_DEPTH_TEST);
+  state->DepthFunc(GL_LEQUAL);
 
   // Note that screen size might have been changed
   glViewport(0, 0, gl_context_->GetScreenWidth(),
@@ -304,6 +359,9 @@ int Engine::InitDisplay(const int32_t cmd) {
   tap_camera_.SetFlip(1.f, -1.f, -1.f);
   tap_camera_.SetPinchTransformFactor(2.f, 2.f, 8.f);
 
+  // No catching up on the time the display was gone
+  timestep_.Reset();
+  StartPipeline();
   return 0;
 }
 
@@ -312,23 +370,43 @@ void Engine::DrawFrame() {
   float fps;
   if (monitor_.Update(fps)) {
     UpdateFPS(fps);
+    //Submitted by the previous frame, drops as teapots switch to coarser LODs
+    LOGI("Triangles per frame: %d", renderer_.GetNumTriangles());
+    ndk_helper::GLState *state = gl_context_->GetState();
+    LOGI("GL state calls since last report: %u issued, %u skipped",
+         state->GetCounters().issued, state->GetCounters().skipped);
+    state->ResetCounters();
   }
-  renderer_.Update(monitor_.GetCurrentTime());
 
   // Just fill the screen with a color.
   glClearColor(0.5f, 0.5f, 0.5f, 1.f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  renderer_.Render();
+  if (pipeline_.IsRunning()) {
+    // Simulated while the previous frame was submitted, the slot is free
+    // again as soon as its data reached GL
+    int32_t slot = pipeline_.AcquireFrame();
+    renderer_.Submit(frames_[slot]);
+    pipeline_.ReleaseFrame(slot);
+  } else {
+    StepSimulation();
+    renderer_.Render();
+  }
 
   // Swap
   if (EGL_SUCCESS != gl_context_->Swap()) {
+    bool pipelined = pipeline_.IsRunning();
+    pipeline_.Stop();
     UnloadResources();
     LoadResources();
+    if (pipelined) {
+      StartPipeline();
+    }
   }
 }
 
 // Tear down the EGL context currently associated with the display.
 void Engine::TermDisplay() {
+  pipeline_.Stop();
   gl_context_->Suspend();
 }
 
@@ -341,6 +419,8 @@ void Engine::TrimMemory() {
 int32_t Engine::HandleInput(android_app *app, AInputEvent *event) {
   Engine *eng = reinterpret_cast<Engine*>(app->userData);
   if (AInputEvent_getType(event) == AINPUT_EVENT_TYPE_MOTION) {
+    // The pipeline's worker may be updating the camera
+    std::lock_guard<std::mutex> lock(eng->camera_mutex_);
     ndk_helper::GESTURE_STATE double_tap_state =
         eng->doubletap_detector_.Detect(event);
     ndk_helper::GESTURE_STATE drag_state = eng->drag_detector_.Detect(event);